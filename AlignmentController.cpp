@@ -2,21 +2,76 @@
 #include "AlignmentController.h"
 #include "UserInterface.h"
 #include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <unistd.h> // for usleep
 
+namespace {
+
+// 遥测 200Hz 左右；连续几个周期没有新数据即认为遥测中断，退回推算的云台转速
+constexpr double TELEMETRY_STALE_MS = 50.0;
+
+double steadyNowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double timespecDiffUs(const timespec& a, const timespec& b) {
+    return (a.tv_sec - b.tv_sec) * 1e6 + (a.tv_nsec - b.tv_nsec) / 1e3;
+}
+
+void addNanoseconds(timespec& t, long ns) {
+    t.tv_nsec += ns;
+    while (t.tv_nsec >= 1000000000L) {
+        t.tv_nsec -= 1000000000L;
+        t.tv_sec++;
+    }
+}
+
+} // namespace
+
+cv::Point2f TargetSnapshot::predict(double timestamp_ms) const {
+    double horizon = std::max(0.0, std::min(timestamp_ms, horizon_end_ms) - state_time_ms);
+    return cv::Point2f(center.x + velocity.x * static_cast<float>(horizon),
+                       center.y + velocity.y * static_cast<float>(horizon));
+}
+
 AlignmentController::AlignmentController() 
     : auto_align_enabled_(false),
       alignment_threshold_(5.0f),
-      alignment_kp_(0.3f),
       current_pixel_error_(0.0f),
       is_aligned_(false),
       alignment_frame_count_(0),
-      last_motor_data_(0) {
+      last_motor_data_(0),
+      angle_mode_(true),
+      current_angle_error_(0.0f),
+      continuous_control_(false),
+      last_pid_time_ms_(0.0),
+      target_velocity_px_(0.0f, 0.0f),
+      warned_disconnected_(false),
+      clock_ms_(steadyNowMs),
+      last_telemetry_mcu_ms_(0),
+      last_telemetry_change_ms_(-1.0),
+      serial_baud_(115200),
+      has_hit_inputs_(false),
+      fire_permitted_(false),
+      control_running_(false),
+      control_stop_sent_(false),
+      control_align_enabled_(false),
+      count_alignment_frame_(true),
+      counted_detection_ms_(-1.0) {
     camera_offset_pixels_ = 0.0f;
+    alignment_threshold_rad_ = MotorController::defaultAngularSpeedBands().thresholds[0];
 }
 
 AlignmentController::~AlignmentController() {
+    stopControlThread();
     motor_controller_.disconnect();
 }
 
@@ -29,8 +84,11 @@ void AlignmentController::performAlignment(const cv::Point2f& circle_center, int
     current_pixel_error_ = (circle_center.x - image_center_x);
     
     // 判断是否已经对准（考虑死区）
-    if (fabs(current_pixel_error_) <= alignment_threshold_) {
-        alignment_frame_count_++;
+    const float threshold = alignment_threshold_;
+    if (fabs(current_pixel_error_) <= threshold) {
+        if (count_alignment_frame_) {
+            alignment_frame_count_++;
+        }
         
         // 连续多帧对准才认为真正对准（去抖动）
         if (alignment_frame_count_ >= 5) {
@@ -40,7 +98,7 @@ void AlignmentController::performAlignment(const cv::Point2f& circle_center, int
                 motor_controller_.stop();
                 last_motor_data_ = 0;
                 std::cout << "✓ 已对准！像素误差: " << current_pixel_error_ 
-                          << "px (阈值: " << alignment_threshold_ << "px)" << std::endl;
+                          << "px (阈值: " << threshold << "px)" << std::endl;
             }
         }
         return;
@@ -49,33 +107,469 @@ void AlignmentController::performAlignment(const cv::Point2f& circle_center, int
         is_aligned_ = false;
     }
     
-    // 检查串口连接状态
+    if (!checkConnected()) {
+        return;
+    }
+    
+    // 计算控制信号（直接使用像素误差，不限制范围），由电机控制器按像素分档
+    motor_controller_.sendData(current_pixel_error_);
+    last_motor_data_ = motor_controller_.getLastDataValue();
+}
+
+void AlignmentController::performAlignment(const cv::Point2f& circle_center, const cv::Size& frame_size) {
+    if (!isAngleMode()) {
+        // 像素模式没有内参，无法换算命中概率，发射许可退回连续帧对准
+        has_hit_inputs_ = false;
+        {
+            std::lock_guard<std::mutex> lock(hit_mutex_);
+            last_hit_ = HitEstimate();
+        }
+        performAlignment(circle_center, frame_size.width);
+        return;
+    }
+    
+    float focal_px = 0.0f;
+    current_angle_error_ = pixelToAngle(circle_center, frame_size, focal_px);
+    // 像素误差只用于界面显示：按当前分辨率下的等效焦距换算
+    current_pixel_error_ = std::tan(current_angle_error_) * focal_px;
+    
+    // 与电机分档一致：相对期望方向（目标偏置）的误差
+    float control_error = current_angle_error_ - motor_controller_.getAngularSpeedBands().target_offset;
+    updateFirePermission(control_error, focal_px);
+    
+    // 界面线程可能随时修改配置，本周期只读取一次
+    const bool continuous = continuous_control_;
+    const float threshold_rad = alignment_threshold_rad_;
+    if (std::fabs(control_error) <= threshold_rad) {
+        if (count_alignment_frame_) {
+            alignment_frame_count_++;
+        }
+        
+        // 运动控制：连续多帧在死区内才认为真正对准（去抖动）并停止；
+        // 命中概率只决定发射许可，概率不足时电机同样要停在死区内
+        if (alignment_frame_count_ >= 5 && !is_aligned_) {
+            HitEstimate hit = getHitEstimate();
+            is_aligned_ = true;
+            if (!continuous) {
+                motor_controller_.stop();
+                last_motor_data_ = 0;
+            }
+            std::cout << "✓ 已对准！角度误差: " << control_error * 1000.0f
+                      << "mrad (阈值: " << threshold_rad * 1000.0f << "mrad)";
+            if (hit.valid) {
+                std::cout << ", 命中概率 " << hit.probability * 100.0f << "%";
+            }
+            std::cout << std::endl;
+        }
+        // 分档控制在死区内停止；连续控制继续闭环，由积分项消除残余误差并跟随运动目标
+        if (!continuous) {
+            return;
+        }
+    } else {
+        alignment_frame_count_ = 0;
+        is_aligned_ = false;
+    }
+    
+    if (!checkConnected()) {
+        return;
+    }
+    if (!continuous) {
+        motor_controller_.sendAngularError(current_angle_error_);
+        last_motor_data_ = motor_controller_.getLastDataValue();
+        return;
+    }
+    
+    // 目标相对相机的角速度：像素速度按等效焦距换算，像素/ms -> 弧度/秒
+    float relative_rate = target_velocity_px_.x * 1000.0f / focal_px;
+    MotorTelemetry telemetry;
+    bool has_telemetry = motor_controller_.getTelemetry(telemetry);
+    float rate, max_rate;
+    {
+        std::lock_guard<std::mutex> lock(pid_mutex_);
+        double now_ms = clock_ms_();
+        float dt = last_pid_time_ms_ > 0.0 ? static_cast<float>((now_ms - last_pid_time_ms_) * 1e-3) : 0.0f;
+        last_pid_time_ms_ = now_ms;
+        // 长时间未更新（视觉停顿、刚启用）时不把间隔计入积分
+        if (dt > 0.1f) dt = 0.0f;
+        if (has_telemetry && (last_telemetry_change_ms_ < 0.0 || telemetry.mcu_time_ms != last_telemetry_mcu_ms_)) {
+            last_telemetry_mcu_ms_ = telemetry.mcu_time_ms;
+            last_telemetry_change_ms_ = now_ms;
+        }
+        bool fresh = has_telemetry && now_ms - last_telemetry_change_ms_ <= TELEMETRY_STALE_MS;
+        rate = fresh ? pid_.update(control_error, relative_rate, dt, static_cast<float>(telemetry.velocity))
+                     : pid_.update(control_error, relative_rate, dt);
+        max_rate = pid_.getGains().max_rate;
+    }
+    motor_controller_.sendSpeedCommand(rate / max_rate);
+    last_motor_data_ = motor_controller_.getLastDataValue();
+}
+
+bool AlignmentController::checkConnected() {
     if (!motor_controller_.isConnected()) {
-        std::cout << "警告: 串口未连接，无法发送控制指令" << std::endl;
+        if (!warned_disconnected_) {
+            std::cout << "警告: 串口未连接，无法发送控制指令" << std::endl;
+            warned_disconnected_ = true;
+        }
+        return false;
+    }
+    if (warned_disconnected_) {
+        // 断开期间 PID 未更新，恢复后从零开始积分与计时；下位机已在重连时收到停止指令
+        std::cout << "串口已恢复，继续发送控制指令" << std::endl;
+        resetPid();
+        warned_disconnected_ = false;
+    }
+    return true;
+}
+
+void AlignmentController::setContinuousControl(bool enabled) {
+    continuous_control_ = enabled;
+    resetPid();
+}
+
+void AlignmentController::setPidGains(const PidGains& gains) {
+    std::lock_guard<std::mutex> lock(pid_mutex_);
+    pid_.setGains(gains);
+    std::cout << "PID 参数: kp=" << gains.kp << " ki=" << gains.ki << " kd=" << gains.kd
+              << " kff=" << gains.kff << " 限幅 " << gains.max_rate * 1000.0f << "mrad/s" << std::endl;
+}
+
+PidGains AlignmentController::getPidGains() const {
+    std::lock_guard<std::mutex> lock(pid_mutex_);
+    return pid_.getGains();
+}
+
+void AlignmentController::resetPid() {
+    std::lock_guard<std::mutex> lock(pid_mutex_);
+    pid_.reset();
+    last_pid_time_ms_ = 0.0;
+    last_telemetry_change_ms_ = -1.0;
+}
+
+float AlignmentController::pixelToAngle(const cv::Point2f& pixel, const cv::Size& frame_size, float& focal_px) {
+    // 帧像素 -> 标定分辨率下的传感器像素：ROI 偏移 + 像素合并
+    float scale = sensor_mode_.scale(frame_size, calibration_size_);
+    if (sensor_mode_.binning <= 0) {
+        if (frame_size != calibration_size_ && frame_size != warned_size_) {
+            warned_size_ = frame_size;
+            float scale_y = static_cast<float>(calibration_size_.height) / frame_size.height;
+            std::cout << "[对准] 帧尺寸 " << frame_size.width << "x" << frame_size.height << " 与标定尺寸 "
+                      << calibration_size_.width << "x" << calibration_size_.height << " 不同，按 " << scale
+                      << " 倍缩放换算内参" << std::endl;
+            if (std::fabs(scale_y - scale) > 1e-3f) {
+                std::cout << "[对准] 警告: 宽高缩放比不一致，可能使用了 ROI，请在 alignment.yml 中设置 roi_offset 和 binning"
+                          << std::endl;
+            }
+        }
+    }
+    std::vector<cv::Point2f> src(1, sensor_mode_.toCalibration(pixel, scale)), dst;
+    cv::undistortPoints(src, dst, camera_matrix_, dist_coeffs_);
+    focal_px = static_cast<float>(camera_matrix_.at<double>(0, 0)) / scale;
+    return std::atan(dst[0].x);
+}
+
+void AlignmentController::updateFirePermission(float aim_error, float focal_px) {
+    bool was_permitted = fire_permitted_;
+    HitEstimate hit;
+    bool permitted = false;
+    if (has_hit_inputs_) {
+        HitInputs inputs = pending_hit_inputs_;
+        inputs.aim_error_h = aim_error;
+        inputs.focal_px = focal_px;
+        has_hit_inputs_ = false;
+        hit = hit_estimator_.estimate(inputs);
+        const HitModelConfig& config = hit_estimator_.getConfig();
+        float threshold = was_permitted ? config.release_threshold : config.fire_threshold;
+        permitted = hit.valid && hit.probability >= threshold;
+    }
+    // 本帧没有距离/射击诸元（丢检外推、超出射程等）：不给许可
+    {
+        std::lock_guard<std::mutex> lock(hit_mutex_);
+        last_hit_ = hit;
+    }
+    fire_permitted_ = permitted;
+    
+    if (permitted != was_permitted) {
+        if (permitted) {
+            std::cout << "发射许可: 命中概率 " << hit.probability * 100.0f << "% (脱靶 σ "
+                      << hit.sigma_h * 1000.0f << "/" << hit.sigma_v * 1000.0f << "mm)" << std::endl;
+        } else {
+            std::cout << "发射许可撤销: 命中概率 " << (hit.valid ? hit.probability : 0.0f) * 100.0f << "%" << std::endl;
+        }
+    }
+}
+
+bool AlignmentController::loadHitModel(const std::string& file_name) {
+    return hit_estimator_.loadConfig(file_name);
+}
+
+void AlignmentController::setHitContext(const HitInputs& inputs) {
+    pending_hit_inputs_ = inputs;
+    has_hit_inputs_ = true;
+}
+
+HitEstimate AlignmentController::getHitEstimate() const {
+    std::lock_guard<std::mutex> lock(hit_mutex_);
+    return last_hit_;
+}
+
+float AlignmentController::getHitProbability() const {
+    std::lock_guard<std::mutex> lock(hit_mutex_);
+    return last_hit_.valid ? last_hit_.probability : 0.0f;
+}
+
+bool AlignmentController::isFirePermitted() const {
+    std::lock_guard<std::mutex> lock(hit_mutex_);
+    return last_hit_.valid ? fire_permitted_.load() : is_aligned_.load();
+}
+
+bool AlignmentController::startControlThread(double rate_hz, int priority) {
+    if (control_running_) {
+        return true;
+    }
+    if (rate_hz <= 0.0 || rate_hz > 2000.0) {
+        std::cerr << "控制线程频率无效: " << rate_hz << "Hz" << std::endl;
+        return false;
+    }
+    control_stop_sent_ = false;
+    control_align_enabled_ = false;
+    counted_detection_ms_ = -1.0;
+    control_running_ = true;
+    // 每周期都会下发指令，逐条打印会让终端输出成为控制周期的瓶颈
+    motor_controller_.setCommandLogging(false);
+    control_thread_ = std::thread(&AlignmentController::controlLoop, this, rate_hz, priority);
+    return true;
+}
+
+void AlignmentController::stopControlThread() {
+    if (!control_thread_.joinable()) {
+        return;
+    }
+    control_running_ = false;
+    control_thread_.join();
+    // 控制线程退出前未来得及处理的禁用
+    if (control_align_enabled_ && !auto_align_enabled_) {
+        disableAlignment();
+    }
+    control_align_enabled_ = false;
+    count_alignment_frame_ = true;
+    motor_controller_.setCommandLogging(true);
+    ControlLoopStats stats = getControlStats();
+    std::cout << "控制线程已停止: " << stats.ticks << " 个周期, 超时 " << stats.overruns << " 次" << std::endl;
+}
+
+void AlignmentController::publishTarget(const TargetSnapshot& snapshot) {
+    target_mailbox_.publish(snapshot);
+}
+
+ControlLoopStats AlignmentController::getControlStats() const {
+    stats_mailbox_.fetch(control_stats_);
+    ControlLoopStats stats = control_stats_;
+    stats.running = control_running_;
+    return stats;
+}
+
+void AlignmentController::controlLoop(double rate_hz, int priority) {
+    // SCHED_FIFO 需要 CAP_SYS_NICE（或 root / rtprio 限额），失败时保持普通调度
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = std::max(sched_get_priority_min(SCHED_FIFO),
+                                    std::min(priority, sched_get_priority_max(SCHED_FIFO)));
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    bool realtime = err == 0;
+    if (realtime) {
+        std::cout << "控制线程: " << rate_hz << "Hz, SCHED_FIFO 优先级 " << param.sched_priority << std::endl;
+    } else {
+        std::cout << "控制线程: " << rate_hz << "Hz, 无法设置 SCHED_FIFO (" << std::strerror(err)
+                  << ")，以普通优先级运行" << std::endl;
+    }
+    
+    const long period_ns = static_cast<long>(1e9 / rate_hz);
+    const int window = std::max(1, static_cast<int>(rate_hz));   // 每秒发布一次统计
+    std::vector<double> jitter_us;
+    jitter_us.reserve(window);
+    double step_sum_us = 0.0, step_max_us = 0.0;
+    ControlLoopStats stats;
+    stats.running = true;
+    stats.realtime = realtime;
+    stats.rate_hz = rate_hz;
+    
+    TargetSnapshot snapshot;
+    bool has_snapshot = false;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    while (control_running_) {
+        // 绝对时间睡眠：周期不随计算耗时漂移
+        addNanoseconds(next, period_ns);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {
+        }
+        timespec woke;
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        double late_us = timespecDiffUs(woke, next);
+        if (late_us > period_ns / 1e3) {
+            // 错过了整个周期：从当前时刻重新对齐，不补发积压的周期
+            stats.overruns++;
+            next = woke;
+        }
+        
+        if (target_mailbox_.fetch(snapshot)) {
+            has_snapshot = true;
+        }
+        controlStep(snapshot, has_snapshot, steadyNowMs());
+        
+        timespec done;
+        clock_gettime(CLOCK_MONOTONIC, &done);
+        double step_us = timespecDiffUs(done, woke);
+        step_sum_us += step_us;
+        step_max_us = std::max(step_max_us, step_us);
+        jitter_us.push_back(std::max(0.0, late_us));
+        stats.ticks++;
+        
+        if (static_cast<int>(jitter_us.size()) >= window) {
+            stats.window_samples = static_cast<int>(jitter_us.size());
+            double sum = 0.0;
+            for (double j : jitter_us) sum += j;
+            stats.mean_jitter_us = sum / jitter_us.size();
+            stats.max_jitter_us = *std::max_element(jitter_us.begin(), jitter_us.end());
+            size_t p99 = std::min(jitter_us.size() - 1, static_cast<size_t>(jitter_us.size() * 0.99));
+            std::nth_element(jitter_us.begin(), jitter_us.begin() + p99, jitter_us.end());
+            stats.p99_jitter_us = jitter_us[p99];
+            stats.mean_step_us = step_sum_us / stats.window_samples;
+            stats.max_step_us = step_max_us;
+            stats_mailbox_.publish(stats);
+            jitter_us.clear();
+            step_sum_us = 0.0;
+            step_max_us = 0.0;
+        }
+    }
+    stats.running = false;
+    stats_mailbox_.publish(stats);
+}
+
+void AlignmentController::controlStep(const TargetSnapshot& snapshot, bool has_snapshot, double now_ms) {
+    if (!auto_align_enabled_) {
+        if (control_align_enabled_) {
+            // 禁用边沿：本线程发出停止，之后不再有运动指令
+            control_align_enabled_ = false;
+            disableAlignment();
+        }
         return;
     }
+    control_align_enabled_ = true;
+    if (!has_snapshot || !snapshot.valid || now_ms > snapshot.stale_after_ms) {
+        // 目标丢失或视觉线程停止投递：停止电机，只发送一次
+        if (!control_stop_sent_) {
+            stop();
+            control_stop_sent_ = true;
+        }
+        return;
+    }
+    control_stop_sent_ = false;
     
-    // 计算控制信号（直接使用像素误差，不限制范围）
-    float control_signal = current_pixel_error_;
-    
-    // 发送控制信号给电机控制器
-    motor_controller_.sendData(control_signal);
-    
-    // 记录最后发送的数据（根据像素误差计算）
-    float abs_error = fabs(control_signal);
-    if (abs_error < 50.0f) {
-        last_motor_data_ = 0;
-    } else if (abs_error < 100.0f) {
-        last_motor_data_ = (control_signal > 0) ? 1 : -1;
-    } else if (abs_error < 150.0f) {
-        last_motor_data_ = (control_signal > 0) ? 2 : -2;
-    } else if (abs_error < 200.0f) {
-        last_motor_data_ = (control_signal > 0) ? 3 : -3;
-    } else if (abs_error < 250.0f) {
-        last_motor_data_ = (control_signal > 0) ? 4 : -4;
+    // 外推到本周期指令的预计生效时刻
+    cv::Point2f center = snapshot.predict(now_ms + snapshot.actuation_delay_ms);
+    if (snapshot.has_hit_inputs) {
+        setHitContext(snapshot.hit_inputs);
+    }
+    setTargetVelocity(snapshot.velocity);
+    count_alignment_frame_ = snapshot.last_detection_ms != counted_detection_ms_;
+    counted_detection_ms_ = snapshot.last_detection_ms;
+    performAlignment(center, snapshot.frame_size);
+}
+
+bool AlignmentController::loadCalibration(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开标定参数文件: " << file_name << std::endl;
+        return false;
+    }
+    cv::Mat camera_matrix, dist_coeffs;
+    fs["cameraMatrix"] >> camera_matrix;
+    fs["distCoeffs"] >> dist_coeffs;
+    if (camera_matrix.empty()) {
+        std::cerr << "标定参数文件中没有相机矩阵: " << file_name << std::endl;
+        return false;
+    }
+    setIntrinsics(camera_matrix, dist_coeffs, readCalibrationSize(fs, camera_matrix));
+    return true;
+}
+
+void AlignmentController::setIntrinsics(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs,
+                                        const cv::Size& calibration_size) {
+    camera_matrix.convertTo(camera_matrix_, CV_64F);
+    if (dist_coeffs.empty()) {
+        dist_coeffs_ = cv::Mat::zeros(5, 1, CV_64F);
     } else {
-        last_motor_data_ = (control_signal > 0) ? 5 : -5;
+        dist_coeffs.convertTo(dist_coeffs_, CV_64F);
     }
+    calibration_size_ = calibration_size;
+    warned_size_ = cv::Size();
+    std::cout << "对准控制使用标定内参: fx=" << camera_matrix_.at<double>(0, 0) << "px, 标定尺寸 "
+              << calibration_size_.width << "x" << calibration_size_.height
+              << (angle_mode_ ? " (角度误差模式)" : " (像素模式)") << std::endl;
+}
+
+bool AlignmentController::loadAngleConfig(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开对准配置文件: " << file_name << std::endl;
+        return false;
+    }
+    
+    // 文件中的角度单位为毫弧度
+    AngularSpeedBands bands = motor_controller_.getAngularSpeedBands();
+    if (!fs["angle_mode"].empty()) angle_mode_ = static_cast<int>(fs["angle_mode"]) != 0;
+    if (!fs["target_offset_mrad"].empty()) bands.target_offset = static_cast<float>(fs["target_offset_mrad"]) * 1e-3f;
+    if (!fs["alignment_threshold_mrad"].empty()) {
+        alignment_threshold_rad_ = static_cast<float>(fs["alignment_threshold_mrad"]) * 1e-3f;
+    }
+    cv::FileNode thresholds = fs["speed_thresholds_mrad"];
+    if (!thresholds.empty()) {
+        if (!thresholds.isSeq() || thresholds.size() != 5) {
+            std::cerr << "speed_thresholds_mrad 需要 5 个递增的阈值: " << file_name << std::endl;
+            return false;
+        }
+        for (int i = 0; i < 5; ++i) {
+            bands.thresholds[i] = static_cast<float>(thresholds[i]) * 1e-3f;
+            if (i > 0 && bands.thresholds[i] <= bands.thresholds[i - 1]) {
+                std::cerr << "speed_thresholds_mrad 必须递增: " << file_name << std::endl;
+                return false;
+            }
+        }
+    }
+    cv::FileNode roi = fs["roi_offset"];
+    if (roi.isSeq() && roi.size() == 2) {
+        sensor_mode_.roi_offset = cv::Point2f(static_cast<float>(roi[0]), static_cast<float>(roi[1]));
+    }
+    if (!fs["binning"].empty()) sensor_mode_.binning = std::max(0, static_cast<int>(fs["binning"]));
+    
+    cv::FileNode pid = fs["pid"];
+    if (!pid.empty()) {
+        PidGains gains = getPidGains();
+        if (!PidController::readGains(pid, gains)) {
+            std::cerr << "pid 参数无效: " << file_name << std::endl;
+            return false;
+        }
+        setPidGains(gains);
+    }
+    if (!fs["continuous_control"].empty()) {
+        setContinuousControl(static_cast<int>(fs["continuous_control"]) != 0);
+    }
+    
+    motor_controller_.setAngularSpeedBands(bands);
+    std::cout << "已加载对准配置: " << file_name << " (目标偏置 " << bands.target_offset * 1000.0f
+              << "mrad, 死区 " << bands.thresholds[0] * 1000.0f << "mrad, "
+              << (continuous_control_ ? "PID 连续速度控制" : "5 档速度分档") << ")" << std::endl;
+    return true;
+}
+
+void AlignmentController::setSensorMode(const SensorMode& mode) {
+    sensor_mode_ = mode;
+    sensor_mode_.binning = std::max(0, mode.binning);
+}
+
+void AlignmentController::setAngleMode(bool enabled) {
+    angle_mode_ = enabled;
 }
 
 void AlignmentController::toggleAutoAlign() {
@@ -83,8 +577,17 @@ void AlignmentController::toggleAutoAlign() {
     
     if (auto_align_enabled_) {
         std::cout << "自动对准已启用" << std::endl;
-        std::cout << "对准阈值: " << alignment_threshold_ << "px" << std::endl;
-        std::cout << "比例系数: " << alignment_kp_ << std::endl;
+        if (isAngleMode()) {
+            std::cout << "对准阈值: " << getAngleAlignmentThreshold() << "mrad" << std::endl;
+        } else {
+            std::cout << "对准阈值: " << alignment_threshold_ << "px" << std::endl;
+        }
+        if (isContinuousControl()) {
+            PidGains gains = getPidGains();
+            std::cout << "PID: kp=" << gains.kp << " ki=" << gains.ki << " kd=" << gains.kd
+                      << " kff=" << gains.kff << std::endl;
+        }
+        resetPid();
         
         // 检查串口连接
         if (!motor_controller_.isConnected()) {
@@ -92,13 +595,19 @@ void AlignmentController::toggleAutoAlign() {
         }
     } else {
         std::cout << "自动对准已禁用" << std::endl;
-        motor_controller_.stop();
-        is_aligned_ = false;
-        alignment_frame_count_ = 0;
-        last_motor_data_ = 0;
+        if (!control_running_) {
+            disableAlignment();
+        }
     }
 }
 
+void AlignmentController::disableAlignment() {
+    motor_controller_.stop();
+    is_aligned_ = false;
+    alignment_frame_count_ = 0;
+    last_motor_data_ = 0;
+}
+
 void AlignmentController::setAlignmentThreshold(float threshold) {
     if (threshold >= 1.0f && threshold <= 20.0f) {
         alignment_threshold_ = threshold;
@@ -108,6 +617,15 @@ void AlignmentController::setAlignmentThreshold(float threshold) {
     }
 }
 
+void AlignmentController::setAngleAlignmentThreshold(float threshold_mrad) {
+    if (threshold_mrad >= 0.1f && threshold_mrad <= 20.0f) {
+        alignment_threshold_rad_ = threshold_mrad * 1e-3f;
+        std::cout << "对准阈值已设置为: " << threshold_mrad << "mrad" << std::endl;
+    } else {
+        std::cout << "阈值超出范围，保持原值: " << getAngleAlignmentThreshold() << "mrad" << std::endl;
+    }
+}
+
 bool AlignmentController::setSerialPort(const std::string& port_name) {
     std::cout << "正在连接串口设备: " << port_name << "..." << std::endl;
     
@@ -115,7 +633,7 @@ bool AlignmentController::setSerialPort(const std::string& port_name) {
     motor_controller_.disconnect();
     
     // 尝试新连接
-    if (motor_controller_.connect(port_name)) {
+    if (motor_controller_.connect(port_name, serial_baud_)) {
         std::cout << "串口设备连接成功: " << port_name << std::endl;
         return true;
     } else {
@@ -131,10 +649,73 @@ void AlignmentController::printAlignmentStatus() const {
     std::cout << "当前对准: " << (is_aligned_ ? "已对准" : "未对准") << std::endl;
     std::cout << "像素误差: " << current_pixel_error_ << "px" << std::endl;
     std::cout << "对准阈值: " << alignment_threshold_ << "px" << std::endl;
+    if (isAngleMode()) {
+        std::cout << "角度误差: " << current_angle_error_ * 1000.0f << "mrad (阈值 "
+                  << alignment_threshold_rad_ * 1000.0f << "mrad)" << std::endl;
+    }
+    HitEstimate hit = getHitEstimate();
+    if (hit.valid) {
+        std::cout << "命中概率: " << hit.probability * 100.0f << "% (发射许可: "
+                  << (fire_permitted_ ? "是" : "否") << ")" << std::endl;
+    }
+    if (control_running_) {
+        ControlLoopStats stats = getControlStats();
+        std::cout << "控制线程: " << stats.rate_hz << "Hz" << (stats.realtime ? " (SCHED_FIFO)" : "")
+                  << ", 抖动 均值/p99/最大 " << stats.mean_jitter_us << "/" << stats.p99_jitter_us << "/"
+                  << stats.max_jitter_us << "us, 单步 " << stats.mean_step_us << "us, 超时 "
+                  << stats.overruns << "/" << stats.ticks << std::endl;
+    }
+    if (isContinuousControl()) {
+        PidGains gains = getPidGains();
+        std::cout << "PID: kp=" << gains.kp << " ki=" << gains.ki << " kd=" << gains.kd << " kff=" << gains.kff
+                  << ", 速度指令 " << motor_controller_.getLastSpeedCommand() * 100.0f << "%" << std::endl;
+    }
     std::cout << "电机状态: " << getMotorStateString() << std::endl;
     std::cout << "电机数据: " << static_cast<int>(last_motor_data_) << " (-5到5)" << std::endl;
     std::cout << "串口连接: " << (motor_controller_.isConnected() ? "已连接" : "未连接") << std::endl;
     std::cout << "串口设备: " << motor_controller_.getPortName() << std::endl;
+    SerialWriteStats serial = motor_controller_.getSerialStats();
+    if (serial.enqueued > 0) {
+        std::cout << "串口发送: " << serial.written << "/" << serial.enqueued << " 帧 (合并 " << serial.coalesced
+                  << ", 失败 " << serial.errors << "), 延迟 最近/均值/最大 " << serial.last_latency_ms << "/"
+                  << serial.mean_latency_ms << "/" << serial.max_latency_ms << "ms" << std::endl;
+        if (serial.acked > 0 || serial.ack_lost > 0) {
+            std::cout << "指令确认: " << serial.acked << " (丢失 " << serial.ack_lost << ", 重发 " << serial.retransmits
+                      << "), 往返 最近/均值 " << serial.last_rtt_ms << "/" << serial.mean_rtt_ms << "ms" << std::endl;
+        }
+        if (serial.errors > 0) {
+            std::cout << "最近错误: " << serial.last_error << std::endl;
+        }
+        CommandStats commands = motor_controller_.getCommandStats();
+        if (commands.requested > 0) {
+            std::cout << "指令调度: 提交 " << commands.requested << ", 发送 " << commands.sent << " (保活 "
+                      << commands.keepalives << "), 去重 " << commands.deduplicated << std::endl;
+        }
+        SerialLinkStats link = motor_controller_.getLinkStats();
+        if (link.disconnects > 0) {
+            std::cout << "串口断开: " << link.disconnects << " 次, 重连 " << link.reconnects << " 次, 中断 最近/最大 "
+                      << link.last_outage_ms << "/" << link.max_outage_ms << "ms, 断开期间丢弃 "
+                      << link.dropped_commands << " 条指令 (" << link.last_error << ")" << std::endl;
+        }
+        SerialTuningReport tuning = motor_controller_.getTuningReport();
+        if (tuning.actual_baud > 0) {
+            std::cout << "串口线路: " << tuning.actual_baud << " bps" << (tuning.custom_baud ? " (termios2)" : "")
+                      << ", ASYNC_LOW_LATENCY " << (tuning.async_low_latency ? "开" : "关");
+            if (tuning.latency_timer_ms >= 0) {
+                std::cout << ", latency_timer " << tuning.latency_timer_ms << "ms";
+            }
+            std::cout << std::endl;
+        }
+    }
+    MotorTelemetry telemetry;
+    if (motor_controller_.getTelemetry(telemetry)) {
+        SerialReceiveStats received = motor_controller_.getReceiveStats();
+        std::cout << "转台遥测: 角度 " << telemetry.position * 1000.0 << "mrad, 角速度 " << telemetry.velocity * 1000.0
+                  << "mrad/s" << ((telemetry.flags & TELEMETRY_FAULT) ? " [驱动器故障]" : "")
+                  << ((telemetry.flags & TELEMETRY_LIMIT) ? " [限位]" : "")
+                  << ((telemetry.flags & TELEMETRY_WATCHDOG) ? " [看门狗停止]" : "") << ", 接收 " << received.frames
+                  << " 帧 (无效 " << received.invalid_frames << ", 丢弃 " << received.dropped_bytes << " 字节)" << std::endl;
+    }
     std::cout << "================\n" << std::endl;
 }
 
@@ -154,6 +735,10 @@ float AlignmentController::getAlignmentThreshold() const {
     return alignment_threshold_;
 }
 
+float AlignmentController::getAngleAlignmentThreshold() const {
+    return alignment_threshold_rad_ * 1000.0f;
+}
+
 std::string AlignmentController::getMotorStateString() const {
     return motor_controller_.getStateString();
 }
@@ -170,16 +755,25 @@ std::string AlignmentController::getPortName() const {
     return motor_controller_.getPortName();
 }
 
+double AlignmentController::getLastCommandLatencyMs() const {
+    return motor_controller_.getLastWriteDurationMs();
+}
+
 void AlignmentController::stop() {
     motor_controller_.stop();
+    resetPid();
+    fire_permitted_ = false;
+    has_hit_inputs_ = false;
+    std::lock_guard<std::mutex> lock(hit_mutex_);
+    last_hit_ = HitEstimate();
 }
 
 void AlignmentController::resetAlignment() {
     auto_align_enabled_ = false;
-    is_aligned_ = false;
-    alignment_frame_count_ = 0;
-    last_motor_data_ = 0;
-    motor_controller_.stop();
+    if (!control_running_) {
+        disableAlignment();
+    }
+    resetPid();
 }
 
 bool AlignmentController::connectMotorController() {
@@ -191,7 +785,7 @@ bool AlignmentController::connectMotorController() {
     
     for (const char* port : possible_ports) {
         std::cout << "尝试连接串口: " << port << std::endl;
-        if (motor_controller_.connect(port)) {
+        if (motor_controller_.connect(port, serial_baud_)) {
             connected = true;
             break;
         }
@@ -207,6 +801,60 @@ bool AlignmentController::connectMotorController() {
     return true;
 }
 
+bool AlignmentController::connectSimulated(const SerialPort::WriteSink& sink, const std::function<double()>& clock_ms) {
+    motor_controller_.disconnect();
+    clock_ms_ = clock_ms ? clock_ms : std::function<double()>(steadyNowMs);
+    // 保活也按仿真时钟计时，否则快于实时的仿真会触发下位机看门狗
+    if (!motor_controller_.connectSimulated(sink, clock_ms_)) {
+        return false;
+    }
+    motor_controller_.setCommandLogging(false);
+    resetPid();
+    return true;
+}
+
+void AlignmentController::receiveSimulated(const uint8_t* data, size_t size) {
+    motor_controller_.receiveSimulated(data, size);
+}
+
+bool AlignmentController::setSerialProtocol(int version) {
+    if (!motor_controller_.setProtocolVersion(version)) {
+        return false;
+    }
+    std::cout << "串口协议: v" << version << (version == 2 ? " (ACK + 遥测)" : "") << std::endl;
+    return true;
+}
+
+void AlignmentController::setSerialBaudRate(int baud_rate) {
+    serial_baud_ = baud_rate;
+}
+
+void AlignmentController::setCommandSchedule(const CommandSchedule& schedule) {
+    motor_controller_.setCommandSchedule(schedule);
+    std::cout << "指令调度: " << (schedule.deduplicate ? "去重" : "逐帧发送") << ", 保活 " << schedule.keepalive_ms
+              << "ms, 下位机看门狗 " << (schedule.mcu_watchdog_ms > 0 ? std::to_string(schedule.mcu_watchdog_ms) + "ms" : "关闭")
+              << std::endl;
+}
+
+void AlignmentController::setSerialFrameLogging(bool enabled) {
+    motor_controller_.setFrameLogging(enabled);
+}
+
+void AlignmentController::setSerialAutoReconnect(bool enabled) {
+    motor_controller_.setAutoReconnect(enabled);
+}
+
+void AlignmentController::setSerialLatencyProfile(const SerialLatencyProfile& profile) {
+    motor_controller_.setLatencyProfile(profile);
+    if (profile.low_latency) {
+        std::cout << "串口低延迟模式: ASYNC_LOW_LATENCY, latency_timer " << profile.usb_latency_timer_ms << "ms";
+        if (profile.rt_priority > 0) {
+            std::cout << ", 收发线程 SCHED_FIFO " << profile.rt_priority;
+        }
+        std::cout << std::endl;
+    }
+}
+
 // 设置摄像头相对中轴线的像素水平偏移
 void AlignmentController::setCameraOffsetPixels(float px) {
     camera_offset_pixels_ = px;
@@ -2,34 +2,174 @@
 #define ALIGNMENTCONTROLLER_H
 
 #include "MotorController.h"
+#include "HitProbability.h"
+#include "PidController.h"
+#include "Mailbox.h"
+#include "SensorMode.h"
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+
+// 视觉线程投递给控制线程的目标估计（时间为 steady_clock 毫秒）
+struct TargetSnapshot {
+    bool valid = false;              // 是否有可用于控制的目标
+    cv::Point2f center;              // state_time_ms 时刻的目标中心（像素）
+    cv::Point2f velocity;            // 像素/ms，无跟踪器时为 0
+    double state_time_ms = 0.0;
+    double last_detection_ms = 0.0;
+    double stale_after_ms = 0.0;     // 超过该时刻仍无新检测视为目标丢失
+    double horizon_end_ms = 0.0;     // 外推的截止时刻
+    double actuation_delay_ms = 0.0; // 指令发出到电机响应的延迟，控制线程外推到 now + 该值
+    cv::Size frame_size;
+    bool has_hit_inputs = false;
+    HitInputs hit_inputs;
+
+    cv::Point2f predict(double timestamp_ms) const;
+};
+
+// 控制线程的周期抖动统计（最近一个统计窗口）
+struct ControlLoopStats {
+    bool running = false;
+    bool realtime = false;           // 是否获得 SCHED_FIFO
+    double rate_hz = 0.0;
+    unsigned long ticks = 0;         // 累计周期数
+    unsigned long overruns = 0;      // 累计超过一个周期才被唤醒的次数
+    int window_samples = 0;
+    double mean_jitter_us = 0.0;     // 唤醒时刻相对计划时刻的延迟
+    double p99_jitter_us = 0.0;
+    double max_jitter_us = 0.0;
+    double mean_step_us = 0.0;       // 单次控制计算 + 串口发送耗时
+    double max_step_us = 0.0;
+};
 
 class AlignmentController {
 private:
     MotorController motor_controller_;
-    bool auto_align_enabled_;
-    float alignment_threshold_;
-    float alignment_kp_;
-    float current_pixel_error_;
-    bool is_aligned_;
-    int alignment_frame_count_;
-    int8_t last_motor_data_;
+    // 以下状态在启用控制线程时由控制线程写、界面线程读；
+    // 像素阈值由界面线程（'t' 键）写，其余阈值与模式开关也可能在运行中由其他线程设置，同样使用原子量
+    std::atomic<bool> auto_align_enabled_;
+    std::atomic<float> alignment_threshold_;
+    std::atomic<float> current_pixel_error_;
+    std::atomic<bool> is_aligned_;
+    std::atomic<int> alignment_frame_count_;
+    std::atomic<int8_t> last_motor_data_;
     // 摄像头相对于飞镖架中轴线的水平偏移（像素）。正值表示期望中心点向右偏移。
     float camera_offset_pixels_;
     
+    // 角度误差模式：像素误差经标定内参换算为弧度，分档在角度空间定义
+    std::atomic<bool> angle_mode_;
+    cv::Mat camera_matrix_;        // 标定时全分辨率传感器的内参
+    cv::Mat dist_coeffs_;
+    cv::Size calibration_size_;    // 标定图像尺寸
+    SensorMode sensor_mode_;       // 当前 ROI / 像素合并，与测距共用
+    std::atomic<float> alignment_threshold_rad_;
+    std::atomic<float> current_angle_error_;
+    cv::Size warned_size_;         // 已提示过的推断缩放分辨率
+    
+    // 连续速度控制：角度误差经 PID + 目标速度前馈得到角速度指令，替代 5 档速度分档
+    std::atomic<bool> continuous_control_;
+    PidController pid_;
+    mutable std::mutex pid_mutex_;   // 运行中调参与控制线程之间
+    double last_pid_time_ms_;
+    cv::Point2f target_velocity_px_; // 目标像素速度（像素/ms）
+    bool warned_disconnected_;       // 串口未连接只提示一次
+    std::function<double()> clock_ms_;   // 控制用时钟（毫秒），仿真时替换为仿真时钟
+    // 遥测新鲜度：按控制时钟记录下位机时间戳最后一次变化的时刻，超过 TELEMETRY_STALE_MS 不再使用实测转速
+    uint32_t last_telemetry_mcu_ms_;
+    double last_telemetry_change_ms_;
+    int serial_baud_;                // setSerialPort / connectMotorController 使用的波特率
+    
+    void resetPid();
+    // 串口未连接时提示一次并返回 false
+    bool checkConnected();
+    
+    // 命中概率与发射许可：有本帧输入时发射许可由命中概率决定；对准（停止电机）仍按死区 + 5 帧去抖
+    HitProbabilityEstimator hit_estimator_;
+    HitInputs pending_hit_inputs_;
+    std::atomic<bool> has_hit_inputs_;
+    HitEstimate last_hit_;
+    std::atomic<bool> fire_permitted_;
+    mutable std::mutex hit_mutex_;   // 保护 last_hit_ 的跨线程读取
+    
+    void updateFirePermission(float aim_error, float focal_px);
+    
+    // 固定频率控制线程：视觉线程经无锁邮箱投递最新目标估计，控制线程每周期外推到
+    // 指令生效时刻并下发，与视觉帧率解耦
+    std::thread control_thread_;
+    std::atomic<bool> control_running_;
+    Mailbox<TargetSnapshot> target_mailbox_;
+    mutable Mailbox<ControlLoopStats> stats_mailbox_;
+    mutable ControlLoopStats control_stats_;   // 读者侧缓存，仅由调用 getControlStats 的线程访问
+    bool control_stop_sent_;
+    // 以下仅由控制线程访问：
+    // 界面线程关闭自动对准时只清除 auto_align_enabled_，由控制线程在检测到启用 -> 禁用的边沿时停止电机，
+    // 避免已在执行的周期在停止指令之后再下发运动指令
+    bool control_align_enabled_;
+    // 去抖按检测计数：同一次检测外推出的多个控制周期只计一帧
+    bool count_alignment_frame_;
+    double counted_detection_ms_;
+    
+    // 停止电机并清除对准状态（未启用控制线程时由调用线程执行，否则由控制线程执行）
+    void disableAlignment();
+    void controlLoop(double rate_hz, int priority);
+    void controlStep(const TargetSnapshot& snapshot, bool has_snapshot, double now_ms);
+    
+    // 帧像素 -> 目标相对光轴的水平角（弧度）；同时给出该处等效焦距用于像素显示
+    float pixelToAngle(const cv::Point2f& pixel, const cv::Size& frame_size, float& focal_px);
+    
 public:
     AlignmentController();
     ~AlignmentController();
     
     // 执行对准操作
     void performAlignment(const cv::Point2f& circle_center, int image_width);
+    // 已设置内参且启用角度模式时按角度误差对准，否则退回像素模式
+    void performAlignment(const cv::Point2f& circle_center, const cv::Size& frame_size);
+    
+    // 角度误差模式配置
+    bool loadCalibration(const std::string& file_name);
+    void setIntrinsics(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& calibration_size);
+    bool loadAngleConfig(const std::string& file_name);
+    void setSensorMode(const SensorMode& mode);
+    const SensorMode& getSensorMode() const { return sensor_mode_; }
+    void setAngleMode(bool enabled);
+    bool isAngleMode() const { return angle_mode_ && !camera_matrix_.empty(); }
+    float getAngleError() const { return current_angle_error_; }
+    
+    // 连续速度控制（需要下位机支持速度指令帧，仅角度误差模式可用）
+    void setContinuousControl(bool enabled);
+    bool isContinuousControl() const { return continuous_control_ && isAngleMode(); }
+    void setPidGains(const PidGains& gains);
+    PidGains getPidGains() const;
+    // 目标像素速度（像素/ms），连续控制时换算为角速度前馈
+    void setTargetVelocity(const cv::Point2f& velocity_px) { target_velocity_px_ = velocity_px; }
+    
+    // 命中概率：每帧在 performAlignment 之前给出距离、跟踪协方差等输入，瞄准误差由对准控制器填入
+    bool loadHitModel(const std::string& file_name);
+    void setHitContext(const HitInputs& inputs);
+    HitEstimate getHitEstimate() const;
+    float getHitProbability() const;
+    // 发射许可：命中概率模型可用时为概率判定（带迟滞），否则退回连续 5 帧对准
+    bool isFirePermitted() const;
+    
+    // 控制线程：priority 为 SCHED_FIFO 优先级（1-99），无权限时以普通优先级运行
+    bool startControlThread(double rate_hz = 200.0, int priority = 80);
+    void stopControlThread();
+    bool isControlThreadRunning() const { return control_running_; }
+    // 视觉线程每帧调用（单生产者），不阻塞
+    void publishTarget(const TargetSnapshot& snapshot);
+    ControlLoopStats getControlStats() const;
     
     // 切换自动对准
     void toggleAutoAlign();
     
-    // 设置对准阈值
+    // 设置对准阈值（像素模式，像素）
     void setAlignmentThreshold(float threshold);
+    // 设置对准阈值（角度模式，毫弧度）
+    void setAngleAlignmentThreshold(float threshold_mrad);
     
     // 设置串口设备
     bool setSerialPort(const std::string& port_name);
@@ -42,10 +182,12 @@ public:
     bool isAutoAlignEnabled() const;
     float getPixelError() const;
     float getAlignmentThreshold() const;
+    float getAngleAlignmentThreshold() const;  // 毫弧度
     std::string getMotorStateString() const;
     int8_t getLastMotorData() const;
     bool isMotorConnected() const;
     std::string getPortName() const;
+    double getLastCommandLatencyMs() const;  // 最近一次指令的串口发送耗时
     
     // 停止对准
     void stop();
@@ -55,6 +197,21 @@ public:
     
     // 连接电机控制器
     bool connectMotorController();
+    // 闭环仿真：指令帧交给 sink（通常转发给 PlantSimulator），控制时钟改用 clock_ms，不打印逐条指令
+    bool connectSimulated(const SerialPort::WriteSink& sink, const std::function<double()>& clock_ms);
+    // 闭环仿真：下位机回复（ACK、遥测）的字节
+    void receiveSimulated(const uint8_t* data, size_t size);
+    // 串口协议版本，需在连接前设置（1: 旧固件；2: 带 ACK 与遥测）
+    bool setSerialProtocol(int version);
+    // 串口波特率（默认 115200，支持 1–3 Mbaud 等非标准值）与低延迟配置，需在连接前设置
+    void setSerialBaudRate(int baud_rate);
+    void setSerialLatencyProfile(const SerialLatencyProfile& profile);
+    // 串口断开后自动重连（默认开启）
+    void setSerialAutoReconnect(bool enabled);
+    // 指令去重、保活周期与下位机看门狗
+    void setCommandSchedule(const CommandSchedule& schedule);
+    // 打印写出的串口帧（调试用，默认关闭）
+    void setSerialFrameLogging(bool enabled);
     // 设置摄像头相对于发射架中轴线的水平偏移（像素或通过 mm+scale 转换）
     void setCameraOffsetPixels(float px);
     void setCameraOffsetMM(float mm, float mm_per_pixel);
@@ -0,0 +1,334 @@
+#include "BallisticSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+const float DEG2RAD = static_cast<float>(CV_PI / 180.0);
+const float MAX_FLIGHT_TIME = 10.0f;      // 积分的最长飞行时间（s）
+const float MAX_TABLE_CORRECTION = 0.3f;  // 查表一阶高度修正的适用范围（m）
+const float MAX_PITCH_CORRECTION = 0.5f * static_cast<float>(CV_PI / 180.0);  // 修正量上限，超过说明接近最大射程
+
+struct FlightState {
+    float x, y, vx, vy;
+};
+
+// 一步 RK4：重力 + 与速度平方成正比的阻力
+FlightState rk4Step(const FlightState& s, float dt, float drag_factor, float gravity) {
+    auto derivative = [drag_factor, gravity](const FlightState& f) {
+        float speed = std::sqrt(f.vx * f.vx + f.vy * f.vy);
+        return FlightState{f.vx, f.vy, -drag_factor * speed * f.vx, -gravity - drag_factor * speed * f.vy};
+    };
+    auto advance = [](const FlightState& f, const FlightState& d, float h) {
+        return FlightState{f.x + d.x * h, f.y + d.y * h, f.vx + d.vx * h, f.vy + d.vy * h};
+    };
+    FlightState k1 = derivative(s);
+    FlightState k2 = derivative(advance(s, k1, dt / 2));
+    FlightState k3 = derivative(advance(s, k2, dt / 2));
+    FlightState k4 = derivative(advance(s, k3, dt));
+    return FlightState{
+        s.x + dt / 6 * (k1.x + 2 * k2.x + 2 * k3.x + k4.x),
+        s.y + dt / 6 * (k1.y + 2 * k2.y + 2 * k3.y + k4.y),
+        s.vx + dt / 6 * (k1.vx + 2 * k2.vx + 2 * k3.vx + k4.vx),
+        s.vy + dt / 6 * (k1.vy + 2 * k2.vy + 2 * k3.vy + k4.vy)};
+}
+
+} // namespace
+
+BallisticSolver::BallisticSolver() {
+    setParams(BallisticParams());
+}
+
+void BallisticSolver::setParams(const BallisticParams& params) {
+    params_ = params;
+    drag_factor_ = 0.5f * params_.air_density * params_.drag_coefficient * params_.reference_area / params_.mass;
+    table_pitch_.clear();
+    table_dpitch_dh_.clear();
+    table_flight_time_.clear();
+    firing_table_.release();
+}
+
+bool BallisticSolver::loadParams(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开弹道参数文件: " << file_name << std::endl;
+        return false;
+    }
+
+    BallisticParams params;
+    auto read = [&fs](const char* key, float& value) {
+        cv::FileNode node = fs[key];
+        if (!node.empty()) value = static_cast<float>(node);
+    };
+    read("mass", params.mass);
+    read("drag_coefficient", params.drag_coefficient);
+    read("reference_area", params.reference_area);
+    read("air_density", params.air_density);
+    read("gravity", params.gravity);
+    read("launch_speed", params.launch_speed);
+    read("min_pitch_deg", params.min_pitch_deg);
+    read("max_pitch_deg", params.max_pitch_deg);
+    read("nominal_height", params.nominal_height);
+    read("table_min_range", params.table_min_range);
+    read("table_max_range", params.table_max_range);
+    read("table_step", params.table_step);
+    read("table_min_height", params.table_min_height);
+    read("table_max_height", params.table_max_height);
+    read("table_height_step", params.table_height_step);
+    read("table_pitch_step_deg", params.table_pitch_step_deg);
+    read("integration_step", params.integration_step);
+    cv::FileNode offset = fs["launcher_offset"];
+    if (offset.isSeq() && offset.size() == 3) {
+        params.launcher_offset = cv::Point3f(static_cast<float>(offset[0]), static_cast<float>(offset[1]),
+                                             static_cast<float>(offset[2]));
+    }
+
+    if (params.mass <= 0 || params.launch_speed <= 0 || params.table_step <= 0 || params.integration_step <= 0 ||
+        params.table_max_range <= params.table_min_range || params.table_height_step <= 0 ||
+        params.table_max_height < params.table_min_height || params.table_pitch_step_deg <= 0) {
+        std::cerr << "弹道参数无效: " << file_name << std::endl;
+        return false;
+    }
+
+    setParams(params);
+    std::cout << "已加载弹道参数: " << file_name << " (质量 " << params_.mass << "kg, 初速 "
+              << params_.launch_speed << "m/s, Cd " << params_.drag_coefficient << ")" << std::endl;
+    return true;
+}
+
+bool BallisticSolver::simulate(float pitch, float range, float& height, float& flight_time) const {
+    const float dt = params_.integration_step;
+    FlightState s{0.0f, 0.0f, params_.launch_speed * std::cos(pitch), params_.launch_speed * std::sin(pitch)};
+    float t = 0.0f;
+    while (t < MAX_FLIGHT_TIME) {
+        FlightState next = rk4Step(s, dt, drag_factor_, params_.gravity);
+        if (next.x >= range) {
+            // 在步内线性插值到目标距离
+            float a = (range - s.x) / (next.x - s.x);
+            height = s.y + a * (next.y - s.y);
+            flight_time = t + a * dt;
+            return true;
+        }
+        // 水平速度耗尽或已经远低于目标，不可能再到达
+        if (next.vx <= 1e-3f || (next.vy < 0 && next.y < -range)) {
+            return false;
+        }
+        s = next;
+        t += dt;
+    }
+    return false;
+}
+
+int BallisticSolver::simulateProfile(float pitch, float range_min, float range_step, int count, float min_height,
+                                     float* heights, float* flight_times) const {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::fill(heights, heights + count, nan);
+    std::fill(flight_times, flight_times + count, nan);
+
+    const float dt = params_.integration_step;
+    FlightState s{0.0f, 0.0f, params_.launch_speed * std::cos(pitch), params_.launch_speed * std::sin(pitch)};
+    float t = 0.0f;
+    int next_index = 0;
+    while (next_index < count && t < MAX_FLIGHT_TIME) {
+        FlightState next = rk4Step(s, dt, drag_factor_, params_.gravity);
+        // 一步内可能越过多个距离节点
+        while (next_index < count && next.x >= range_min + next_index * range_step) {
+            float range = range_min + next_index * range_step;
+            if (range >= s.x) {
+                float a = (range - s.x) / (next.x - s.x);
+                heights[next_index] = s.y + a * (next.y - s.y);
+                flight_times[next_index] = t + a * dt;
+            }
+            next_index++;
+        }
+        if (next.vx <= 1e-3f || (next.vy < 0 && next.y < min_height)) {
+            break;
+        }
+        s = next;
+        t += dt;
+    }
+    return next_index;
+}
+
+bool BallisticSolver::solvePitch(float range, float height, float& pitch, float& flight_time,
+                                 float start_pitch) const {
+    // 从起点仰角向上扫描，第一个使落点高度越过目标的区间即为低伸弹道
+    const float scan_step = 1.0f * DEG2RAD;
+    const float max_pitch = params_.max_pitch_deg * DEG2RAD;
+    const float min_pitch = std::max(params_.min_pitch_deg * DEG2RAD, start_pitch);
+
+    float lo = 0.0f, hi = 0.0f;
+    bool bracketed = false;
+    float prev_pitch = min_pitch;
+    float prev_error = 0.0f;
+    bool prev_valid = false;
+    for (float p = min_pitch; p <= max_pitch + 1e-6f; p += scan_step) {
+        float h, t;
+        if (!simulate(p, range, h, t)) {
+            prev_valid = false;
+            continue;
+        }
+        float error = h - height;
+        if (error == 0.0f) {
+            pitch = p;
+            flight_time = t;
+            return true;
+        }
+        if (prev_valid && prev_error < 0.0f && error > 0.0f) {
+            lo = prev_pitch;
+            hi = p;
+            bracketed = true;
+            break;
+        }
+        prev_pitch = p;
+        prev_error = error;
+        prev_valid = true;
+    }
+    if (!bracketed) {
+        return false;
+    }
+
+    // 二分到 1e-6 弧度
+    float h = 0.0f, t = 0.0f;
+    for (int i = 0; i < 40 && hi - lo > 1e-6f; ++i) {
+        float mid = 0.5f * (lo + hi);
+        if (!simulate(mid, range, h, t) || h > height) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    pitch = 0.5f * (lo + hi);
+    return simulate(pitch, range, h, flight_time);
+}
+
+int BallisticSolver::buildTable() {
+    auto start = std::chrono::high_resolution_clock::now();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float dh = 0.1f;   // 计算 d仰角/d高度 的差分步长（m）
+
+    int count = static_cast<int>(std::floor((params_.table_max_range - params_.table_min_range) / params_.table_step)) + 1;
+    table_pitch_.assign(count, nan);
+    table_dpitch_dh_.assign(count, nan);
+    table_flight_time_.assign(count, nan);
+
+    // 仰角随距离单调增加：以上一项的解减去一个扫描步长作为下一项的扫描起点
+    const float warm_margin = 1.0f * DEG2RAD;
+    float hint = -1000.0f;
+    int solved = 0;
+    for (int i = 0; i < count; ++i) {
+        float range = params_.table_min_range + i * params_.table_step;
+        float pitch, time, pitch_up, time_up;
+        if (!solvePitch(range, params_.nominal_height, pitch, time, hint)) {
+            hint = -1000.0f;
+            continue;
+        }
+        table_pitch_[i] = pitch;
+        table_flight_time_[i] = time;
+        // 中心差分：目标高低各偏 dh 都可达时才给出高度修正系数
+        float pitch_down, time_down;
+        if (solvePitch(range, params_.nominal_height - dh, pitch_down, time_down, hint) &&
+            solvePitch(range, params_.nominal_height + dh, pitch_up, time_up, pitch_down)) {
+            table_dpitch_dh_[i] = (pitch_up - pitch_down) / (2 * dh);
+        }
+        hint = pitch - warm_margin;
+        solved++;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "弹道查找表已生成: " << solved << "/" << count << " 项, 耗时 "
+              << std::chrono::duration<double, std::milli>(end - start).count() << "ms" << std::endl;
+    return solved;
+}
+
+bool BallisticSolver::loadFiringTable(const std::string& cache_file, int threads) {
+    return firing_table_.init(*this, cache_file, threads);
+}
+
+bool BallisticSolver::tableLookup(float range, float height, FiringSolution& solution) const {
+    if (table_pitch_.empty() || std::fabs(height - params_.nominal_height) > MAX_TABLE_CORRECTION) {
+        return false;
+    }
+    float f = (range - params_.table_min_range) / params_.table_step;
+    int i = static_cast<int>(std::floor(f));
+    if (i < 0 || i + 1 >= static_cast<int>(table_pitch_.size())) {
+        return false;
+    }
+    float a = f - i;
+    float p0 = table_pitch_[i], p1 = table_pitch_[i + 1];
+    float d0 = table_dpitch_dh_[i], d1 = table_dpitch_dh_[i + 1];
+    if (std::isnan(p0) || std::isnan(p1) || std::isnan(d0) || std::isnan(d1)) {
+        return false;
+    }
+
+    // 接近最大射程时仰角对高度非线性，一阶修正不再可靠，交给迭代求解
+    float correction = (d0 + a * (d1 - d0)) * (height - params_.nominal_height);
+    if (std::fabs(correction) > MAX_PITCH_CORRECTION) {
+        return false;
+    }
+    float pitch = p0 + a * (p1 - p0) + correction;
+    if (pitch < params_.min_pitch_deg * DEG2RAD || pitch > params_.max_pitch_deg * DEG2RAD) {
+        return false;
+    }
+    solution.pitch = pitch;
+    solution.flight_time = table_flight_time_[i] + a * (table_flight_time_[i + 1] - table_flight_time_[i]);
+    solution.valid = true;
+    return true;
+}
+
+FiringSolution BallisticSolver::solveRangeHeight(float range, float height) const {
+    FiringSolution solution;
+    solution.horizontal_range = range;
+    solution.height = height;
+    if (range <= 0) {
+        return solution;
+    }
+    if (firing_table_.lookup(range, height, solution.pitch, solution.flight_time)) {
+        solution.valid = true;
+    } else if (!tableLookup(range, height, solution)) {
+        solution.valid = solvePitch(range, height, solution.pitch, solution.flight_time);
+    }
+    return solution;
+}
+
+FiringSolution BallisticSolver::solve(const cv::Point3f& target_position) const {
+    // 相机坐标系：x 右, y 下, z 前；换算到发射点的水平距离和高度
+    cv::Point3f rel = target_position - params_.launcher_offset;
+    float range = std::sqrt(rel.x * rel.x + rel.z * rel.z);
+    FiringSolution solution = solveRangeHeight(range, -rel.y);
+    solution.yaw = std::atan2(rel.x, rel.z);
+    return solution;
+}
+
+float BallisticSolver::impactSlope(const FiringSolution& solution) const {
+    const float dx = 0.05f;
+    float h0, h1, t;
+    if (!solution.valid || solution.horizontal_range <= dx ||
+        !simulate(solution.pitch, solution.horizontal_range - dx, h0, t) ||
+        !simulate(solution.pitch, solution.horizontal_range + dx, h1, t)) {
+        return 0.0f;
+    }
+    return (h1 - h0) / (2 * dx);
+}
+
+void BallisticSolver::printTableSummary() const {
+    if (table_pitch_.empty()) {
+        std::cout << "弹道查找表未生成" << std::endl;
+        return;
+    }
+    std::cout << "=== 弹道查找表 (目标高度 " << params_.nominal_height << "m) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (float range = std::ceil(params_.table_min_range); range <= params_.table_max_range; range += 5.0f) {
+        FiringSolution s = solveRangeHeight(range, params_.nominal_height);
+        if (s.valid) {
+            std::cout << "  " << std::setw(6) << range << "m: 仰角 " << s.pitch / DEG2RAD
+                      << "°, 飞行时间 " << s.flight_time << "s" << std::endl;
+        } else {
+            std::cout << "  " << std::setw(6) << range << "m: 不可达" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef BALLISTICSOLVER_H
+#define BALLISTICSOLVER_H
+
+#include "FiringTable.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// 飞镖与发射参数（国际单位）
+struct BallisticParams {
+    float mass = 0.18f;                // 飞镖质量（kg）
+    float drag_coefficient = 0.45f;    // 阻力系数 Cd
+    float reference_area = 0.0016f;    // 迎风面积（m^2）
+    float air_density = 1.20f;         // 空气密度（kg/m^3）
+    float gravity = 9.79f;             // 重力加速度（m/s^2）
+    float launch_speed = 17.0f;        // 出膛速度（m/s）
+    float min_pitch_deg = -5.0f;       // 发射仰角范围（度）
+    float max_pitch_deg = 50.0f;
+    float nominal_height = 0.0f;       // 查找表对应的目标相对发射点高度（m）
+    float table_min_range = 1.0f;      // 查找表水平距离范围与步长（m）
+    float table_max_range = 30.0f;
+    float table_step = 0.05f;
+    float table_min_height = -2.0f;    // 二维射表的目标高度范围与步长（m）
+    float table_max_height = 3.0f;
+    float table_height_step = 0.1f;
+    float table_pitch_step_deg = 0.02f; // 生成二维射表时的仰角扫描步长（度）
+    float integration_step = 0.001f;   // 积分步长（s）
+    cv::Point3f launcher_offset;       // 发射点在相机坐标系中的位置（m，x 右, y 下, z 前）
+};
+
+// 射击诸元
+struct FiringSolution {
+    bool valid = false;
+    float pitch = 0.0f;             // 发射仰角（弧度）
+    float yaw = 0.0f;               // 发射方位角（弧度），目标在右为正
+    float flight_time = 0.0f;       // 飞行时间（s）
+    float horizontal_range = 0.0f;  // 发射点到目标的水平距离（m）
+    float height = 0.0f;            // 目标相对发射点的高度（m），向上为正
+};
+
+// 弹道解算：重力 + 二次空气阻力的质点模型，RK4 积分
+// 启动时加载（或生成并缓存）距离 x 高度 的二维射表，每帧查询为 O(1) 双线性插值；
+// 一维查找表只覆盖 nominal_height，偏离不超过 0.3m 时用表中的 d仰角/d高度 做一阶修正；
+// 两者都不可用时迭代求解
+class BallisticSolver {
+private:
+    BallisticParams params_;
+    float drag_factor_;   // 0.5 * rho * Cd * A / m
+
+    // 查找表（按 table_step 等间距）
+    std::vector<float> table_pitch_;
+    std::vector<float> table_dpitch_dh_;
+    std::vector<float> table_flight_time_;
+
+    FiringTable firing_table_;   // 二维射表（距离 x 高度），可从缓存 mmap
+
+    bool tableLookup(float range, float height, FiringSolution& solution) const;
+
+public:
+    BallisticSolver();
+    BallisticSolver(const BallisticSolver&) = delete;
+    BallisticSolver& operator=(const BallisticSolver&) = delete;
+
+    // 从 YAML 加载参数，缺失的字段保持默认值
+    bool loadParams(const std::string& file_name);
+    void setParams(const BallisticParams& params);
+    const BallisticParams& getParams() const { return params_; }
+
+    // 以给定仰角发射，返回飞到水平距离 range 时的高度和时间；到不了该距离时返回 false
+    bool simulate(float pitch, float range, float& height, float& flight_time) const;
+
+    // 以给定仰角发射，一次积分记录经过 range_min + i * range_step (i < count) 各处的高度和时间；
+    // 未到达的距离填 NaN，落到 min_height 以下即停止。返回到达的距离数
+    int simulateProfile(float pitch, float range_min, float range_step, int count, float min_height,
+                        float* heights, float* flight_times) const;
+
+    // 迭代求解命中 (range, height) 的低伸弹道仰角；start_pitch 为扫描起点（弧度），用于连续求解时热启动
+    bool solvePitch(float range, float height, float& pitch, float& flight_time,
+                    float start_pitch = -1000.0f) const;
+
+    // 生成查找表，返回成功求解的表项数
+    int buildTable();
+    bool hasTable() const { return !table_pitch_.empty(); }
+
+    // 初始化二维射表：cache_file 存在且参数匹配时直接映射，否则多线程生成并写入
+    bool loadFiringTable(const std::string& cache_file, int threads = 0);
+    const FiringTable& getFiringTable() const { return firing_table_; }
+
+    // 由相机坐标系中的目标位置计算射击诸元：优先查二维射表，其次一维查找表，都不可用时迭代求解
+    FiringSolution solve(const cv::Point3f& target_position) const;
+
+    // 水平距离 + 高度 -> 射击诸元（方位角为 0）
+    FiringSolution solveRangeHeight(float range, float height) const;
+
+    // 以 solution 的仰角飞行时，弹道在目标距离处的斜率 dh/dx（下降为负），不可达时返回 0
+    // 用于把距离误差换算成目标处的竖直脱靶量
+    float impactSlope(const FiringSolution& solution) const;
+
+    void printTableSummary() const;
+};
+
+#endif // BALLISTICSOLVER_H
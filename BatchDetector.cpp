@@ -0,0 +1,392 @@
+#include "BatchDetector.h"
+#include "DistanceEstimator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// 待检测的视频帧
+struct PendingFrame {
+    int index;
+    double timestamp_ms;
+    cv::Mat image;
+};
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+} // namespace
+
+BatchDetector::BatchDetector(const BatchOptions& options)
+    : options_(options), wall_time_ms_(0.0) {
+    options_.workers = std::max(1, options_.workers);
+}
+
+void BatchDetector::setDetectorConfigurator(const std::function<void(VisionDetector&)>& configure) {
+    configure_detector_ = configure;
+}
+
+bool BatchDetector::isImageFile(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+}
+
+std::vector<std::string> BatchDetector::listImages(const std::string& directory) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && isImageFile(entry.path().string())) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool BatchDetector::setupDetector(VisionDetector& detector) const {
+    detector.setRenderResults(false);
+    if (!options_.pipeline_path.empty() && !detector.loadPipeline(options_.pipeline_path)) {
+        return false;
+    }
+    if (configure_detector_) {
+        configure_detector_(detector);
+    }
+    return true;
+}
+
+void BatchDetector::processFrame(VisionDetector& detector, const cv::Mat& frame, BatchFrameRecord& record) const {
+    auto start = std::chrono::high_resolution_clock::now();
+    detector.detectGreenCirclesWithResults(frame, record.results);
+    auto end = std::chrono::high_resolution_clock::now();
+    record.latency_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    record.loaded = true;
+}
+
+bool BatchDetector::run() {
+    records_.clear();
+    wall_time_ms_ = 0.0;
+
+    // 多个工作线程时关闭 OpenCV 内部并行，避免线程超额订阅
+    if (options_.workers > 1) {
+        cv::setNumThreads(1);
+    }
+
+    bool ok;
+    if (std::filesystem::is_directory(options_.input)) {
+        std::vector<std::string> files = listImages(options_.input);
+        if (files.empty()) {
+            std::cerr << "目录中没有图像文件: " << options_.input << std::endl;
+            return false;
+        }
+        ok = runImages(files);
+    } else if (isImageFile(options_.input)) {
+        ok = runImages({options_.input});
+    } else {
+        ok = runVideo();
+    }
+    if (!ok) return false;
+
+    // 计算距离（各帧独立，与实时主循环一致）
+    DistanceEstimator estimator;
+    estimator.setTargetParameters(options_.focal_length, options_.target_diameter);
+    if (!options_.calibration_path.empty() && !estimator.loadCalibration(options_.calibration_path)) {
+        return false;
+    }
+    for (auto& record : records_) {
+        estimator.estimateDistances(record.results);
+    }
+    return true;
+}
+
+bool BatchDetector::runImages(const std::vector<std::string>& files) {
+    records_.resize(files.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> setup_failed(false);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options_.workers; ++w) {
+        workers.emplace_back([&]() {
+            VisionDetector detector;
+            if (!setupDetector(detector)) {
+                setup_failed = true;
+                return;
+            }
+            // 每个线程按原子序号领取任务，结果直接写入预分配的位置
+            for (size_t i = next++; i < files.size(); i = next++) {
+                BatchFrameRecord& record = records_[i];
+                record.source = files[i];
+                record.frame_index = static_cast<int>(i);
+                record.timestamp_ms = i * options_.frame_interval_ms;
+
+                cv::Mat frame = cv::imread(files[i], cv::IMREAD_COLOR);
+                if (frame.empty()) {
+                    std::cerr << "无法读取图像: " << files[i] << std::endl;
+                    continue;
+                }
+                processFrame(detector, frame, record);
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    wall_time_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+    return !setup_failed;
+}
+
+bool BatchDetector::runVideo() {
+    cv::VideoCapture capture(options_.input);
+    if (!capture.isOpened()) {
+        std::cerr << "无法打开视频: " << options_.input << std::endl;
+        return false;
+    }
+    double fps = capture.get(cv::CAP_PROP_FPS);
+    double interval_ms = (fps > 0) ? 1000.0 / fps : options_.frame_interval_ms;
+
+    // 单线程顺序解码，工作线程从有界队列取帧
+    std::deque<PendingFrame> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_not_empty;
+    std::condition_variable queue_not_full;
+    bool decode_done = false;
+    std::mutex records_mutex;
+    std::atomic<bool> setup_failed(false);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options_.workers; ++w) {
+        workers.emplace_back([&]() {
+            VisionDetector detector;
+            if (!setupDetector(detector)) {
+                setup_failed = true;
+            }
+            while (true) {
+                PendingFrame pending;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_not_empty.wait(lock, [&]() { return !queue.empty() || decode_done; });
+                    if (queue.empty()) break;
+                    pending = std::move(queue.front());
+                    queue.pop_front();
+                }
+                queue_not_full.notify_one();
+                if (setup_failed) continue;   // 继续出队，避免解码线程阻塞
+
+                BatchFrameRecord record;
+                record.source = options_.input;
+                record.frame_index = pending.index;
+                record.timestamp_ms = pending.timestamp_ms;
+                processFrame(detector, pending.image, record);
+
+                std::lock_guard<std::mutex> lock(records_mutex);
+                records_.push_back(std::move(record));
+            }
+        });
+    }
+
+    int index = 0;
+    cv::Mat frame;
+    while (capture.read(frame)) {
+        PendingFrame pending;
+        pending.index = index;
+        pending.timestamp_ms = index * interval_ms;
+        pending.image = frame.clone();
+        ++index;
+
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_not_full.wait(lock, [&]() { return static_cast<int>(queue.size()) < options_.queue_capacity; });
+        queue.push_back(std::move(pending));
+        lock.unlock();
+        queue_not_empty.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        decode_done = true;
+    }
+    queue_not_empty.notify_all();
+    for (auto& t : workers) t.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    wall_time_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::sort(records_.begin(), records_.end(),
+              [](const BatchFrameRecord& a, const BatchFrameRecord& b) { return a.frame_index < b.frame_index; });
+    return !setup_failed;
+}
+
+double BatchDetector::getThroughputFps() const {
+    return (wall_time_ms_ > 0) ? records_.size() * 1000.0 / wall_time_ms_ : 0.0;
+}
+
+void BatchDetector::printSummary() const {
+    size_t loaded = 0, with_target = 0, targets = 0;
+    double latency_sum = 0.0;
+    std::vector<double> latencies;
+    for (const auto& record : records_) {
+        if (!record.loaded) continue;
+        loaded++;
+        latency_sum += record.latency_ms;
+        latencies.push_back(record.latency_ms);
+        targets += record.results.size();
+        if (!record.results.empty()) with_target++;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "=== 离线检测统计 ===" << std::endl;
+    std::cout << "输入: " << options_.input << std::endl;
+    std::cout << "工作线程: " << options_.workers << std::endl;
+    std::cout << "帧数: " << records_.size() << " (成功读取 " << loaded << ")" << std::endl;
+    std::cout << "含目标帧: " << with_target << ", 目标总数: " << targets << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "总耗时: " << wall_time_ms_ << "ms, 吞吐量: " << getThroughputFps() << " fps" << std::endl;
+    if (!latencies.empty()) {
+        std::cout << "单帧检测耗时 平均: " << latency_sum / latencies.size() << "ms"
+                  << ", P50: " << latencies[latencies.size() / 2] << "ms"
+                  << ", P95: " << latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)] << "ms"
+                  << std::endl;
+    }
+}
+
+bool BatchDetector::writeCsv(const std::string& file_name, const std::vector<BatchFrameRecord>& records) {
+    std::ofstream out(file_name);
+    if (!out.is_open()) {
+        std::cerr << "无法写入文件: " << file_name << std::endl;
+        return false;
+    }
+    out << "source,frame_index,timestamp_ms,latency_ms,target_index,x,y,radius,pixel_diameter,confidence,distance,has_distance,"
+        << "pos_x,pos_y,pos_z,yaw_deg,pitch_deg\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& record : records) {
+        if (!record.loaded) continue;
+        if (record.results.empty()) {
+            // 无目标帧也输出一行，便于统计漏检
+            out << record.source << ',' << record.frame_index << ',' << record.timestamp_ms << ','
+                << record.latency_ms << ",-1,,,,,,,0,,,,,\n";
+            continue;
+        }
+        for (size_t i = 0; i < record.results.size(); ++i) {
+            const DetectionResult& res = record.results[i];
+            out << record.source << ',' << record.frame_index << ',' << record.timestamp_ms << ','
+                << record.latency_ms << ',' << i << ','
+                << res.circle[0] << ',' << res.circle[1] << ',' << res.circle[2] << ','
+                << res.pixel_diameter << ',' << res.confidence << ','
+                << res.distance << ',' << (res.has_distance ? 1 : 0) << ',';
+            if (res.has_position) {
+                out << res.position.x << ',' << res.position.y << ',' << res.position.z << ','
+                    << res.yaw * 180.0 / CV_PI << ',' << res.pitch * 180.0 / CV_PI << '\n';
+            } else {
+                out << ",,,,\n";
+            }
+        }
+    }
+    std::cout << "检测结果已写入: " << file_name << std::endl;
+    return true;
+}
+
+bool BatchDetector::writeJson(const std::string& file_name, const std::vector<BatchFrameRecord>& records) {
+    std::ofstream out(file_name);
+    if (!out.is_open()) {
+        std::cerr << "无法写入文件: " << file_name << std::endl;
+        return false;
+    }
+    out << std::fixed << std::setprecision(3);
+    out << "[\n";
+    bool first_record = true;
+    for (const auto& record : records) {
+        if (!record.loaded) continue;
+        if (!first_record) out << ",\n";
+        first_record = false;
+
+        out << "  {\"source\": \"" << jsonEscape(record.source) << "\", "
+            << "\"frame_index\": " << record.frame_index << ", "
+            << "\"timestamp_ms\": " << record.timestamp_ms << ", "
+            << "\"latency_ms\": " << record.latency_ms << ", \"targets\": [";
+        for (size_t i = 0; i < record.results.size(); ++i) {
+            const DetectionResult& res = record.results[i];
+            if (i > 0) out << ", ";
+            out << "{\"x\": " << res.circle[0] << ", \"y\": " << res.circle[1]
+                << ", \"radius\": " << res.circle[2]
+                << ", \"pixel_diameter\": " << res.pixel_diameter
+                << ", \"confidence\": " << res.confidence
+                << ", \"distance\": " << (res.has_distance ? res.distance : -1.0f);
+            if (res.has_position) {
+                out << ", \"position\": [" << res.position.x << ", " << res.position.y << ", " << res.position.z << "]"
+                    << ", \"yaw_deg\": " << res.yaw * 180.0 / CV_PI
+                    << ", \"pitch_deg\": " << res.pitch * 180.0 / CV_PI;
+            }
+            out << "}";
+        }
+        out << "]}";
+    }
+    out << "\n]\n";
+    std::cout << "检测结果已写入: " << file_name << std::endl;
+    return true;
+}
+
+bool BatchDetector::readCsv(const std::string& file_name, std::vector<BatchFrameRecord>& records) {
+    std::ifstream in(file_name);
+    if (!in.is_open()) {
+        std::cerr << "无法打开检测结果文件: " << file_name << std::endl;
+        return false;
+    }
+
+    records.clear();
+    std::string line;
+    std::getline(in, line);  // 表头
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+        if (fields.size() < 5) continue;
+
+        // 同一帧的多个目标是连续的行
+        int frame_index = std::stoi(fields[1]);
+        if (records.empty() || records.back().frame_index != frame_index || records.back().source != fields[0]) {
+            BatchFrameRecord record;
+            record.source = fields[0];
+            record.frame_index = frame_index;
+            record.timestamp_ms = std::stod(fields[2]);
+            record.latency_ms = std::stod(fields[3]);
+            record.loaded = true;
+            records.push_back(record);
+        }
+        if (std::stoi(fields[4]) < 0 || fields.size() < 12) continue;
+
+        DetectionResult res;
+        res.circle = cv::Vec3f(std::stof(fields[5]), std::stof(fields[6]), std::stof(fields[7]));
+        res.pixel_diameter = std::stof(fields[8]);
+        res.confidence = std::stod(fields[9]);
+        res.distance = std::stof(fields[10]);
+        res.has_distance = fields[11] == "1";
+        if (fields.size() >= 17 && !fields[12].empty()) {
+            res.position = cv::Point3f(std::stof(fields[12]), std::stof(fields[13]), std::stof(fields[14]));
+            res.yaw = static_cast<float>(std::stod(fields[15]) * CV_PI / 180.0);
+            res.pitch = static_cast<float>(std::stod(fields[16]) * CV_PI / 180.0);
+            res.has_position = true;
+        }
+        records.back().results.push_back(res);
+    }
+    return true;
+}
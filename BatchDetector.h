@@ -0,0 +1,72 @@
+#ifndef BATCHDETECTOR_H
+#define BATCHDETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include "DetectionResult.h"
+#include "VisionDetector.h"
+
+// 单帧离线检测记录
+struct BatchFrameRecord {
+    std::string source;          // 图像文件路径，视频输入时为视频路径
+    int frame_index = -1;        // 在输入序列中的序号
+    double timestamp_ms = 0.0;   // 视频帧时间戳；图像目录按序号 × frame_interval_ms 生成
+    double latency_ms = 0.0;     // 检测耗时
+    bool loaded = false;         // 图像是否成功读取
+    std::vector<DetectionResult> results;
+};
+
+// 离线批处理参数
+struct BatchOptions {
+    std::string input;               // 图像目录或视频文件
+    int workers = 1;                 // 工作线程数，每个线程一个 VisionDetector 实例
+    std::string pipeline_path;       // 可选：检测流水线配置
+    float focal_length = 4968.4f;    // 距离估算使用的焦距（像素）
+    std::string calibration_path;    // 可选：标定文件，给出时使用完整内参
+    float target_diameter = 0.055f;  // 目标真实直径（米）
+    double frame_interval_ms = 40.0; // 图像目录的帧间隔（用于生成时间戳）
+    int queue_capacity = 32;         // 视频解码队列容量
+};
+
+// 离线批量检测：对图像目录或视频以 N 个工作线程运行 VisionDetector
+class BatchDetector {
+private:
+    BatchOptions options_;
+    std::vector<BatchFrameRecord> records_;
+    double wall_time_ms_;
+    // 每个工作线程创建检测器后调用，用于注入参数（参数搜索等）
+    std::function<void(VisionDetector&)> configure_detector_;
+
+    bool runImages(const std::vector<std::string>& files);
+    bool runVideo();
+    void processFrame(VisionDetector& detector, const cv::Mat& frame, BatchFrameRecord& record) const;
+    bool setupDetector(VisionDetector& detector) const;
+
+public:
+    explicit BatchDetector(const BatchOptions& options);
+
+    void setDetectorConfigurator(const std::function<void(VisionDetector&)>& configure);
+
+    // 执行批处理，输入无法打开时返回 false
+    bool run();
+
+    const std::vector<BatchFrameRecord>& getRecords() const { return records_; }
+    double getWallTimeMs() const { return wall_time_ms_; }
+    double getThroughputFps() const;
+    void printSummary() const;
+
+    // 列出目录下的图像文件（按文件名排序）
+    static std::vector<std::string> listImages(const std::string& directory);
+    static bool isImageFile(const std::string& path);
+
+    // 结果导出
+    static bool writeCsv(const std::string& file_name, const std::vector<BatchFrameRecord>& records);
+    static bool writeJson(const std::string& file_name, const std::vector<BatchFrameRecord>& records);
+
+    // 读回 writeCsv 输出的检测结果（用于回放评估）
+    static bool readCsv(const std::string& file_name, std::vector<BatchFrameRecord>& records);
+};
+
+#endif // BATCHDETECTOR_H
@@ -0,0 +1,64 @@
+#include "CacheFile.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string& file_name, size_t min_size) {
+    release();
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < min_size) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "无法映射缓存文件: " << file_name << std::endl;
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    return true;
+}
+
+void MappedFile::release() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+bool writeCacheFile(const std::string& file_name, const void* header, size_t header_size,
+                    const std::vector<CacheSegment>& segments) {
+    std::string tmp_name = file_name + ".tmp";
+    std::ofstream out(tmp_name, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "无法写入缓存文件: " << file_name << std::endl;
+        return false;
+    }
+
+    out.write(static_cast<const char*>(header), static_cast<std::streamsize>(header_size));
+    for (const auto& segment : segments) {
+        out.seekp(static_cast<std::streamoff>(segment.offset));
+        out.write(static_cast<const char*>(segment.data), static_cast<std::streamsize>(segment.bytes));
+    }
+    out.close();
+    if (!out || std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        std::cerr << "写入缓存文件失败: " << file_name << std::endl;
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+    return true;
+}
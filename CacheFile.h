@@ -0,0 +1,67 @@
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 磁盘查找表缓存（Undistorter 校正表、FiringTable 射表）共用的文件读写：
+// 文件头后跟若干按 CACHE_FILE_ALIGN 对齐的数据段，启动时只读 mmap、不做拷贝。
+// 文件头格式与校验由使用方定义。
+
+const size_t CACHE_FILE_ALIGN = 64;
+
+inline size_t alignCacheOffset(size_t value) {
+    return (value + CACHE_FILE_ALIGN - 1) / CACHE_FILE_ALIGN * CACHE_FILE_ALIGN;
+}
+
+// FNV-1a：缓存内容由参数决定，哈希写入文件头用于校验
+class Fnv1aHash {
+private:
+    uint64_t hash_ = 1469598103934665603ULL;
+
+public:
+    void mix(const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            hash_ ^= p[i];
+            hash_ *= 1099511628211ULL;
+        }
+    }
+    uint64_t value() const { return hash_; }
+};
+
+// 只读映射的缓存文件
+class MappedFile {
+private:
+    void* data_;
+    size_t size_;
+
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile() { release(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 文件不存在或小于 min_size 时返回 false；映射失败时打印原因
+    bool open(const std::string& file_name, size_t min_size);
+    void release();
+
+    bool isMapped() const { return data_ != nullptr; }
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+};
+
+// 写入缓存文件的一个数据段
+struct CacheSegment {
+    uint64_t offset;
+    const void* data;
+    size_t bytes;
+};
+
+// 先写临时文件再重命名，其他进程不会映射到写了一半的文件；失败时打印原因
+bool writeCacheFile(const std::string& file_name, const void* header, size_t header_size,
+                    const std::vector<CacheSegment>& segments);
+
+#endif // CACHEFILE_H
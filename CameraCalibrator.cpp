@@ -1,4 +1,5 @@
 #include "CameraCalibrator.h"
+#include "Undistorter.h"
 #include <iostream>
 #include <filesystem>  // 🔧 修正：添加 filesystem 头文件
 #include <opencv2/calib3d.hpp>
@@ -202,8 +203,13 @@ bool CameraCalibrator::loadParams(const std::string& fileName, cv::Mat& cameraMa
 }
 
 cv::Mat CameraCalibrator::undistortImage(const cv::Mat& src, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs) {
+    // 查找表按标定参数和分辨率缓存，参数不变时不再重复计算
+    thread_local Undistorter undistorter;
+    if (!undistorter.matches(cameraMatrix, distCoeffs, src.size())) {
+        undistorter.init(cameraMatrix, distCoeffs, src.size());
+    }
     cv::Mat undistorted;
-    cv::undistort(src, undistorted, cameraMatrix, distCoeffs);
+    undistorter.remap(src, undistorted);
     return undistorted;
 }
 
@@ -49,7 +49,7 @@ public:
     static bool loadParams(const std::string& fileName, cv::Mat& cameraMatrix, cv::Mat& distCoeffs);
     
     /**
-     * 畸变校正
+     * 畸变校正（使用缓存的定点查找表，标定参数或分辨率变化时重建）
      */
     static cv::Mat undistortImage(const cv::Mat& src, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs);
 
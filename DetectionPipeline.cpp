@@ -0,0 +1,542 @@
+#include "DetectionPipeline.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+int readInt(const cv::FileNode& node, const char* key, int fallback) {
+    cv::FileNode n = node[key];
+    return n.empty() ? fallback : static_cast<int>(n);
+}
+
+double readDouble(const cv::FileNode& node, const char* key, double fallback) {
+    cv::FileNode n = node[key];
+    return n.empty() ? fallback : static_cast<double>(n);
+}
+
+std::string readString(const cv::FileNode& node, const char* key, const std::string& fallback) {
+    cv::FileNode n = node[key];
+    return n.empty() ? fallback : static_cast<std::string>(n);
+}
+
+// ---------------------------------------------------------------------------
+// resize：将较长边缩放到 max_dim 以内，并记录缩放因子
+class ResizeStage : public PipelineStage {
+    int max_dim_ = 1024;
+    int interpolation_ = cv::INTER_AREA;
+    bool aliased_ = false;
+
+public:
+    std::string type() const override { return "resize"; }
+    void run(PipelineContext& ctx) override {
+        const cv::Mat& src = input(ctx);
+        int max_side = std::max(src.cols, src.rows);
+        ctx.scale = (max_side > max_dim_) ? static_cast<float>(max_dim_) / max_side : 1.0f;
+        if (ctx.scale < 1.0f) {
+            // 上一帧未缩放时输出与输入帧共享数据，先解除引用再写入，避免写进调用方的图像
+            if (aliased_) {
+                ctx.buffers[output_].release();
+                aliased_ = false;
+            }
+            cv::resize(src, ctx.buffers[output_], cv::Size(), ctx.scale, ctx.scale, interpolation_);
+        } else {
+            ctx.buffers[output_] = src;
+            aliased_ = true;
+        }
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        max_dim_ = readInt(node, "max_dim", max_dim_);
+        interpolation_ = (readString(node, "interpolation", "area") == "linear") ? cv::INTER_LINEAR : cv::INTER_AREA;
+    }
+    std::vector<std::string> defaultInputs() const override { return {"frame"}; }
+    std::string defaultOutput() const override { return "scaled"; }
+};
+
+// blur：高斯模糊
+class BlurStage : public PipelineStage {
+    int ksize_ = 5;
+    double sigma_ = 1.5;
+
+public:
+    std::string type() const override { return "blur"; }
+    void run(PipelineContext& ctx) override {
+        cv::GaussianBlur(input(ctx), ctx.buffers[output_], cv::Size(ksize_, ksize_), sigma_);
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        ksize_ = readInt(node, "ksize", ksize_) | 1;
+        sigma_ = readDouble(node, "sigma", sigma_);
+    }
+    std::vector<std::string> defaultInputs() const override { return {"scaled"}; }
+    std::string defaultOutput() const override { return "blurred"; }
+};
+
+// color_hsv：cvtColor + inRange，与 VisionDetector 内置颜色分割一致
+class ColorHsvStage : public PipelineStage {
+protected:
+    cv::Scalar lower_ = cv::Scalar(35, 50, 50);
+    cv::Scalar upper_ = cv::Scalar(85, 255, 255);
+
+public:
+    std::string type() const override { return "color_hsv"; }
+    void run(PipelineContext& ctx) override {
+        cv::Mat hsv;
+        cv::cvtColor(input(ctx), hsv, cv::COLOR_BGR2HSV);
+        cv::inRange(hsv, lower_, upper_, ctx.buffers[output_]);
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        lower_ = cv::Scalar(readDouble(node, "h_min", lower_[0]), readDouble(node, "s_min", lower_[1]),
+                            readDouble(node, "v_min", lower_[2]));
+        upper_ = cv::Scalar(readDouble(node, "h_max", upper_[0]), readDouble(node, "s_max", upper_[1]),
+                            readDouble(node, "v_max", upper_[2]));
+    }
+    std::vector<std::string> defaultInputs() const override { return {"blurred"}; }
+    std::string defaultOutput() const override { return "color"; }
+};
+
+// color_lut：BGR 每通道量化为 bits 位后查表，省去逐像素的 HSV 转换
+// 查表内容由各量化区间中心色经 cvtColor + inRange 预先计算
+class ColorLutStage : public ColorHsvStage {
+    int bits_ = 6;
+    std::vector<uchar> lut_;
+
+public:
+    std::string type() const override { return "color_lut"; }
+    void run(PipelineContext& ctx) override {
+        const cv::Mat& src = input(ctx);
+        CV_Assert(src.type() == CV_8UC3);
+        cv::Mat& dst = ctx.buffers[output_];
+        dst.create(src.rows, src.cols, CV_8UC1);
+
+        const int shift = 8 - bits_;
+        for (int y = 0; y < src.rows; ++y) {
+            const uchar* in = src.ptr<uchar>(y);
+            uchar* out = dst.ptr<uchar>(y);
+            for (int x = 0; x < src.cols; ++x, in += 3) {
+                size_t index = (static_cast<size_t>(in[0] >> shift) << (2 * bits_)) |
+                               (static_cast<size_t>(in[1] >> shift) << bits_) |
+                               static_cast<size_t>(in[2] >> shift);
+                out[x] = lut_[index];
+            }
+        }
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        ColorHsvStage::configureStage(node);
+        bits_ = std::min(8, std::max(4, readInt(node, "bits", bits_)));
+
+        const int levels = 1 << bits_;
+        const int shift = 8 - bits_;
+        const int half = (shift > 0) ? (1 << (shift - 1)) : 0;
+        cv::Mat bgr(1, levels * levels * levels, CV_8UC3);
+        uchar* p = bgr.ptr<uchar>(0);
+        for (int b = 0; b < levels; ++b) {
+            for (int g = 0; g < levels; ++g) {
+                for (int r = 0; r < levels; ++r) {
+                    *p++ = static_cast<uchar>((b << shift) + half);
+                    *p++ = static_cast<uchar>((g << shift) + half);
+                    *p++ = static_cast<uchar>((r << shift) + half);
+                }
+            }
+        }
+        cv::Mat hsv, mask;
+        cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+        cv::inRange(hsv, lower_, upper_, mask);
+        lut_.assign(mask.ptr<uchar>(0), mask.ptr<uchar>(0) + mask.total());
+    }
+};
+
+// brightness：灰度亮度阈值，可选闭运算（对应亮核检测）
+class BrightnessStage : public PipelineStage {
+    double low_ = 150.0;
+    double high_ = 255.0;
+    int close_ksize_ = 3;
+
+public:
+    std::string type() const override { return "brightness"; }
+    void run(PipelineContext& ctx) override {
+        cv::Mat gray;
+        cv::cvtColor(input(ctx), gray, cv::COLOR_BGR2GRAY);
+        cv::GaussianBlur(gray, gray, cv::Size(3, 3), 0.5);
+        cv::Mat& dst = ctx.buffers[output_];
+        cv::inRange(gray, low_, high_, dst);
+        if (close_ksize_ > 1) {
+            cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(close_ksize_, close_ksize_));
+            cv::morphologyEx(dst, dst, cv::MORPH_CLOSE, kernel);
+        }
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        low_ = readDouble(node, "low", low_);
+        high_ = readDouble(node, "high", high_);
+        close_ksize_ = readInt(node, "close_ksize", close_ksize_);
+    }
+    std::vector<std::string> defaultInputs() const override { return {"blurred"}; }
+    std::string defaultOutput() const override { return "bright"; }
+};
+
+// gradient：拉普拉斯梯度阈值
+class GradientStage : public PipelineStage {
+    double low_ = 30.0;
+    double high_ = 255.0;
+
+public:
+    std::string type() const override { return "gradient"; }
+    void run(PipelineContext& ctx) override {
+        cv::Mat gray, gradient;
+        cv::cvtColor(input(ctx), gray, cv::COLOR_BGR2GRAY);
+        cv::GaussianBlur(gray, gray, cv::Size(3, 3), 0.5);
+        cv::Laplacian(gray, gradient, CV_16S, 3);
+        cv::convertScaleAbs(gradient, gradient);
+        cv::inRange(gradient, low_, high_, ctx.buffers[output_]);
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        low_ = readDouble(node, "low", low_);
+        high_ = readDouble(node, "high", high_);
+    }
+    std::vector<std::string> defaultInputs() const override { return {"blurred"}; }
+    std::string defaultOutput() const override { return "gradient"; }
+};
+
+// combine：多个掩码按 and / or 组合
+class CombineStage : public PipelineStage {
+    bool use_or_ = false;
+    cv::Mat acc_;   // 跨帧复用；输出缓冲引用它，下一帧前不会被其他阶段写入
+
+public:
+    std::string type() const override { return "combine"; }
+    void run(PipelineContext& ctx) override {
+        input(ctx, 0).copyTo(acc_);
+        for (size_t i = 1; i < inputs_.size(); ++i) {
+            if (use_or_) {
+                cv::bitwise_or(acc_, input(ctx, i), acc_);
+            } else {
+                cv::bitwise_and(acc_, input(ctx, i), acc_);
+            }
+        }
+        ctx.buffers[output_] = acc_;
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        use_or_ = (readString(node, "op", "and") == "or");
+    }
+    std::vector<std::string> defaultInputs() const override { return {"color", "bright"}; }
+    std::string defaultOutput() const override { return "mask"; }
+};
+
+// morph：形态学运算；packed: 1 且 ksize 为 3 时使用位压缩实现
+class MorphStage : public PipelineStage {
+    std::string op_ = "close_open";
+    int ksize_ = 3;
+    bool packed_ = false;
+    cv::Mat kernel_;
+    BitMask bits_;
+    BitMask tmp_;
+    cv::Mat mask_;  // 跨帧复用，同 combine
+
+public:
+    std::string type() const override { return "morph"; }
+    void run(PipelineContext& ctx) override {
+        cv::Mat& mask = mask_;
+        input(ctx).copyTo(mask);
+        if (packed_ && ksize_ == 3) {
+            BitMask::pack(mask, bits_);
+            if (op_ == "close") {
+                PackedMorphology::close3x3(bits_, tmp_);
+            } else if (op_ == "open") {
+                PackedMorphology::erode3x3(bits_, tmp_);
+                PackedMorphology::dilate3x3(tmp_, bits_);
+            } else if (op_ == "erode") {
+                PackedMorphology::erode3x3(bits_, tmp_);
+                std::swap(bits_, tmp_);
+            } else if (op_ == "dilate") {
+                PackedMorphology::dilate3x3(bits_, tmp_);
+                std::swap(bits_, tmp_);
+            } else {
+                PackedMorphology::closeOpen3x3(bits_, tmp_);
+            }
+            bits_.unpack(mask);
+        } else if (op_ == "close") {
+            cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel_);
+        } else if (op_ == "open") {
+            cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel_);
+        } else if (op_ == "erode") {
+            cv::erode(mask, mask, kernel_);
+        } else if (op_ == "dilate") {
+            cv::dilate(mask, mask, kernel_);
+        } else {
+            cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel_);
+            cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel_);
+        }
+        ctx.buffers[output_] = mask;
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        op_ = readString(node, "op", op_);
+        ksize_ = readInt(node, "ksize", ksize_) | 1;
+        packed_ = readInt(node, "packed", 0) != 0;
+        kernel_ = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(ksize_, ksize_));
+    }
+    std::vector<std::string> defaultInputs() const override { return {"mask"}; }
+    std::string defaultOutput() const override { return "mask"; }
+};
+
+// label：提取候选连通域，method 为 contours（轮廓）或 components（连通域统计）
+class LabelStage : public PipelineStage {
+    bool use_components_ = false;
+
+public:
+    std::string type() const override { return "label"; }
+    void run(PipelineContext& ctx) override {
+        ctx.blobs.clear();
+        const cv::Mat& mask = input(ctx);
+
+        if (use_components_) {
+            // 连通域统计不提供周长，圆形度以 面积/外接圆面积 近似
+            cv::Mat labels, stats, centroids;
+            int count = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+            for (int i = 1; i < count; ++i) {
+                int w = stats.at<int>(i, cv::CC_STAT_WIDTH);
+                int h = stats.at<int>(i, cv::CC_STAT_HEIGHT);
+                PipelineBlob blob;
+                blob.area = stats.at<int>(i, cv::CC_STAT_AREA);
+                blob.center = cv::Point2f(static_cast<float>(centroids.at<double>(i, 0)),
+                                          static_cast<float>(centroids.at<double>(i, 1)));
+                blob.radius = 0.5f * std::max(w, h);
+                blob.circularity = (blob.radius > 0) ? blob.area / (CV_PI * blob.radius * blob.radius) : 0.0;
+                blob.aspect_ratio = static_cast<double>(w) / std::max(1, h);
+                ctx.blobs.push_back(blob);
+            }
+            return;
+        }
+
+        std::vector<std::vector<cv::Point>> contours;
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        for (const auto& contour : contours) {
+            PipelineBlob blob;
+            blob.area = cv::contourArea(contour);
+            cv::minEnclosingCircle(contour, blob.center, blob.radius);
+            double perimeter = cv::arcLength(contour, true);
+            blob.circularity = (perimeter > 0) ? (4 * CV_PI * blob.area) / (perimeter * perimeter) : 0.0;
+            cv::Rect rect = cv::boundingRect(contour);
+            blob.aspect_ratio = static_cast<double>(rect.width) / std::max(1, rect.height);
+            ctx.blobs.push_back(blob);
+        }
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        use_components_ = (readString(node, "method", "contours") == "components");
+    }
+    std::vector<std::string> defaultInputs() const override { return {"mask"}; }
+    std::string defaultOutput() const override { return "blobs"; }
+};
+
+// filter：按面积/半径/圆形度/宽高比筛选，并将结果映射回原始帧坐标
+class FilterStage : public PipelineStage {
+    double min_area_ = 20.0;
+    double max_area_ = 5000.0;
+    double min_radius_ = 3.0;
+    double max_radius_ = 80.0;
+    double min_circularity_ = 0.5;
+    double min_aspect_ = 0.6;
+    double max_aspect_ = 1.4;
+
+public:
+    std::string type() const override { return "filter"; }
+    void run(PipelineContext& ctx) override {
+        ctx.results.clear();
+        for (const auto& blob : ctx.blobs) {
+            if (blob.area < min_area_ || blob.area > max_area_) continue;
+            if (blob.radius < min_radius_ || blob.radius > max_radius_) continue;
+            if (blob.circularity < min_circularity_) continue;
+            if (blob.aspect_ratio < min_aspect_ || blob.aspect_ratio > max_aspect_) continue;
+
+            DetectionResult res;
+            res.circle = cv::Vec3f(blob.center.x / ctx.scale, blob.center.y / ctx.scale, blob.radius / ctx.scale);
+            res.confidence = blob.circularity;
+            // 面积等效直径（原始帧像素）
+            res.pixel_diameter = 2.0f * std::sqrt(static_cast<float>(blob.area / CV_PI)) / ctx.scale;
+            res.has_distance = false;
+            ctx.results.push_back(res);
+        }
+    }
+
+protected:
+    void configureStage(const cv::FileNode& node) override {
+        min_area_ = readDouble(node, "min_area", min_area_);
+        max_area_ = readDouble(node, "max_area", max_area_);
+        min_radius_ = readDouble(node, "min_radius", min_radius_);
+        max_radius_ = readDouble(node, "max_radius", max_radius_);
+        min_circularity_ = readDouble(node, "min_circularity", min_circularity_);
+        min_aspect_ = readDouble(node, "min_aspect", min_aspect_);
+        max_aspect_ = readDouble(node, "max_aspect", max_aspect_);
+    }
+    std::vector<std::string> defaultInputs() const override { return {"blobs"}; }
+    std::string defaultOutput() const override { return "results"; }
+};
+
+} // namespace
+
+void PipelineStage::configure(const cv::FileNode& node) {
+    name_ = readString(node, "name", type());
+
+    inputs_.clear();
+    cv::FileNode inputs = node["inputs"];
+    if (inputs.isSeq()) {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            inputs_.push_back(static_cast<std::string>(inputs[static_cast<int>(i)]));
+        }
+    } else if (!node["input"].empty()) {
+        inputs_.push_back(static_cast<std::string>(node["input"]));
+    }
+    if (inputs_.empty()) inputs_ = defaultInputs();
+
+    output_ = readString(node, "output", defaultOutput());
+    configureStage(node);
+}
+
+const cv::Mat& PipelineStage::input(PipelineContext& ctx, size_t index) const {
+    auto it = ctx.buffers.find(inputs_.at(index));
+    if (it == ctx.buffers.end()) {
+        throw std::runtime_error("流水线阶段 " + name_ + " 缺少输入: " + inputs_.at(index));
+    }
+    return it->second;
+}
+
+DetectionPipeline::DetectionPipeline() {}
+
+std::unique_ptr<PipelineStage> DetectionPipeline::createStage(const std::string& type) {
+    if (type == "resize") return std::make_unique<ResizeStage>();
+    if (type == "blur") return std::make_unique<BlurStage>();
+    if (type == "color_hsv") return std::make_unique<ColorHsvStage>();
+    if (type == "color_lut") return std::make_unique<ColorLutStage>();
+    if (type == "brightness") return std::make_unique<BrightnessStage>();
+    if (type == "gradient") return std::make_unique<GradientStage>();
+    if (type == "combine") return std::make_unique<CombineStage>();
+    if (type == "morph") return std::make_unique<MorphStage>();
+    if (type == "label") return std::make_unique<LabelStage>();
+    if (type == "filter") return std::make_unique<FilterStage>();
+    return nullptr;
+}
+
+bool DetectionPipeline::load(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开流水线配置文件: " << file_name << std::endl;
+        return false;
+    }
+
+    cv::FileNode stages = fs["stages"];
+    if (!stages.isSeq() || stages.size() == 0) {
+        std::cerr << "流水线配置缺少 stages 序列: " << file_name << std::endl;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<PipelineStage>> loaded;
+    std::set<std::string> available = {"frame"};
+    bool has_filter = false;
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        cv::FileNode node = stages[static_cast<int>(i)];
+        std::string type = readString(node, "type", "");
+        std::unique_ptr<PipelineStage> stage = createStage(type);
+        if (!stage) {
+            std::cerr << "未知的流水线阶段类型: '" << type << "' (第 " << i + 1 << " 个阶段)" << std::endl;
+            return false;
+        }
+        stage->configure(node);
+
+        // 校验输入均已由前面的阶段产生
+        for (const auto& in : stage->inputs()) {
+            if (available.count(in) == 0) {
+                std::cerr << "流水线阶段 " << stage->name() << " 的输入 '" << in << "' 未由前序阶段产生" << std::endl;
+                return false;
+            }
+        }
+        available.insert(stage->output());
+        has_filter = has_filter || (type == "filter");
+        loaded.push_back(std::move(stage));
+    }
+
+    if (!has_filter) {
+        std::cerr << "流水线配置必须以 filter 阶段输出检测结果" << std::endl;
+        return false;
+    }
+
+    stages_ = std::move(loaded);
+    source_ = file_name;
+    resetTimings();
+
+    std::cout << "已加载检测流水线: " << file_name << " (" << stages_.size() << " 个阶段)" << std::endl;
+    return true;
+}
+
+void DetectionPipeline::run(const cv::Mat& frame, std::vector<DetectionResult>& results) {
+    // 保留上一帧的中间缓冲，尺寸不变时各阶段直接复用，不再每帧重新分配
+    context_.buffers["frame"] = frame;
+    context_.scale = 1.0f;
+    context_.blobs.clear();
+    context_.results.clear();
+
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        stages_[i]->run(context_);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        StageTiming& timing = timings_[i];
+        timing.last_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        timing.total_ms += timing.last_ms;
+        timing.calls++;
+    }
+
+    results = context_.results;
+}
+
+cv::Mat DetectionPipeline::getBuffer(const std::string& name) const {
+    auto it = context_.buffers.find(name);
+    return (it != context_.buffers.end()) ? it->second : cv::Mat();
+}
+
+void DetectionPipeline::resetTimings() {
+    timings_.clear();
+    for (const auto& stage : stages_) {
+        StageTiming timing;
+        timing.name = stage->name();
+        timing.type = stage->type();
+        timings_.push_back(timing);
+    }
+}
+
+void DetectionPipeline::printTimings() const {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "=== 流水线阶段耗时 (" << source_ << ") ===" << std::endl;
+    double total = 0.0;
+    for (const auto& timing : timings_) {
+        double avg = (timing.calls > 0) ? timing.total_ms / timing.calls : 0.0;
+        total += avg;
+        std::cout << std::left << std::setw(16) << timing.name
+                  << std::setw(12) << timing.type
+                  << " 平均: " << std::fixed << std::setprecision(3) << avg << "ms"
+                  << "  最近: " << timing.last_ms << "ms" << std::endl;
+    }
+    std::cout << "合计平均: " << total << "ms" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,96 @@
+#ifndef DETECTIONPIPELINE_H
+#define DETECTIONPIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DetectionResult.h"
+#include "PackedMorphology.h"
+
+// 候选连通域（label 阶段输出，坐标为缩放后图像坐标）
+struct PipelineBlob {
+    cv::Point2f center;     // 最小外接圆圆心
+    float radius;           // 最小外接圆半径
+    double area;            // 面积
+    double circularity;     // 圆形度
+    double aspect_ratio;    // 外接矩形宽高比
+};
+
+// 流水线运行上下文：按名称存放中间图像，"frame" 为原始输入帧
+struct PipelineContext {
+    std::map<std::string, cv::Mat> buffers;
+    float scale = 1.0f;                    // resize 阶段写入的缩放因子
+    std::vector<PipelineBlob> blobs;
+    std::vector<DetectionResult> results;
+};
+
+// 流水线阶段基类
+class PipelineStage {
+public:
+    virtual ~PipelineStage() = default;
+
+    // 读取公共字段（name/input/output）后调用 configureStage 读取阶段参数
+    void configure(const cv::FileNode& node);
+    virtual void run(PipelineContext& ctx) = 0;
+
+    virtual std::string type() const = 0;
+    const std::string& name() const { return name_; }
+    const std::vector<std::string>& inputs() const { return inputs_; }
+    const std::string& output() const { return output_; }
+
+protected:
+    virtual void configureStage(const cv::FileNode& node) = 0;
+    // 阶段未在配置中指定 input/output 时使用的默认名称
+    virtual std::vector<std::string> defaultInputs() const = 0;
+    virtual std::string defaultOutput() const = 0;
+
+    const cv::Mat& input(PipelineContext& ctx, size_t index = 0) const;
+
+    std::string name_;
+    std::vector<std::string> inputs_;
+    std::string output_;
+};
+
+// 单个阶段的耗时统计
+struct StageTiming {
+    std::string name;
+    std::string type;
+    double last_ms = 0.0;
+    double total_ms = 0.0;
+    long calls = 0;
+};
+
+// 可配置的检测流水线：阶段按配置顺序依次执行，每个阶段单独计时
+class DetectionPipeline {
+private:
+    std::vector<std::unique_ptr<PipelineStage>> stages_;
+    std::vector<StageTiming> timings_;
+    PipelineContext context_;
+    std::string source_;
+
+public:
+    DetectionPipeline();
+
+    // 从 YAML 文件加载（cv::FileStorage 格式，顶层为 stages 序列）
+    bool load(const std::string& file_name);
+
+    // 按阶段类型创建实例，未知类型返回空指针
+    static std::unique_ptr<PipelineStage> createStage(const std::string& type);
+
+    // 执行流水线，results 中的坐标与 pixel_diameter 已映射回原始帧像素
+    void run(const cv::Mat& frame, std::vector<DetectionResult>& results);
+
+    bool empty() const { return stages_.empty(); }
+    const std::string& source() const { return source_; }
+
+    // 获取中间结果（不存在时返回空矩阵）
+    cv::Mat getBuffer(const std::string& name) const;
+
+    const std::vector<StageTiming>& getTimings() const { return timings_; }
+    void resetTimings();
+    void printTimings() const;
+};
+
+#endif // DETECTIONPIPELINE_H
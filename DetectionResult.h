@@ -4,15 +4,24 @@
 #include <opencv2/opencv.hpp>
 
 struct DetectionResult {
-    cv::Vec3f circle;      // x, y, radius (像素半径)
+    cv::Vec3f circle;      // x, y, radius（原始帧像素）
     double confidence;     // 检测置信度
     float distance;        // 距离（米）
     bool has_distance;     // 是否有有效距离
     
-    // 新增字段：像素直径（可选，半径×2即可）
-    float pixel_diameter;  // 像素直径，方便调试
+    // 面积等效直径，与 circle 一样是原始帧像素（检测在缩放图上进行时已除以缩放因子），测距直接使用
+    float pixel_diameter;
     
-    DetectionResult() : confidence(0.0), distance(-1.0f), has_distance(false), pixel_diameter(0.0f) {}
+    float distance_variance;  // 距离方差（米^2）：双目为单帧视差噪声传播，时域融合后为滤波方差；单目单帧为 -1
+    
+    // 完整内参模型的输出（相机坐标系：x 右, y 下, z 前）
+    cv::Point3f position;  // 目标中心三维位置（米）
+    float yaw;             // 水平方位角（弧度），目标在右为正
+    float pitch;           // 俯仰角（弧度），目标在上为正
+    bool has_position;     // 是否有有效的三维位置
+    
+    DetectionResult() : confidence(0.0), distance(-1.0f), has_distance(false), pixel_diameter(0.0f),
+                        distance_variance(-1.0f), yaw(0.0f), pitch(0.0f), has_position(false) {}
 };
 
 #endif // DETECTIONRESULT_H
\ No newline at end of file
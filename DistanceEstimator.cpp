@@ -1,8 +1,18 @@
 #include "DistanceEstimator.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 DistanceEstimator::DistanceEstimator() 
-    : focal_length_(1000.0f), real_world_diameter_(0.055f) {} // 默认焦距和55mm直径
+    : focal_length_(1000.0f), real_world_diameter_(0.055f), // 默认焦距和55mm直径
+      has_intrinsics_(false),
+      undistorter_(nullptr),
+      pixel_noise_(0.7f),
+      process_noise_(1e-5f),
+      hampel_window_(7),
+      hampel_k_(3.0f),
+      max_valid_std_ratio_(0.1f),
+      track_timeout_ms_(1000.0) {}
 
 void DistanceEstimator::setTargetParameters(float focal_length, float real_world_diameter) {
     focal_length_ = focal_length;
@@ -11,6 +21,98 @@ void DistanceEstimator::setTargetParameters(float focal_length, float real_world
               << "px, 真实直径=" << real_world_diameter_ * 1000 << "mm" << std::endl;
 }
 
+void DistanceEstimator::setIntrinsics(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs,
+                                      const cv::Size& calibration_size) {
+    if (camera_matrix.rows != 3 || camera_matrix.cols != 3) {
+        std::cerr << "[DistanceEstimator] 相机矩阵尺寸无效" << std::endl;
+        return;
+    }
+    camera_matrix.convertTo(camera_matrix_, CV_64F);
+    if (dist_coeffs.empty()) {
+        dist_coeffs_ = cv::Mat::zeros(5, 1, CV_64F);
+    } else {
+        dist_coeffs.convertTo(dist_coeffs_, CV_64F);
+    }
+    has_intrinsics_ = true;
+    calibration_size_ = calibration_size;
+    frame_size_ = cv::Size();
+    frame_camera_matrix_ = camera_matrix_.clone();
+
+    // 仅在没有内参时使用的单焦距模型也同步更新
+    focal_length_ = static_cast<float>((camera_matrix_.at<double>(0, 0) + camera_matrix_.at<double>(1, 1)) / 2.0);
+    std::cout << "[DistanceEstimator] 使用完整内参: fx=" << camera_matrix_.at<double>(0, 0)
+              << ", fy=" << camera_matrix_.at<double>(1, 1)
+              << ", cx=" << camera_matrix_.at<double>(0, 2)
+              << ", cy=" << camera_matrix_.at<double>(1, 2)
+              << ", 畸变系数 " << dist_coeffs_.total() << " 个" << std::endl;
+}
+
+bool DistanceEstimator::loadCalibration(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开标定参数文件: " << file_name << std::endl;
+        return false;
+    }
+
+    cv::Mat camera_matrix, dist_coeffs;
+    fs["cameraMatrix"] >> camera_matrix;
+    if (camera_matrix.empty()) {
+        fs["camera_matrix"] >> camera_matrix;
+    }
+    fs["distCoeffs"] >> dist_coeffs;
+    if (dist_coeffs.empty()) {
+        fs["dist_coeffs"] >> dist_coeffs;
+    }
+    if (camera_matrix.empty()) {
+        // 双目标定文件：使用左相机内参
+        fs["K1"] >> camera_matrix;
+        fs["D1"] >> dist_coeffs;
+    }
+    if (camera_matrix.empty()) {
+        std::cerr << "标定参数文件中没有相机矩阵: " << file_name << std::endl;
+        return false;
+    }
+
+    setIntrinsics(camera_matrix, dist_coeffs, readCalibrationSize(fs, camera_matrix));
+    return has_intrinsics_;
+}
+
+void DistanceEstimator::setSensorMode(const SensorMode& mode) {
+    sensor_mode_ = mode;
+    frame_size_ = cv::Size();   // 下一帧重新换算
+}
+
+bool DistanceEstimator::setFrameSize(const cv::Size& frame_size) {
+    if (!has_intrinsics_ || frame_size == frame_size_) {
+        return false;
+    }
+    frame_size_ = frame_size;
+    float scale = sensor_mode_.scale(frame_size, calibration_size_);
+    frame_camera_matrix_ = sensor_mode_.frameCameraMatrix(camera_matrix_, scale);
+    focal_length_ = static_cast<float>((frame_camera_matrix_.at<double>(0, 0) + frame_camera_matrix_.at<double>(1, 1)) / 2.0);
+    if (scale != 1.0f || sensor_mode_.roi_offset.x != 0.0f || sensor_mode_.roi_offset.y != 0.0f) {
+        std::cout << "[DistanceEstimator] 帧尺寸 " << frame_size.width << "x" << frame_size.height
+                  << "，按 ROI (" << sensor_mode_.roi_offset.x << ", " << sensor_mode_.roi_offset.y << ") / "
+                  << scale << " 倍缩放换算内参: fx=" << frame_camera_matrix_.at<double>(0, 0)
+                  << ", cx=" << frame_camera_matrix_.at<double>(0, 2)
+                  << ", cy=" << frame_camera_matrix_.at<double>(1, 2) << std::endl;
+    }
+    return true;
+}
+
+cv::Point3f DistanceEstimator::pixelToRay(const cv::Point2f& pixel) const {
+    cv::Point2f normalized;
+    if (has_intrinsics_) {
+        std::vector<cv::Point2f> src(1, pixel), dst;
+        cv::undistortPoints(src, dst, frame_camera_matrix_, dist_coeffs_);
+        normalized = dst[0];
+    } else {
+        normalized = cv::Point2f(pixel.x / focal_length_, pixel.y / focal_length_);
+    }
+    float norm = std::sqrt(normalized.x * normalized.x + normalized.y * normalized.y + 1.0f);
+    return cv::Point3f(normalized.x / norm, normalized.y / norm, 1.0f / norm);
+}
+
 float DistanceEstimator::estimateDistanceFromDiameter(float pixel_diameter) const {
     if (pixel_diameter <= 0 || focal_length_ <= 0 || real_world_diameter_ <= 0) {
         return -1.0f;
@@ -33,7 +135,68 @@ float DistanceEstimator::estimateDistanceFromRadius(float pixel_radius) const {
     return distance;
 }
 
+void DistanceEstimator::estimateWithIntrinsics(std::vector<DetectionResult>& results) const {
+    // 每个目标取中心和上下左右四个边缘点，一次 undistortPoints 处理全部检测点
+    const int POINTS_PER_TARGET = 5;
+    std::vector<cv::Point2f> pixels;
+    pixels.reserve(results.size() * POINTS_PER_TARGET);
+    for (const auto& res : results) {
+        float cx = res.circle[0], cy = res.circle[1];
+        // pixel_diameter 与 circle 同为原始帧像素
+        float r = (res.pixel_diameter > 0) ? res.pixel_diameter / 2.0f : res.circle[2];
+        pixels.push_back(cv::Point2f(cx, cy));
+        pixels.push_back(cv::Point2f(cx - r, cy));
+        pixels.push_back(cv::Point2f(cx + r, cy));
+        pixels.push_back(cv::Point2f(cx, cy - r));
+        pixels.push_back(cv::Point2f(cx, cy + r));
+    }
+    std::vector<cv::Point2f> normalized;
+    if (undistorter_ != nullptr && undistorter_->isReady()) {
+        undistorter_->normalizePoints(pixels, normalized);
+    } else {
+        cv::undistortPoints(pixels, normalized, frame_camera_matrix_, dist_coeffs_);
+    }
+
+    auto toRay = [](const cv::Point2f& p) {
+        cv::Point3d ray(p.x, p.y, 1.0);
+        return ray * (1.0 / cv::norm(ray));
+    };
+    auto angleBetween = [](const cv::Point3d& a, const cv::Point3d& b) {
+        return std::acos(std::max(-1.0, std::min(1.0, a.dot(b))));
+    };
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        DetectionResult& res = results[i];
+        const cv::Point2f* p = &normalized[i * POINTS_PER_TARGET];
+        cv::Point3d center = toRay(p[0]);
+
+        // 目标张角：水平和垂直两个方向取平均，偏离光轴时不会像单焦距模型那样低估
+        double angle = 0.5 * (angleBetween(toRay(p[1]), toRay(p[2])) + angleBetween(toRay(p[3]), toRay(p[4])));
+        if (angle <= 0.0) {
+            res.has_distance = false;
+            res.has_position = false;
+            continue;
+        }
+
+        // 斜距：直径为 D 的球在张角 angle 下的距离
+        double range = real_world_diameter_ / (2.0 * std::tan(angle / 2.0));
+        res.distance = static_cast<float>(range);
+        res.has_distance = isDistanceValid(res.distance);
+
+        res.position = cv::Point3f(static_cast<float>(center.x * range),
+                                   static_cast<float>(center.y * range),
+                                   static_cast<float>(center.z * range));
+        res.yaw = static_cast<float>(std::atan2(center.x, center.z));
+        res.pitch = static_cast<float>(std::atan2(-center.y, std::sqrt(center.x * center.x + center.z * center.z)));
+        res.has_position = res.has_distance;
+    }
+}
+
 void DistanceEstimator::estimateDistances(std::vector<DetectionResult>& results) const {
+    if (has_intrinsics_) {
+        estimateWithIntrinsics(results);
+        return;
+    }
     for (auto& res : results) {
         if (res.pixel_diameter > 0) {
             // 使用像素直径计算距离
@@ -46,7 +209,7 @@ void DistanceEstimator::estimateDistances(std::vector<DetectionResult>& results)
     }
 }
 
-bool DistanceEstimator::isDistanceValid(float distance) const {
+bool DistanceEstimator::isDistanceValid(float distance) {
     return (distance > 0.1f && distance < 100.0f);  // 0.1m - 100m 有效范围
 }
 
@@ -55,4 +218,137 @@ std::string DistanceEstimator::formatDistance(float distance) const {
         return "N/A";
     }
     return std::to_string(static_cast<int>(distance * 100)) + "cm"; // 返回厘米
-}
\ No newline at end of file
+}
+
+void DistanceEstimator::setFusionParameters(float pixel_noise, float process_noise, int hampel_window, float hampel_k) {
+    pixel_noise_ = pixel_noise;
+    process_noise_ = process_noise;
+    hampel_window_ = std::max(3, std::min(hampel_window, static_cast<int>(RangeTrackState::MAX_WINDOW)));
+    hampel_k_ = hampel_k;
+}
+
+bool DistanceEstimator::isOutlier(const RangeTrackState& state, float rho) const {
+    if (state.window_count < 3) {
+        return false;
+    }
+
+    // 窗口中位数与 MAD（窗口长度固定，开销为常数）
+    std::array<float, RangeTrackState::MAX_WINDOW> values;
+    int n = state.window_count;
+    std::copy(state.window.begin(), state.window.begin() + n, values.begin());
+    std::nth_element(values.begin(), values.begin() + n / 2, values.begin() + n);
+    float median = values[n / 2];
+    for (int i = 0; i < n; ++i) {
+        values[i] = std::fabs(values[i] - median);
+    }
+    std::nth_element(values.begin(), values.begin() + n / 2, values.begin() + n);
+    float mad_sigma = 1.4826f * values[n / 2];
+
+    // 直径量化会使 MAD 为 0，用观测噪声作为下限
+    float measurement_sigma = pixel_noise_ / (focal_length_ * real_world_diameter_);
+    return std::fabs(rho - median) > hampel_k_ * std::max(mad_sigma, measurement_sigma);
+}
+
+RangeEstimate DistanceEstimator::updateTrack(int track_id, float pixel_diameter, double timestamp_ms) {
+    if (pixel_diameter <= 0 || focal_length_ <= 0 || real_world_diameter_ <= 0) {
+        return getTrackRange(track_id);
+    }
+    return updateTrackInverseRange(track_id, pixel_diameter / (focal_length_ * real_world_diameter_),
+                                   monocularRhoVariance(), timestamp_ms);
+}
+
+RangeEstimate DistanceEstimator::updateTrackRange(int track_id, float range, double timestamp_ms, float range_variance) {
+    if (range <= 0) {
+        return getTrackRange(track_id);
+    }
+    double rho = 1.0 / range;
+    if (range_variance > 0) {
+        // 一阶传播：rho = 1/Z，var(rho) = var(Z) * rho^4
+        return updateTrackInverseRange(track_id, static_cast<float>(rho),
+                                       range_variance * rho * rho * rho * rho, timestamp_ms);
+    }
+    if (focal_length_ <= 0 || real_world_diameter_ <= 0) {
+        return getTrackRange(track_id);
+    }
+    return updateTrackInverseRange(track_id, static_cast<float>(rho), monocularRhoVariance(), timestamp_ms);
+}
+
+// 单目观测在逆距离上的方差：像素直径噪声 / (f * D)
+double DistanceEstimator::monocularRhoVariance() const {
+    double scale = focal_length_ * real_world_diameter_;
+    return (pixel_noise_ / scale) * (pixel_noise_ / scale);
+}
+
+RangeEstimate DistanceEstimator::updateTrackInverseRange(int track_id, float rho, double measurement_var,
+                                                         double timestamp_ms) {
+    auto found = tracks_.find(track_id);
+    if (found == tracks_.end()) {
+        // 只在新建轨迹时丢弃超时的轨迹，逐帧更新不遍历
+        for (auto it = tracks_.begin(); it != tracks_.end();) {
+            if (timestamp_ms - it->second.last_update_ms > track_timeout_ms_) {
+                it = tracks_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        found = tracks_.emplace(track_id, RangeTrackState()).first;
+    }
+
+    RangeTrackState& state = found->second;
+    if (state.updates == 0) {
+        state.rho = rho;
+        state.rho_var = measurement_var;
+        state.updates = 1;
+    } else {
+        // 预测：逆距离随机游走
+        double dt_s = std::max(0.0, (timestamp_ms - state.last_update_ms) / 1000.0);
+        state.rho_var += process_noise_ * dt_s;
+
+        // Hampel 判定为离群的观测不参与更新，但仍进入窗口，使真实的距离跳变能在半个窗口后被接受
+        if (isOutlier(state, rho)) {
+            state.rejected++;
+        } else {
+            double gain = state.rho_var / (state.rho_var + measurement_var);
+            state.rho += gain * (rho - state.rho);
+            state.rho_var *= (1.0 - gain);
+            state.updates++;
+        }
+    }
+    state.last_update_ms = timestamp_ms;
+
+    state.window[state.window_pos] = rho;
+    state.window_pos = (state.window_pos + 1) % hampel_window_;
+    state.window_count = std::min(state.window_count + 1, hampel_window_);
+
+    return makeEstimate(track_id, state);
+}
+
+RangeEstimate DistanceEstimator::makeEstimate(int track_id, const RangeTrackState& state) const {
+    RangeEstimate estimate;
+    estimate.track_id = track_id;
+    if (state.updates == 0 || state.rho <= 0) {
+        return estimate;
+    }
+
+    // 一阶传播：Z = 1/rho，var(Z) = var(rho) / rho^4
+    double rho2 = state.rho * state.rho;
+    estimate.range = static_cast<float>(1.0 / state.rho);
+    estimate.variance = static_cast<float>(state.rho_var / (rho2 * rho2));
+    estimate.valid = state.updates >= 3 &&
+                     isDistanceValid(estimate.range) &&
+                     std::sqrt(estimate.variance) <= max_valid_std_ratio_ * estimate.range;
+    return estimate;
+}
+
+RangeEstimate DistanceEstimator::getTrackRange(int track_id) const {
+    auto it = tracks_.find(track_id);
+    return (it != tracks_.end()) ? makeEstimate(track_id, it->second) : RangeEstimate();
+}
+
+void DistanceEstimator::dropTrack(int track_id) {
+    tracks_.erase(track_id);
+}
+
+void DistanceEstimator::resetTracks() {
+    tracks_.clear();
+}
@@ -2,21 +2,94 @@
 #define DISTANCEESTIMATOR_H
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <map>
 #include <vector>
 #include <iostream>
 #include "DetectionResult.h"
+#include "SensorMode.h"
+#include "Undistorter.h"
+
+// 融合后的距离估计
+struct RangeEstimate {
+    float range = -1.0f;      // 距离（米）
+    float variance = -1.0f;   // 距离方差（米^2）
+    bool valid = false;       // 样本数足够且标准差在允许范围内
+    int track_id = -1;
+};
+
+// 单条轨迹的距离滤波状态：Hampel 窗口 + 逆距离卡尔曼滤波
+// 逆距离 rho = 像素直径 / (焦距 × 真实直径)，像素噪声在 rho 上是加性常数噪声
+struct RangeTrackState {
+    static const int MAX_WINDOW = 9;
+    std::array<float, MAX_WINDOW> window;   // 最近的 rho 观测（环形缓冲）
+    int window_count = 0;
+    int window_pos = 0;
+    double rho = 0.0;                       // 逆距离估计（1/米）
+    double rho_var = 0.0;                   // 逆距离方差
+    double last_update_ms = 0.0;
+    int updates = 0;
+    int rejected = 0;
+};
 
 class DistanceEstimator {
 private:
     float focal_length_;           // 焦距（像素）
     float real_world_diameter_;    // 目标真实直径（米）
     
+    // 完整内参（针孔 + 畸变），加载标定后用于计算距离、三维位置和方位角
+    cv::Mat camera_matrix_;        // 3x3, CV_64F，标定分辨率
+    cv::Mat dist_coeffs_;
+    bool has_intrinsics_;
+    cv::Size calibration_size_;    // 标定图像尺寸，为空表示帧与标定同分辨率
+    SensorMode sensor_mode_;
+    cv::Size frame_size_;
+    cv::Mat frame_camera_matrix_;  // 按 sensor_mode_ 换算到当前帧像素的内参
+    const Undistorter* undistorter_;   // 可选：预计算的检测点查找表，不为空时替代逐点求解
+    
+    // 时域融合参数
+    float pixel_noise_;            // 像素直径观测噪声标准差（像素）
+    float process_noise_;          // 逆距离随机游走强度（(1/米)^2 每秒）
+    int hampel_window_;            // Hampel 窗口长度（<= RangeTrackState::MAX_WINDOW）
+    float hampel_k_;               // 离群判定倍数（MAD 标准差的倍数）
+    float max_valid_std_ratio_;    // 有效判定：距离标准差 / 距离 的上限
+    double track_timeout_ms_;      // 轨迹超时后丢弃其滤波状态
+    std::map<int, RangeTrackState> tracks_;
+    
+    RangeEstimate makeEstimate(int track_id, const RangeTrackState& state) const;
+    bool isOutlier(const RangeTrackState& state, float rho) const;
+    double monocularRhoVariance() const;
+    RangeEstimate updateTrackInverseRange(int track_id, float rho, double measurement_var, double timestamp_ms);
+    void estimateWithIntrinsics(std::vector<DetectionResult>& results) const;
+    
 public:
     DistanceEstimator();
     
     // 设置目标参数
     void setTargetParameters(float focal_length, float real_world_diameter);
     
+    // 设置完整内参：只对检测点做去畸变，不处理整幅图像
+    void setIntrinsics(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs,
+                       const cv::Size& calibration_size = cv::Size());
+    
+    // 从标定文件加载内参（兼容 cameraMatrix / camera_matrix 两种键名）
+    bool loadCalibration(const std::string& file_name);
+    bool hasIntrinsics() const { return has_intrinsics_; }
+    
+    // ROI / 像素合并（与 AlignmentController 使用同一配置），帧尺寸变化时按它换算内参；
+    // 内参发生变化时返回 true，调用方据此重建去畸变查找表
+    void setSensorMode(const SensorMode& mode);
+    bool setFrameSize(const cv::Size& frame_size);
+    // 当前帧像素下的等效内参，去畸变查找表应使用它
+    const cv::Mat& getCameraMatrix() const { return frame_camera_matrix_; }
+    const cv::Mat& getDistCoeffs() const { return dist_coeffs_; }
+    
+    // 使用缓存的查找表对检测点去畸变（须与 getCameraMatrix() 及帧尺寸一致，由调用方保证其生命周期）
+    void setUndistorter(const Undistorter* undistorter) { undistorter_ = undistorter; }
+    
+    // 像素点 -> 相机坐标系单位方向向量（x 右, y 下, z 前），考虑主点和畸变
+    cv::Point3f pixelToRay(const cv::Point2f& pixel) const;
+    
     // 使用像素直径计算距离
     float estimateDistanceFromDiameter(float pixel_diameter) const;
     
@@ -27,7 +100,7 @@ public:
     void estimateDistances(std::vector<DetectionResult>& results) const;
     
     // 验证距离是否有效
-    bool isDistanceValid(float distance) const;
+    static bool isDistanceValid(float distance);
     
     // 格式化距离显示
     std::string formatDistance(float distance) const;
@@ -35,6 +108,16 @@ public:
     // 获取焦距
     float getFocalLength() const { return focal_length_; }
     
+    // 时域融合：按轨迹 ID 融合连续帧的像素直径观测，每次更新 O(1)
+    RangeEstimate updateTrack(int track_id, float pixel_diameter, double timestamp_ms);
+    // 以单帧距离（米）作为观测，用于完整内参模型算出的斜距或双目三角化距离；
+    // range_variance > 0 时按该观测方差（米^2，如双目视差噪声传播）融合，否则按单目像素噪声
+    RangeEstimate updateTrackRange(int track_id, float range, double timestamp_ms, float range_variance = -1.0f);
+    RangeEstimate getTrackRange(int track_id) const;
+    void dropTrack(int track_id);
+    void resetTracks();
+    void setFusionParameters(float pixel_noise, float process_noise, int hampel_window, float hampel_k);
+    
     // 重命名 setCameraParameters 为兼容方法
     void setCameraParameters(float focal_length, float real_world_diameter) { 
         setTargetParameters(focal_length, real_world_diameter); 
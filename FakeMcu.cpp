@@ -0,0 +1,170 @@
+#include "FakeMcu.h"
+#include "SerialLowLatency.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+FakeMcu::FakeMcu(const FakeMcuConfig& config)
+    : config_(config),
+      master_fd_(-1),
+      slave_fd_(-1),
+      running_(false),
+      plant_(config.plant),
+      line_free_in_(0.0),
+      line_free_out_(0.0) {
+}
+
+FakeMcu::~FakeMcu() {
+    close();
+}
+
+bool FakeMcu::open() {
+    if (running_) {
+        return true;
+    }
+    master_fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master_fd_ < 0 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0) {
+        std::cerr << "无法创建伪终端: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    char name[128];
+    if (ptsname_r(master_fd_, name, sizeof(name)) != 0) {
+        std::cerr << "无法获取伪终端从机端: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    slave_path_ = name;
+    slave_fd_ = ::open(name, O_RDWR | O_NOCTTY);
+    if (slave_fd_ < 0) {
+        std::cerr << "无法打开伪终端从机端 " << slave_path_ << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    // 主机连接前也不回显
+    struct termios tty;
+    if (tcgetattr(slave_fd_, &tty) == 0) {
+        cfmakeraw(&tty);
+        tcsetattr(slave_fd_, TCSANOW, &tty);
+    }
+
+    plant_.reset();
+    stats_ = FakeMcuStats();
+    outgoing_.clear();
+    line_free_in_ = 0.0;
+    line_free_out_ = 0.0;
+    running_ = true;
+    thread_ = std::thread(&FakeMcu::run, this);
+    return true;
+}
+
+void FakeMcu::close() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (slave_fd_ >= 0) {
+        ::close(slave_fd_);
+        slave_fd_ = -1;
+    }
+    if (master_fd_ >= 0) {
+        ::close(master_fd_);
+        master_fd_ = -1;
+    }
+}
+
+int FakeMcu::lineBaud() const {
+    // 伪终端主机端的 termios 请求作用于从机端，读到的就是主机 SerialPort 设置的波特率（含 termios2 的非标准值）
+    return readBaudRate(master_fd_);
+}
+
+void FakeMcu::run() {
+    const auto start = std::chrono::steady_clock::now();
+    auto now_s = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    uint8_t buffer[256];
+    while (running_) {
+        // 最多等 1ms：转台仿真与遥测按实时推进
+        double wait_s = 1e-3;
+        if (!outgoing_.empty()) {
+            wait_s = std::max(0.0, std::min(wait_s, outgoing_.front().first - now_s()));
+        }
+        struct timespec timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = static_cast<long>(wait_s * 1e9);
+        struct pollfd pfd;
+        pfd.fd = master_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = ppoll(&pfd, 1, &timeout, nullptr);
+
+        double now = now_s();
+        int baud = lineBaud();
+        double byte_s = (config_.emulate_line_rate && baud > 0) ? 10.0 / baud : 0.0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.line_baud = baud;
+        plant_.advanceTo(now);
+        // 遥测：advanceTo 中产生。与固件一样，发送缓冲区还有数据（低波特率下线路跟不上遥测频率）时丢弃本次遥测，
+        // 避免 ACK 排在无限增长的遥测后面
+        std::vector<uint8_t> output = plant_.takeOutput();
+        if (!output.empty()) {
+            if (line_free_out_ <= now) {
+                line_free_out_ = now + output.size() * byte_s;
+                outgoing_.emplace_back(line_free_out_, std::move(output));
+            } else {
+                stats_.telemetry_skipped++;
+            }
+        }
+
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            ssize_t n = read(master_fd_, buffer, sizeof(buffer));
+            if (n > 0) {
+                // 整块读到的字节按线速依次到达，最后一个字节到达后固件才能处理整帧
+                line_free_in_ = std::max(line_free_in_, now) + n * byte_s;
+                stats_.bytes_in += static_cast<unsigned long>(n);
+                plant_.feed(buffer, static_cast<size_t>(n), line_free_in_);
+                std::vector<uint8_t> replies = plant_.takeOutput();
+                if (!replies.empty()) {
+                    double release = line_free_in_ + config_.processing_delay_ms * 1e-3;
+                    line_free_out_ = std::max(line_free_out_, release) + replies.size() * byte_s;
+                    outgoing_.emplace_back(line_free_out_, std::move(replies));
+                }
+            }
+        }
+
+        now = now_s();
+        while (!outgoing_.empty() && outgoing_.front().first <= now) {
+            const std::vector<uint8_t>& bytes = outgoing_.front().second;
+            // 主机不读时伪终端缓冲区会满，与真实 UART 溢出一样直接丢弃
+            ssize_t written = write(master_fd_, bytes.data(), bytes.size());
+            if (written > 0) {
+                stats_.bytes_out += static_cast<unsigned long>(written);
+            }
+            outgoing_.pop_front();
+        }
+    }
+}
+
+FakeMcuStats FakeMcu::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FakeMcuStats stats = stats_;
+    stats.commands = plant_.getFrameCount();
+    stats.acks = plant_.getAckCount();
+    stats.rejected_bytes = plant_.getRejectedBytes();
+    stats.commanded_rate = plant_.getCommandedRate();
+    stats.watchdog_trips = plant_.getWatchdogTrips();
+    return stats;
+}
+
+double FakeMcu::getCameraAngle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return plant_.getCameraAngle();
+}
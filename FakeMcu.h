@@ -0,0 +1,72 @@
+#ifndef FAKEMCU_H
+#define FAKEMCU_H
+
+#include "PlantSimulator.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FakeMcuConfig {
+    PlantConfig plant;                  // 下位机背后的转台仿真（回复 ACK、上报遥测）
+    double processing_delay_ms = 0.2;   // 固件收到完整帧到开始回复
+    bool emulate_line_rate = true;      // 按从机端设置的波特率模拟线路传输时间（伪终端本身没有波特率）
+};
+
+struct FakeMcuStats {
+    unsigned long bytes_in = 0;
+    unsigned long bytes_out = 0;
+    long commands = 0;          // 转台收到并生效的指令
+    long acks = 0;
+    long rejected_bytes = 0;
+    long telemetry_skipped = 0; // 线路忙而跳过的遥测
+    int line_baud = 0;          // 主机当前设置的波特率
+    double commanded_rate = 0.0;   // 转台当前执行的指令角速度（弧度/秒）
+    long watchdog_trips = 0;       // 看门狗超时停止电机的次数
+};
+
+// 伪终端上的假下位机：打开一对 pty，主机侧把从机端（/dev/pts/N）当普通串口连接，
+// 本对象在主机端以实时时钟运行 PlantSimulator：解析指令、回复 ACK、周期性上报遥测。
+// 用于在任意 Linux 机器上端到端测试 SerialPort / MotorController（dart_bench loopback / fakemcu）。
+class FakeMcu {
+private:
+    FakeMcuConfig config_;
+    int master_fd_;
+    int slave_fd_;                 // 自己保持从机端打开：主机断开重连期间主机端不会读到挂断
+    std::string slave_path_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    mutable std::mutex mutex_;     // 保护 plant_ 与统计
+    PlantSimulator plant_;
+    FakeMcuStats stats_;
+
+    // 待发送给主机的字节及其全部到达主机的时刻（秒，相对启动）
+    std::deque<std::pair<double, std::vector<uint8_t>>> outgoing_;
+    double line_free_in_;          // 主机 -> 下位机方向线路空闲的时刻
+    double line_free_out_;         // 下位机 -> 主机方向
+
+    void run();
+    int lineBaud() const;
+
+public:
+    explicit FakeMcu(const FakeMcuConfig& config = FakeMcuConfig());
+    ~FakeMcu();
+    FakeMcu(const FakeMcu&) = delete;
+    FakeMcu& operator=(const FakeMcu&) = delete;
+
+    // 创建伪终端并启动下位机线程；失败时打印原因返回 false
+    bool open();
+    void close();
+    bool isOpen() const { return running_; }
+
+    // 主机应连接的设备路径
+    const std::string& getSlavePath() const { return slave_path_; }
+    FakeMcuStats getStats() const;
+    double getCameraAngle() const;
+};
+
+#endif // FAKEMCU_H
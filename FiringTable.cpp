@@ -0,0 +1,261 @@
+#include "FiringTable.h"
+#include "BallisticSolver.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'D', 'A', 'R', 'T', 'F', 'T', 'B', '1'};
+const uint32_t FORMAT_VERSION = 1;   // 生成算法变化时递增，旧缓存自动失效
+
+// 缓存文件头，后面依次是仰角表、飞行时间表，各段按 64 字节对齐
+struct CacheHeader {
+    char magic[8];
+    int32_t range_count;
+    int32_t height_count;
+    float range_min;
+    float range_step;
+    float height_min;
+    float height_step;
+    uint64_t hash;
+    uint64_t pitch_offset;
+    uint64_t time_offset;
+    uint64_t total_size;
+};
+
+int gridCount(float min_value, float max_value, float step) {
+    return static_cast<int>(std::floor((max_value - min_value) / step + 1e-4f)) + 1;
+}
+
+// 段布局
+void computeLayout(int range_count, int height_count, CacheHeader& header) {
+    size_t cells = static_cast<size_t>(range_count) * height_count;
+    header.pitch_offset = alignCacheOffset(sizeof(CacheHeader));
+    header.time_offset = alignCacheOffset(header.pitch_offset + cells * sizeof(float));
+    header.total_size = header.time_offset + cells * sizeof(float);
+}
+
+} // namespace
+
+FiringTable::FiringTable()
+    : range_min_(0.0f), range_step_(1.0f), range_count_(0),
+      height_min_(0.0f), height_step_(1.0f), height_count_(0), hash_(0),
+      pitch_(nullptr), flight_time_(nullptr) {}
+
+FiringTable::~FiringTable() {
+    release();
+}
+
+void FiringTable::release() {
+    pitch_ = nullptr;
+    flight_time_ = nullptr;
+    storage_.clear();
+    storage_.shrink_to_fit();
+    mapping_.release();
+}
+
+uint64_t FiringTable::hashParameters(const BallisticSolver& solver) {
+    // 只包含影响射表内容的参数（发射点偏移、nominal_height 不影响）
+    const BallisticParams& p = solver.getParams();
+    const float values[] = {
+        p.mass, p.drag_coefficient, p.reference_area, p.air_density, p.gravity, p.launch_speed,
+        p.min_pitch_deg, p.max_pitch_deg, p.table_min_range, p.table_max_range, p.table_step,
+        p.table_min_height, p.table_max_height, p.table_height_step, p.table_pitch_step_deg, p.integration_step};
+    Fnv1aHash hash;
+    hash.mix(&FORMAT_VERSION, sizeof(FORMAT_VERSION));
+    hash.mix(values, sizeof(values));
+    return hash.value();
+}
+
+bool FiringTable::init(const BallisticSolver& solver, const std::string& cache_file, int threads) {
+    const BallisticParams& params = solver.getParams();
+    release();
+    range_min_ = params.table_min_range;
+    range_step_ = params.table_step;
+    range_count_ = gridCount(params.table_min_range, params.table_max_range, params.table_step);
+    height_min_ = params.table_min_height;
+    height_step_ = params.table_height_step;
+    height_count_ = gridCount(params.table_min_height, params.table_max_height, params.table_height_step);
+    hash_ = hashParameters(solver);
+    if (range_count_ < 2 || height_count_ < 2) {
+        std::cerr << "[FiringTable] 射表范围无效: " << range_count_ << "x" << height_count_ << std::endl;
+        return false;
+    }
+
+    if (!cache_file.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (loadCache(cache_file)) {
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << "[FiringTable] 已映射射表: " << cache_file << " (" << range_count_ << "x" << height_count_
+                      << ", " << std::chrono::duration<double, std::micro>(end - start).count() << "us)" << std::endl;
+            return true;
+        }
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    build(solver, threads);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "[FiringTable] 已生成射表 " << range_count_ << "x" << height_count_ << " (" << threads
+              << " 线程), 耗时 " << std::chrono::duration<double, std::milli>(end - start).count() << "ms" << std::endl;
+
+    if (!cache_file.empty()) {
+        saveCache(cache_file);
+    }
+    return true;
+}
+
+void FiringTable::build(const BallisticSolver& solver, int threads) {
+    const BallisticParams& params = solver.getParams();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float deg2rad = static_cast<float>(CV_PI / 180.0);
+    const float pitch_min = params.min_pitch_deg * deg2rad;
+    const float pitch_step = params.table_pitch_step_deg * deg2rad;
+    const int pitch_count = gridCount(params.min_pitch_deg, params.max_pitch_deg, params.table_pitch_step_deg);
+    const size_t R = static_cast<size_t>(range_count_);
+
+    // 第一步：每个扫描仰角积分一次，得到该弹道经过各距离节点时的高度和时间
+    // 多留一个高度步长，保证射表最低一行仍有下方的样本可插值
+    std::vector<float> profile_height(static_cast<size_t>(pitch_count) * R);
+    std::vector<float> profile_time(static_cast<size_t>(pitch_count) * R);
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&]() {
+            for (int j = next++; j < pitch_count; j = next++) {
+                solver.simulateProfile(pitch_min + j * pitch_step, range_min_, range_step_, range_count_,
+                                       height_min_ - height_step_, &profile_height[j * R], &profile_time[j * R]);
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    workers.clear();
+
+    // 第二步：逐距离反查。低伸弹道段上高度随仰角单调增加，按高度升序双指针线性插值
+    storage_.assign(2 * R * height_count_, nan);
+    float* pitch_table = storage_.data();
+    float* time_table = storage_.data() + R * height_count_;
+    next = 0;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&]() {
+            for (int i = next++; i < range_count_; i = next++) {
+                auto height_at = [&](int j) { return profile_height[j * R + i]; };
+                int first = 0;
+                while (first < pitch_count && std::isnan(height_at(first))) first++;
+                if (first >= pitch_count) continue;
+                // 低伸段终点：高度开始下降（越过最大射程仰角）或弹道不再到达
+                int last = first;
+                while (last + 1 < pitch_count && !std::isnan(height_at(last + 1)) &&
+                       height_at(last + 1) > height_at(last)) {
+                    last++;
+                }
+
+                int j = first;
+                for (int k = 0; k < height_count_; ++k) {
+                    float h = height_min_ + k * height_step_;
+                    while (j < last && height_at(j + 1) <= h) j++;
+                    if (j >= last || height_at(j) > h) continue;
+                    float a = (h - height_at(j)) / (height_at(j + 1) - height_at(j));
+                    size_t cell = static_cast<size_t>(k) * R + i;
+                    pitch_table[cell] = pitch_min + (j + a) * pitch_step;
+                    time_table[cell] = profile_time[j * R + i] + a * (profile_time[(j + 1) * R + i] - profile_time[j * R + i]);
+                }
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    pitch_ = pitch_table;
+    flight_time_ = time_table;
+}
+
+bool FiringTable::lookup(float range, float height, float& pitch, float& flight_time) const {
+    if (pitch_ == nullptr) {
+        return false;
+    }
+    float fr = (range - range_min_) / range_step_;
+    float fh = (height - height_min_) / height_step_;
+    int i = static_cast<int>(std::floor(fr));
+    int k = static_cast<int>(std::floor(fh));
+    if (i < 0 || k < 0 || i + 1 >= range_count_ || k + 1 >= height_count_) {
+        return false;
+    }
+
+    size_t c00 = static_cast<size_t>(k) * range_count_ + i;
+    size_t c10 = c00 + range_count_;
+    float p00 = pitch_[c00], p01 = pitch_[c00 + 1], p10 = pitch_[c10], p11 = pitch_[c10 + 1];
+    if (std::isnan(p00) || std::isnan(p01) || std::isnan(p10) || std::isnan(p11)) {
+        return false;
+    }
+    float a = fr - i;
+    float b = fh - k;
+    pitch = (1 - b) * ((1 - a) * p00 + a * p01) + b * ((1 - a) * p10 + a * p11);
+    flight_time = (1 - b) * ((1 - a) * flight_time_[c00] + a * flight_time_[c00 + 1]) +
+                  b * ((1 - a) * flight_time_[c10] + a * flight_time_[c10 + 1]);
+    return true;
+}
+
+bool FiringTable::loadCache(const std::string& file_name) {
+    if (!mapping_.open(file_name, sizeof(CacheHeader))) {
+        return false;
+    }
+
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(mapping_.data());
+    CacheHeader expected;
+    computeLayout(range_count_, height_count_, expected);
+    bool valid = std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header->range_count == range_count_ &&
+                 header->height_count == height_count_ &&
+                 header->range_min == range_min_ &&
+                 header->range_step == range_step_ &&
+                 header->height_min == height_min_ &&
+                 header->height_step == height_step_ &&
+                 header->hash == hash_ &&
+                 header->pitch_offset == expected.pitch_offset &&
+                 header->time_offset == expected.time_offset &&
+                 header->total_size == expected.total_size &&
+                 mapping_.size() >= expected.total_size;
+    if (!valid) {
+        std::cout << "[FiringTable] 缓存与当前弹道参数不匹配，重新生成: " << file_name << std::endl;
+        mapping_.release();
+        return false;
+    }
+
+    // 射表直接指向映射区域（只读），不做拷贝
+    const char* base = mapping_.data();
+    pitch_ = reinterpret_cast<const float*>(base + header->pitch_offset);
+    flight_time_ = reinterpret_cast<const float*>(base + header->time_offset);
+    return true;
+}
+
+bool FiringTable::saveCache(const std::string& file_name) const {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.range_count = range_count_;
+    header.height_count = height_count_;
+    header.range_min = range_min_;
+    header.range_step = range_step_;
+    header.height_min = height_min_;
+    header.height_step = height_step_;
+    header.hash = hash_;
+    computeLayout(range_count_, height_count_, header);
+
+    size_t bytes = static_cast<size_t>(range_count_) * height_count_ * sizeof(float);
+    if (!writeCacheFile(file_name, &header, sizeof(header),
+                        {{header.pitch_offset, pitch_, bytes}, {header.time_offset, flight_time_, bytes}})) {
+        return false;
+    }
+
+    std::cout << "[FiringTable] 射表已缓存: " << file_name
+              << " (" << header.total_size / 1024 << "KB)" << std::endl;
+    return true;
+}
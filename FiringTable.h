@@ -0,0 +1,61 @@
+#ifndef FIRINGTABLE_H
+#define FIRINGTABLE_H
+
+#include "CacheFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BallisticSolver;
+
+// 二维射表：水平距离 x 目标相对高度 -> 低伸弹道仰角、飞行时间
+// 生成时按仰角扫描整条弹道（多线程），每条弹道一次积分覆盖所有距离，再逐距离反查高度；
+// 射表按弹道参数哈希写入磁盘，下次启动 mmap 直接使用
+class FiringTable {
+private:
+    float range_min_;
+    float range_step_;
+    int range_count_;
+    float height_min_;
+    float height_step_;
+    int height_count_;
+    uint64_t hash_;
+
+    // 行优先 [高度][距离]，不可达为 NaN；指向 storage_ 或 mmap 区域
+    const float* pitch_;
+    const float* flight_time_;
+    std::vector<float> storage_;
+
+    MappedFile mapping_;  // mmap 映射的缓存文件，未映射表示射表在堆上
+
+    void build(const BallisticSolver& solver, int threads);
+    bool loadCache(const std::string& file_name);
+    bool saveCache(const std::string& file_name) const;
+
+public:
+    FiringTable();
+    ~FiringTable();
+    FiringTable(const FiringTable&) = delete;
+    FiringTable& operator=(const FiringTable&) = delete;
+
+    // 按 solver 当前参数初始化射表；cache_file 非空时优先 mmap 已有缓存，参数不匹配则重新生成并写入
+    // threads <= 0 时使用全部硬件线程
+    bool init(const BallisticSolver& solver, const std::string& cache_file = "", int threads = 0);
+
+    // 释放射表（参数变化后需要重新 init）
+    void release();
+
+    bool isReady() const { return pitch_ != nullptr; }
+    bool isMapped() const { return mapping_.isMapped(); }
+    int getRangeCount() const { return range_count_; }
+    int getHeightCount() const { return height_count_; }
+
+    // 双线性插值；超出射表范围或邻近表项不可达时返回 false
+    bool lookup(float range, float height, float& pitch, float& flight_time) const;
+
+    // 生成射表的弹道参数哈希，也用于校验缓存
+    static uint64_t hashParameters(const BallisticSolver& solver);
+};
+
+#endif // FIRINGTABLE_H
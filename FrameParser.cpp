@@ -0,0 +1,161 @@
+#include "FrameParser.h"
+#include <cstring>
+
+FrameParser::FrameParser(Handler& handler)
+    : handler_(handler),
+      state_(State::START),
+      length_(0),
+      expected_(0) {
+}
+
+void FrameParser::reset() {
+    state_ = State::START;
+    length_ = 0;
+    expected_ = 0;
+    stats_ = FrameParserStats();
+}
+
+void FrameParser::feed(uint8_t byte) {
+    switch (state_) {
+        case State::START:
+            if (byte == FRAME_START) {
+                buffer_[0] = byte;
+                length_ = 1;
+                state_ = State::HEADER;
+            } else {
+                stats_.dropped_bytes++;
+            }
+            return;
+
+        case State::HEADER:
+            buffer_[length_++] = byte;
+            if (byte == FRAME_HEADER_V1_LEVEL) {
+                expected_ = V1_LEVEL_FRAME_SIZE;
+                state_ = State::BODY;
+            } else if (byte == FRAME_HEADER_V1_SPEED) {
+                expected_ = V1_SPEED_FRAME_SIZE;
+                state_ = State::BODY;
+            } else if (byte == FRAME_HEADER_V2) {
+                state_ = State::V2_HEADER;
+            } else {
+                stats_.framing_errors++;
+                fail();
+            }
+            return;
+
+        case State::V2_HEADER:
+            buffer_[length_++] = byte;
+            // 版本和长度一到就检查，尽早放弃假帧头
+            if (length_ == 3 && byte != PROTOCOL_VERSION) {
+                stats_.framing_errors++;
+                fail();
+            } else if (length_ == 6) {
+                if (byte > FRAME_MAX_PAYLOAD) {
+                    stats_.framing_errors++;
+                    fail();
+                } else {
+                    expected_ = FRAME_OVERHEAD + byte;
+                    state_ = State::BODY;
+                }
+            }
+            return;
+
+        case State::BODY:
+            buffer_[length_++] = byte;
+            if (length_ == expected_) {
+                complete();
+            }
+            return;
+    }
+}
+
+void FrameParser::fail() {
+    // 起始字节作废；其余字节可能包含下一帧的开头，逐个重新送入（递归深度不超过帧长）
+    uint8_t replay[FRAME_MAX_SIZE];
+    size_t count = length_ - 1;
+    std::memcpy(replay, buffer_ + 1, count);
+    stats_.dropped_bytes++;
+    state_ = State::START;
+    length_ = 0;
+    for (size_t i = 0; i < count; ++i) {
+        feed(replay[i]);
+    }
+}
+
+void FrameParser::complete() {
+    if (buffer_[length_ - 2] != FRAME_END_0 || buffer_[length_ - 1] != FRAME_END_1) {
+        stats_.framing_errors++;
+        fail();
+        return;
+    }
+    bool v2 = buffer_[1] == FRAME_HEADER_V2;
+    if (v2) {
+        size_t payload_size = buffer_[5];
+        if (readLe16(buffer_ + 6 + payload_size) != crc16Ccitt(buffer_ + 2, 4 + payload_size)) {
+            stats_.crc_errors++;
+            fail();
+            return;
+        }
+        stats_.frames++;
+    } else {
+        stats_.legacy_frames++;
+    }
+    stats_.frame_bytes += length_;
+    dispatch();
+    state_ = State::START;
+    length_ = 0;
+}
+
+void FrameParser::dispatch() {
+    if (buffer_[1] == FRAME_HEADER_V1_LEVEL) {
+        handler_.onLevel(-1, static_cast<int8_t>(buffer_[2]));
+        return;
+    }
+    if (buffer_[1] == FRAME_HEADER_V1_SPEED) {
+        handler_.onSpeed(-1, static_cast<int16_t>(readLe16(buffer_ + 2)));
+        return;
+    }
+
+    uint8_t type = buffer_[3];
+    uint8_t seq = buffer_[4];
+    size_t size = buffer_[5];
+    const uint8_t* payload = buffer_ + 6;
+    MotorTelemetry telemetry;
+    switch (static_cast<MessageType>(type)) {
+        case MessageType::SPEED:
+            if (size >= 2) {
+                handler_.onSpeed(seq, static_cast<int16_t>(readLe16(payload)));
+                return;
+            }
+            break;
+        case MessageType::LEVEL:
+            if (size >= 1) {
+                handler_.onLevel(seq, static_cast<int8_t>(payload[0]));
+                return;
+            }
+            break;
+        case MessageType::STOP:
+            handler_.onStop(seq);
+            return;
+        case MessageType::WATCHDOG:
+            if (size >= 2) {
+                handler_.onWatchdog(seq, readLe16(payload));
+                return;
+            }
+            break;
+        case MessageType::ACK:
+            if (size >= 2) {
+                handler_.onAck(seq, payload[0], payload[1]);
+                return;
+            }
+            break;
+        case MessageType::TELEMETRY:
+            if (decodeTelemetry(payload, size, telemetry)) {
+                handler_.onTelemetry(seq, telemetry);
+                return;
+            }
+            break;
+    }
+    stats_.unknown_messages++;
+    handler_.onUnknown(type, seq, payload, size);
+}
@@ -0,0 +1,75 @@
+#ifndef FRAMEPARSER_H
+#define FRAMEPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "SerialProtocol.h"
+
+// 解析统计。每个输入字节恰好计入一类：合法帧、丢弃字节，或仍在解析中的未完成帧（getPendingBytes）
+struct FrameParserStats {
+    unsigned long frames = 0;          // 协议 v2 合法帧
+    unsigned long legacy_frames = 0;   // 协议 v1 固定帧（AA 55 / AA 56）
+    unsigned long frame_bytes = 0;     // 合法帧的总字节数
+    unsigned long crc_errors = 0;
+    unsigned long framing_errors = 0;  // 帧头、版本、长度或帧尾错误
+    unsigned long unknown_messages = 0;   // 校验通过但类型未知或负载过短
+    unsigned long dropped_bytes = 0;   // 不属于任何合法帧的字节
+};
+
+// 串口接收的流式解析器：逐字节状态机，同时识别 v1 固定帧与 v2 变长帧，不做任何堆分配。
+// 帧校验失败时从该帧第二个字节起重新扫描，藏在损坏帧内部的真正帧头不会被跳过。
+// 解析出的帧按类型分发给 Handler；回调在 feed 的调用线程中同步执行。
+class FrameParser {
+public:
+    // seq 为 -1 表示 v1 固定帧（无序号）
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+        virtual void onLevel(int seq, int8_t level) { (void)seq; (void)level; }
+        virtual void onSpeed(int seq, int16_t speed) { (void)seq; (void)speed; }
+        virtual void onStop(int seq) { (void)seq; }
+        virtual void onWatchdog(uint8_t seq, uint16_t timeout_ms) { (void)seq; (void)timeout_ms; }
+        virtual void onAck(uint8_t seq, uint8_t acked_seq, uint8_t status) { (void)seq; (void)acked_seq; (void)status; }
+        virtual void onTelemetry(uint8_t seq, const MotorTelemetry& telemetry) { (void)seq; (void)telemetry; }
+        // 校验通过但无法识别的消息（新版本固件的扩展类型）
+        virtual void onUnknown(uint8_t type, uint8_t seq, const uint8_t* payload, size_t size) {
+            (void)type; (void)seq; (void)payload; (void)size;
+        }
+    };
+
+    explicit FrameParser(Handler& handler);
+
+    void feed(const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            feed(data[i]);
+        }
+    }
+    void feed(uint8_t byte);
+
+    // 丢弃未完成的帧（不计入统计），统计清零
+    void reset();
+    const FrameParserStats& getStats() const { return stats_; }
+    size_t getPendingBytes() const { return length_; }
+
+private:
+    enum class State {
+        START,      // 等待 0xAA
+        HEADER,     // 等待第二个帧头字节，决定帧格式
+        V2_HEADER,  // v2：版本、类型、序号、长度
+        BODY        // 已知帧长，收集剩余字节
+    };
+
+    Handler& handler_;
+    State state_;
+    uint8_t buffer_[FRAME_MAX_SIZE];
+    size_t length_;
+    size_t expected_;
+    FrameParserStats stats_;
+
+    // 当前帧作废：丢弃起始字节，其余字节重新扫描
+    void fail();
+    void complete();
+    void dispatch();
+};
+
+#endif // FRAMEPARSER_H
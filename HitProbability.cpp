@@ -0,0 +1,100 @@
+#include "HitProbability.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+float normalCdf(float z) {
+    return 0.5f * std::erfc(-z / std::sqrt(2.0f));
+}
+
+} // namespace
+
+bool HitProbabilityEstimator::loadConfig(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开命中概率配置文件: " << file_name << std::endl;
+        return false;
+    }
+
+    HitModelConfig config;
+    auto read = [&fs](const char* key, float& value) {
+        cv::FileNode node = fs[key];
+        if (!node.empty()) value = static_cast<float>(node);
+    };
+    read("target_radius", config.target_radius);
+    read("dispersion_h_mrad", config.dispersion_h_mrad);
+    read("dispersion_v_mrad", config.dispersion_v_mrad);
+    read("pointing_std_mrad", config.pointing_std_mrad);
+    read("fire_threshold", config.fire_threshold);
+    read("release_threshold", config.release_threshold);
+
+    if (config.target_radius <= 0 || config.fire_threshold <= 0 || config.fire_threshold > 1 ||
+        config.release_threshold > config.fire_threshold) {
+        std::cerr << "命中概率配置无效: " << file_name << std::endl;
+        return false;
+    }
+    config_ = config;
+    std::cout << "已加载命中概率模型: " << file_name << " (命中半径 " << config_.target_radius
+              << "m, 发射阈值 " << config_.fire_threshold << ")" << std::endl;
+    return true;
+}
+
+HitEstimate HitProbabilityEstimator::estimate(const HitInputs& inputs) const {
+    HitEstimate result;
+    if (inputs.range <= 0 || inputs.focal_px <= 0) {
+        return result;
+    }
+
+    const float R = inputs.range;
+    const float px_to_m = R / inputs.focal_px;   // 目标平面上一个像素对应的长度
+    const float flight_ms = inputs.flight_time * 1000.0f;
+
+    // 平均脱靶量（弹着点 - 目标，x 右 y 上）：水平瞄准误差 + 飞行时间内目标的位移
+    result.mean_miss.x = -R * std::tan(inputs.aim_error_h) - inputs.target_velocity_px.x * flight_ms * px_to_m;
+    result.mean_miss.y = inputs.target_velocity_px.y * flight_ms * px_to_m;
+
+    // 方差：目标位置不确定度 + 飞镖散布 + 定位误差 + 距离误差带来的落点高度误差
+    float pointing = config_.pointing_std_mrad * 1e-3f * R;
+    float disp_h = config_.dispersion_h_mrad * 1e-3f * R;
+    float disp_v = config_.dispersion_v_mrad * 1e-3f * R;
+    float var_h = std::max(0.0f, inputs.target_cov_px(0, 0)) * px_to_m * px_to_m + disp_h * disp_h + pointing * pointing;
+    float var_v = std::max(0.0f, inputs.target_cov_px(1, 1)) * px_to_m * px_to_m + disp_v * disp_v + pointing * pointing;
+    if (inputs.range_variance > 0) {
+        var_v += inputs.impact_slope * inputs.impact_slope * inputs.range_variance;
+    }
+    result.sigma_h = std::sqrt(var_h);
+    result.sigma_v = std::sqrt(var_v);
+
+    result.probability = circleProbability(result.mean_miss, result.sigma_h, result.sigma_v, config_.target_radius);
+    result.valid = true;
+    return result;
+}
+
+float HitProbabilityEstimator::circleProbability(const cv::Point2f& mean, float sigma_x, float sigma_y, float radius) {
+    sigma_x = std::max(sigma_x, 1e-6f);
+    sigma_y = std::max(sigma_y, 1e-6f);
+
+    // 沿 x 积分：p(x) * P(|y| <= sqrt(r^2 - x^2))，积分区间截到 mean.x ± 6σ 以内，保证分布很窄时也有足够采样
+    float lo = std::max(-radius, mean.x - 6.0f * sigma_x);
+    float hi = std::min(radius, mean.x + 6.0f * sigma_x);
+    if (lo >= hi) {
+        return 0.0f;
+    }
+
+    const int N = 64;   // Simpson 区间数（偶数）
+    float h = (hi - lo) / N;
+    auto integrand = [&](float x) {
+        float half_chord = std::sqrt(std::max(0.0f, radius * radius - x * x));
+        float zx = (x - mean.x) / sigma_x;
+        float px = std::exp(-0.5f * zx * zx) / (sigma_x * std::sqrt(2.0f * static_cast<float>(CV_PI)));
+        float py = normalCdf((half_chord - mean.y) / sigma_y) - normalCdf((-half_chord - mean.y) / sigma_y);
+        return px * py;
+    };
+    float sum = integrand(lo) + integrand(hi);
+    for (int i = 1; i < N; ++i) {
+        sum += integrand(lo + i * h) * ((i % 2 == 1) ? 4.0f : 2.0f);
+    }
+    return std::min(1.0f, std::max(0.0f, sum * h / 3.0f));
+}
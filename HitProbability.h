@@ -0,0 +1,59 @@
+#ifndef HITPROBABILITY_H
+#define HITPROBABILITY_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+// 命中概率模型参数（角度单位为毫弧度，长度单位为米）
+struct HitModelConfig {
+    float target_radius = 0.06f;        // 目标板有效命中半径
+    float dispersion_h_mrad = 2.0f;     // 飞镖自身散布（1σ）：水平 / 竖直
+    float dispersion_v_mrad = 3.0f;
+    float pointing_std_mrad = 0.5f;     // 电机定位误差（1σ）
+    float fire_threshold = 0.8f;        // 命中概率达到该值给出发射许可
+    float release_threshold = 0.7f;     // 已许可时低于该值撤销（迟滞，避免抖动）
+};
+
+// 一帧的误差来源
+struct HitInputs {
+    float range = -1.0f;                 // 目标距离（米）
+    float range_variance = -1.0f;        // 距离方差（米^2），未知时为负
+    // 当前水平瞄准误差（弧度），目标在右为正。只有方位由转台闭环控制；仰角按射击诸元给出，
+    // 没有竖直瞄准误差的观测，竖直方向只计入目标运动与距离误差（impact_slope）
+    float aim_error_h = 0.0f;
+    cv::Matx22f target_cov_px;           // 命中时刻目标中心的位置协方差（像素^2）
+    cv::Point2f target_velocity_px;      // 目标像素速度（像素/ms），飞行时间内的位移计入平均脱靶量
+    float flight_time = 0.0f;            // 飞行时间（s）
+    float focal_px = 0.0f;               // 当前分辨率下的等效焦距（像素）
+    float impact_slope = 0.0f;           // 弹道在目标处的斜率 dh/dx，把距离误差换算为竖直脱靶
+};
+
+// 目标平面上的脱靶量分布与命中概率
+struct HitEstimate {
+    bool valid = false;
+    float probability = 0.0f;
+    cv::Point2f mean_miss;               // 平均脱靶量（米，x 右, y 上）
+    float sigma_h = 0.0f;                // 脱靶量标准差（米）
+    float sigma_v = 0.0f;
+};
+
+// 命中概率估计：把跟踪器协方差、距离方差、瞄准误差和飞镖散布合成为目标平面上的
+// 二维正态脱靶分布（忽略水平/竖直相关项），再在命中圆内积分
+class HitProbabilityEstimator {
+private:
+    HitModelConfig config_;
+
+public:
+    HitProbabilityEstimator() = default;
+
+    bool loadConfig(const std::string& file_name);
+    void setConfig(const HitModelConfig& config) { config_ = config; }
+    const HitModelConfig& getConfig() const { return config_; }
+
+    HitEstimate estimate(const HitInputs& inputs) const;
+
+    // 独立正态分布 N(mean, diag(sigma_x^2, sigma_y^2)) 落入以原点为圆心、半径 radius 的圆内的概率
+    static float circleProbability(const cv::Point2f& mean, float sigma_x, float sigma_y, float radius);
+};
+
+#endif // HITPROBABILITY_H
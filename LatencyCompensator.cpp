@@ -0,0 +1,195 @@
+#include "LatencyCompensator.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+struct ResidualStats {
+    double mean;
+    double rms;
+    double p95;
+};
+
+ResidualStats summarize(std::vector<double>& errors) {
+    ResidualStats stats = {0.0, 0.0, 0.0};
+    if (errors.empty()) return stats;
+    double sum = 0.0, sum_sq = 0.0;
+    for (double e : errors) {
+        sum += e;
+        sum_sq += e * e;
+    }
+    std::sort(errors.begin(), errors.end());
+    stats.mean = sum / errors.size();
+    stats.rms = std::sqrt(sum_sq / errors.size());
+    stats.p95 = errors[std::min(errors.size() - 1, errors.size() * 95 / 100)];
+    return stats;
+}
+
+cv::Point2f targetCenter(const ReplayFrame& frame, int index) {
+    return cv::Point2f(frame.detections[index].circle[0], frame.detections[index].circle[1]);
+}
+
+// 在 time_ms 处对被跟踪目标的检测位置做线性插值（target[k] 为第 k 帧关联到轨迹的检测，-1 表示没有），
+// 前后最近的有检测帧间隔过大时视为无真值
+bool interpolateTruth(const std::vector<ReplayFrame>& frames, const std::vector<int>& target, size_t from,
+                      double time_ms, cv::Point2f& truth) {
+    const double MAX_GAP_MS = 100.0;
+    size_t after = from;
+    while (after < frames.size() && (frames[after].timestamp_ms < time_ms || target[after] < 0)) {
+        ++after;
+    }
+    if (after >= frames.size()) return false;
+
+    size_t before = after;
+    while (before > from && (before == after || target[before] < 0)) {
+        --before;
+    }
+    if (target[before] < 0 || frames[before].timestamp_ms > time_ms) return false;
+
+    double t0 = frames[before].timestamp_ms;
+    double t1 = frames[after].timestamp_ms;
+    if (t1 - t0 > MAX_GAP_MS) return false;
+
+    cv::Point2f p0 = targetCenter(frames[before], target[before]);
+    cv::Point2f p1 = targetCenter(frames[after], target[after]);
+    float w = (t1 > t0) ? static_cast<float>((time_ms - t0) / (t1 - t0)) : 1.0f;
+    truth = p0 + (p1 - p0) * w;
+    return true;
+}
+
+} // namespace
+
+LatencyCompensator::LatencyCompensator()
+    : processing_ms_(0.0),
+      serial_ms_(0.0),
+      end_to_end_ms_(0.0),
+      last_end_to_end_ms_(0.0),
+      max_end_to_end_ms_(0.0),
+      frame_count_(0) {}
+
+bool LatencyCompensator::loadConfig(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开延迟补偿配置: " << file_name << std::endl;
+        return false;
+    }
+
+    auto read = [&fs](const char* key, double& value) {
+        cv::FileNode node = fs[key];
+        if (!node.empty()) value = static_cast<double>(node);
+    };
+    if (!fs["enabled"].empty()) config_.enabled = static_cast<int>(fs["enabled"]) != 0;
+    read("exposure_offset_ms", config_.exposure_offset_ms);
+    read("transfer_ms", config_.transfer_ms);
+    read("actuator_delay_ms", config_.actuator_delay_ms);
+    read("smoothing", config_.smoothing);
+    read("max_horizon_ms", config_.max_horizon_ms);
+
+    std::cout << "已加载延迟补偿配置: " << file_name
+              << " (电机响应 " << config_.actuator_delay_ms << "ms, 外推上限 "
+              << config_.max_horizon_ms << "ms)" << std::endl;
+    return true;
+}
+
+double LatencyCompensator::smooth(double current, double sample) const {
+    // 尚无测量值时直接使用第一个样本
+    if (current == 0.0) return sample;
+    return current + config_.smoothing * (sample - current);
+}
+
+double LatencyCompensator::captureTime(double grab_return_ms) const {
+    return grab_return_ms - config_.transfer_ms - config_.exposure_offset_ms;
+}
+
+void LatencyCompensator::recordProcessing(double ms) {
+    processing_ms_ = smooth(processing_ms_, ms);
+}
+
+void LatencyCompensator::recordSerialWrite(double ms) {
+    serial_ms_ = smooth(serial_ms_, ms);
+}
+
+void LatencyCompensator::recordFrame(double capture_ms, double command_ms) {
+    last_end_to_end_ms_ = actuationTime(command_ms) - capture_ms;
+    end_to_end_ms_ = smooth(end_to_end_ms_, last_end_to_end_ms_);
+    max_end_to_end_ms_ = std::max(max_end_to_end_ms_, last_end_to_end_ms_);
+    frame_count_++;
+}
+
+double LatencyCompensator::actuationTime(double command_ms) const {
+    return command_ms + serial_ms_ + config_.actuator_delay_ms;
+}
+
+cv::Point2f LatencyCompensator::predictAimPoint(const TargetTracker& tracker, double command_ms) const {
+    if (!config_.enabled) {
+        return tracker.predictCenter(command_ms);
+    }
+    double target_ms = std::min(actuationTime(command_ms),
+                                tracker.getLastDetectionTime() + config_.max_horizon_ms);
+    return tracker.predictCenter(target_ms);
+}
+
+void LatencyCompensator::printStats() const {
+    std::cout << "=== 延迟统计 (平滑值) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "曝光+传输: " << config_.exposure_offset_ms + config_.transfer_ms << "ms, "
+              << "检测: " << processing_ms_ << "ms, "
+              << "串口发送: " << serial_ms_ << "ms, "
+              << "电机响应: " << config_.actuator_delay_ms << "ms" << std::endl;
+    std::cout << "端到端: " << end_to_end_ms_ << "ms (最大 " << max_end_to_end_ms_ << "ms, "
+              << frame_count_ << " 帧)" << std::endl;
+    std::cout << "延迟补偿: " << (config_.enabled ? "启用" : "禁用") << std::endl;
+}
+
+PredictionResidual LatencyCompensator::evaluateReplay(const std::vector<ReplayFrame>& frames, double latency_ms) {
+    PredictionResidual residual;
+    residual.latency_ms = latency_ms;
+
+    // 先跑一遍跟踪：多目标帧中真值与基线都取跟踪器关联的那个检测，与实际控制对准的目标一致
+    TargetTracker tracker;
+    std::vector<int> target(frames.size(), -1);
+    std::vector<cv::Point2f> predictions(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const ReplayFrame& frame = frames[i];
+        tracker.update(frame.detections, frame.timestamp_ms);
+        if (!tracker.hasTrack()) continue;
+        target[i] = tracker.getAssociatedIndex();
+        predictions[i] = tracker.predictCenter(frame.timestamp_ms + latency_ms);
+    }
+
+    std::vector<double> predicted_errors;
+    std::vector<double> baseline_errors;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        // 只在当前帧有关联检测时评估，使补偿与不补偿两种方式使用相同的样本
+        if (target[i] < 0) continue;
+
+        cv::Point2f truth;
+        if (!interpolateTruth(frames, target, i, frames[i].timestamp_ms + latency_ms, truth)) continue;
+
+        const cv::Point2f& predicted = predictions[i];
+        cv::Point2f current = targetCenter(frames[i], target[i]);
+        predicted_errors.push_back(cv::norm(predicted - truth));
+        baseline_errors.push_back(cv::norm(current - truth));
+    }
+
+    residual.samples = static_cast<int>(predicted_errors.size());
+    ResidualStats predicted = summarize(predicted_errors);
+    ResidualStats baseline = summarize(baseline_errors);
+    residual.mean_px = predicted.mean;
+    residual.rms_px = predicted.rms;
+    residual.p95_px = predicted.p95;
+    residual.baseline_mean_px = baseline.mean;
+    residual.baseline_rms_px = baseline.rms;
+    residual.baseline_p95_px = baseline.p95;
+    return residual;
+}
+
+void LatencyCompensator::printResidual(const PredictionResidual& residual) {
+    std::cout << std::fixed << std::setprecision(2)
+              << "延迟 " << std::setw(6) << residual.latency_ms << "ms, 样本 " << std::setw(5) << residual.samples
+              << " | 补偿 平均 " << residual.mean_px << "px, RMS " << residual.rms_px << "px, P95 " << residual.p95_px << "px"
+              << " | 不补偿 平均 " << residual.baseline_mean_px << "px, RMS " << residual.baseline_rms_px
+              << "px, P95 " << residual.baseline_p95_px << "px" << std::endl;
+}
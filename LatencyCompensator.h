@@ -0,0 +1,87 @@
+#ifndef LATENCYCOMPENSATOR_H
+#define LATENCYCOMPENSATOR_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "DetectionResult.h"
+#include "TargetTracker.h"
+
+// 延迟补偿配置（时间单位毫秒）
+struct LatencyConfig {
+    bool enabled = true;
+    double exposure_offset_ms = 2.5;   // 曝光中点到帧结束的时间（曝光时间的一半）
+    double transfer_ms = 3.0;          // 帧结束到 Grab() 返回的传输时间
+    double actuator_delay_ms = 20.0;   // 串口指令送达后电机开始响应的时间
+    double smoothing = 0.1;            // 在线测量值的指数平滑系数
+    double max_horizon_ms = 120.0;     // 外推时长上限
+};
+
+// 回放评估的一帧：时间戳为采集时刻
+struct ReplayFrame {
+    double timestamp_ms;
+    std::vector<DetectionResult> detections;
+};
+
+// 预测残差统计（像素），baseline 为不做补偿、直接瞄准当前检测中心的结果
+struct PredictionResidual {
+    double latency_ms = 0.0;
+    int samples = 0;
+    double mean_px = 0.0;
+    double rms_px = 0.0;
+    double p95_px = 0.0;
+    double baseline_mean_px = 0.0;
+    double baseline_rms_px = 0.0;
+    double baseline_p95_px = 0.0;
+};
+
+// 端到端延迟测量与补偿：估计指令生效时刻，并把瞄准点外推到该时刻
+// 延迟 = 曝光中点 -> Grab 返回 -> 检测 -> 串口发送(含 tcdrain) -> 电机响应
+class LatencyCompensator {
+private:
+    LatencyConfig config_;
+    double processing_ms_;     // 检测耗时（平滑）
+    double serial_ms_;         // 串口发送耗时（平滑）
+    double end_to_end_ms_;     // 曝光中点到预计生效时刻（平滑）
+    double last_end_to_end_ms_;
+    double max_end_to_end_ms_;
+    long frame_count_;
+
+    double smooth(double current, double sample) const;
+
+public:
+    LatencyCompensator();
+
+    // 从 YAML 加载配置，文件中缺失的字段保持默认值
+    bool loadConfig(const std::string& file_name);
+    void setConfig(const LatencyConfig& config) { config_ = config; }
+    const LatencyConfig& getConfig() const { return config_; }
+    void setEnabled(bool enabled) { config_.enabled = enabled; }
+    bool isEnabled() const { return config_.enabled; }
+
+    // 由 Grab() 返回时刻推算曝光中点时刻
+    double captureTime(double grab_return_ms) const;
+
+    // 在线测量
+    void recordProcessing(double ms);
+    void recordSerialWrite(double ms);
+    void recordFrame(double capture_ms, double command_ms);
+
+    // 在 command_ms 发出的指令预计生效的时刻
+    double actuationTime(double command_ms) const;
+
+    // 瞄准点：跟踪器外推到预计生效时刻；关闭补偿时为指令时刻
+    cv::Point2f predictAimPoint(const TargetTracker& tracker, double command_ms) const;
+
+    double getProcessingMs() const { return processing_ms_; }
+    double getSerialMs() const { return serial_ms_; }
+    double getEndToEndMs() const { return end_to_end_ms_; }
+    double getLastEndToEndMs() const { return last_end_to_end_ms_; }
+    void printStats() const;
+
+    // 回放评估：用记录的检测序列预测 latency_ms 之后的目标位置，与之后实际检测到的位置（线性插值）比较
+    static PredictionResidual evaluateReplay(const std::vector<ReplayFrame>& frames, double latency_ms);
+    static void printResidual(const PredictionResidual& residual);
+};
+
+#endif // LATENCYCOMPENSATOR_H
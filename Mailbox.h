@@ -0,0 +1,45 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+
+// 单生产者 / 单消费者的"最新值"邮箱（三缓冲）：写入和读取都不加锁、不阻塞，
+// 读者总能拿到最近一次完整写入的值，被覆盖的旧值直接丢弃。
+// 适合视觉线程向控制线程投递目标估计：控制线程只关心最新一帧，不需要排队。
+template <typename T>
+class Mailbox {
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;   // 中间槽中有读者尚未取走的新值
+
+    alignas(64) T slots_[3];
+    alignas(64) std::atomic<uint8_t> middle_;   // 中间槽序号 | FRESH
+    alignas(64) uint8_t write_index_;           // 只由写者访问
+    alignas(64) uint8_t read_index_;            // 只由读者访问
+
+public:
+    Mailbox() : middle_(1), write_index_(0), read_index_(2) {}
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    // 写者：写入自己的槽后与中间槽交换
+    void publish(const T& value) {
+        slots_[write_index_] = value;
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(write_index_ | FRESH), std::memory_order_acq_rel);
+        write_index_ = previous & INDEX_MASK;
+    }
+
+    // 读者：有新值时与中间槽交换并拷出，返回 true；没有新值时 value 保持不变
+    bool fetch(T& value) {
+        if (!(middle_.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        uint8_t previous = middle_.exchange(read_index_, std::memory_order_acq_rel);
+        read_index_ = previous & INDEX_MASK;
+        value = slots_[read_index_];
+        return true;
+    }
+};
+
+#endif // MAILBOX_H
@@ -1,8 +1,10 @@
 #include "MotorController.h"
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <mutex>
 #include <cstdint>
+#include <chrono>
 
 // ============================================================================
 // 【核心配置参数】
@@ -15,26 +17,86 @@ constexpr float TARGET_PIXEL_OFFSET = 22.03f;
 // 死区阈值：5px (约17mm物理距离)
 constexpr float DEAD_ZONE_THRESHOLD = 5.0f;
 
+// 像素速度分档：死区 / 微动 / 低速 / 中速 / 高速 的上界
+constexpr float PIXEL_SPEED_THRESHOLDS[5] = {DEAD_ZONE_THRESHOLD, 6.0f, 15.0f, 45.0f, 90.0f};
+
+// 上述像素参数整定时的标称焦距（2448x2048 全分辨率），用于换算默认角度分档
+constexpr float NOMINAL_FOCAL_LENGTH_PX = 4968.4f;
+
+namespace {
+double steadyNowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
 MotorController::MotorController() 
     : state_(MotorState::IDLE),
-      current_position_(0.0f),
       is_connected_(false),
-      last_data_value_(0) {
+      log_commands_(true),
+      last_data_value_(0),
+      last_speed_command_(0.0f),
+      angular_bands_(defaultAngularSpeedBands()),
+      last_sent_kind_(CommandKind::NONE),
+      last_sent_value_(0),
+      last_sent_ms_(0.0),
+      last_reconnects_(0),
+      clock_ms_(steadyNowMs) {
+    serial_port_.setMcuWatchdog(schedule_.mcu_watchdog_ms);
+}
+
+AngularSpeedBands MotorController::defaultAngularSpeedBands() {
+    AngularSpeedBands bands;
+    bands.target_offset = std::atan(TARGET_PIXEL_OFFSET / NOMINAL_FOCAL_LENGTH_PX);
+    for (int i = 0; i < 5; ++i) {
+        bands.thresholds[i] = std::atan(PIXEL_SPEED_THRESHOLDS[i] / NOMINAL_FOCAL_LENGTH_PX);
+    }
+    return bands;
+}
+
+void MotorController::setAngularSpeedBands(const AngularSpeedBands& bands) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    angular_bands_ = bands;
+}
+
+AngularSpeedBands MotorController::getAngularSpeedBands() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return angular_bands_;
+}
+
+int8_t MotorController::speedLevel(float control_error, const float thresholds[5]) {
+    float abs_control_error = std::fabs(control_error);
+    int8_t level = 5;
+    for (int i = 0; i < 5; ++i) {
+        if (abs_control_error < thresholds[i]) {
+            level = static_cast<int8_t>(i);
+            break;
+        }
+    }
+    if (level == 0) {
+        // 死区内：停止
+        state_ = MotorState::STOPPED;
+        return 0;
+    }
+    state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
+    return (control_error > 0) ? level : static_cast<int8_t>(-level);
 }
 
 MotorController::~MotorController() {
     disconnect();
 }
 
-bool MotorController::connect(const std::string& port_name) {
+bool MotorController::connect(const std::string& port_name, int baud_rate) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (is_connected_) return true;
     
-    if (serial_port_.connect(port_name, 115200)) {
+    if (serial_port_.connect(port_name, baud_rate)) {
         is_connected_ = true;
         state_ = MotorState::IDLE;
         last_data_value_ = 0;
+        last_sent_kind_ = CommandKind::NONE;
+        last_reconnects_ = serial_port_.getReconnectCount();
+        clock_ms_ = steadyNowMs;
         std::cout << "电机控制器已通过串口连接: " << port_name << std::endl;
         return true;
     } else {
@@ -43,6 +105,97 @@ bool MotorController::connect(const std::string& port_name) {
     }
 }
 
+bool MotorController::connectSimulated(const SerialPort::WriteSink& sink, const std::function<double()>& clock_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!serial_port_.connectSimulated(sink)) {
+        return false;
+    }
+    last_sent_kind_ = CommandKind::NONE;
+    clock_ms_ = clock_ms ? clock_ms : std::function<double()>(steadyNowMs);
+    is_connected_ = true;
+    state_ = MotorState::IDLE;
+    last_data_value_ = 0;
+    last_speed_command_ = 0.0f;
+    return true;
+}
+
+void MotorController::receiveSimulated(const uint8_t* data, size_t size) {
+    serial_port_.receiveSimulated(data, size);
+}
+
+bool MotorController::setProtocolVersion(int version) {
+    return serial_port_.setProtocolVersion(version);
+}
+
+void MotorController::setLatencyProfile(const SerialLatencyProfile& profile) {
+    serial_port_.setLatencyProfile(profile);
+}
+
+SerialTuningReport MotorController::getTuningReport() const {
+    return serial_port_.getTuningReport();
+}
+
+void MotorController::setAutoReconnect(bool enabled) {
+    serial_port_.setAutoReconnect(enabled);
+}
+
+SerialLinkStats MotorController::getLinkStats() const {
+    return serial_port_.getLinkStats();
+}
+
+void MotorController::setCommandSchedule(const CommandSchedule& schedule) {
+    if (schedule.mcu_watchdog_ms > 0 && schedule.mcu_watchdog_ms < 2.0 * schedule.keepalive_ms) {
+        std::cerr << "警告: 下位机看门狗 " << schedule.mcu_watchdog_ms << "ms 小于两个保活周期 (" << schedule.keepalive_ms
+                  << "ms)，丢失一帧保活即会停止电机" << std::endl;
+    } else if (schedule.mcu_watchdog_ms > 0 && schedule.keepalive_ms <= 0) {
+        std::cerr << "警告: 未启用保活，指令长时间不变时下位机看门狗会停止电机" << std::endl;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        schedule_ = schedule;
+    }
+    serial_port_.setMcuWatchdog(schedule.mcu_watchdog_ms);
+}
+
+CommandSchedule MotorController::getCommandSchedule() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return schedule_;
+}
+
+CommandStats MotorController::getCommandStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return command_stats_;
+}
+
+bool MotorController::shouldSend(CommandKind kind, int value, bool& keepalive) {
+    command_stats_.requested++;
+    keepalive = false;
+    unsigned long reconnects = serial_port_.getReconnectCount();
+    if (reconnects != last_reconnects_) {
+        last_reconnects_ = reconnects;
+        last_sent_kind_ = CommandKind::NONE;
+    }
+    if (!schedule_.deduplicate || kind != last_sent_kind_ || value != last_sent_value_) {
+        return true;
+    }
+    if (schedule_.keepalive_ms > 0.0 && clock_ms_() - last_sent_ms_ >= schedule_.keepalive_ms) {
+        keepalive = true;
+        return true;
+    }
+    command_stats_.deduplicated++;
+    return false;
+}
+
+void MotorController::markSent(CommandKind kind, int value, bool keepalive) {
+    last_sent_kind_ = kind;
+    last_sent_value_ = value;
+    last_sent_ms_ = clock_ms_();
+    command_stats_.sent++;
+    if (keepalive) {
+        command_stats_.keepalives++;
+    }
+}
+
 void MotorController::disconnect() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (is_connected_) {
@@ -86,47 +239,83 @@ void MotorController::sendData(float pixel_error) {
     float control_error = pixel_error - TARGET_PIXEL_OFFSET;
     float abs_control_error = std::fabs(control_error);
     
-    if (abs_control_error < DEAD_ZONE_THRESHOLD) {
-        // 死区内：停止
-        data_value = 0;
-        state_ = MotorState::STOPPED;
-    } 
-    else if (abs_control_error < 6.0f) {
-        // 微动 (速度1)
-        data_value = (control_error > 0) ? 1 : -1;
-        state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
-    } 
-    else if (abs_control_error < 15.0f) {
-        // 低速 (速度2)
-        data_value = (control_error > 0) ? 2 : -2;
-        state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
-    } 
-    else if (abs_control_error < 45.0f) {
-        // 中速 (速度3)
-        data_value = (control_error > 0) ? 3 : -3;
-        state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
-    } 
-    else if (abs_control_error < 90.0f) {
-        // 高速 (速度4)
-        data_value = (control_error > 0) ? 4 : -4;
-        state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
-    } 
-    else {
-        // 全速 (速度5)
-        data_value = (control_error > 0) ? 5 : -5;
-        state_ = (control_error > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
+    // 死区 / 微动(1) / 低速(2) / 中速(3) / 高速(4) / 全速(5)
+    data_value = speedLevel(control_error, PIXEL_SPEED_THRESHOLDS);
+    
+    bool keepalive = false;
+    if (!shouldSend(CommandKind::LEVEL, data_value, keepalive)) {
+        return;
+    }
+    if (serial_port_.sendDataFrame(data_value)) {
+        markSent(CommandKind::LEVEL, data_value, keepalive);
+        last_data_value_ = data_value;
+        
+        if (log_commands_ && !keepalive) {
+            std::cout << "电机控制: 原始误差=" << pixel_error 
+                      << "px, 控制误差(距22px)=" << control_error 
+                      << "px, 绝对误差=" << abs_control_error
+                      << ", 命令值=" << static_cast<int>(data_value)
+                      << ", 状态=" << getStateString() << std::endl;
+        }
     }
+}
+
+void MotorController::sendAngularError(float angle_error) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
+    if (!is_connected_) {
+        return;
+    }
+    
+    // 与像素模式同样的符号约定：误差 > 0 表示目标在期望方向右侧，电机向右转
+    float control_error = angle_error - angular_bands_.target_offset;
+    int8_t data_value = speedLevel(control_error, angular_bands_.thresholds);
+    
+    bool keepalive = false;
+    if (!shouldSend(CommandKind::LEVEL, data_value, keepalive)) {
+        return;
+    }
     if (serial_port_.sendDataFrame(data_value)) {
+        markSent(CommandKind::LEVEL, data_value, keepalive);
         last_data_value_ = data_value;
-        float degree_per_data = 2.0f;
-        current_position_ += data_value * degree_per_data;
         
-        std::cout << "电机控制: 原始误差=" << pixel_error 
-                  << "px, 控制误差(距22px)=" << control_error 
-                  << "px, 绝对误差=" << abs_control_error
-                  << ", 命令值=" << static_cast<int>(data_value)
-                  << ", 状态=" << getStateString() << std::endl;
+        if (log_commands_ && !keepalive) {
+            std::cout << "电机控制: 角度误差=" << angle_error * 1000.0f
+                      << "mrad, 控制误差=" << control_error * 1000.0f
+                      << "mrad, 命令值=" << static_cast<int>(data_value)
+                      << ", 状态=" << getStateString() << std::endl;
+        }
+    }
+}
+
+void MotorController::sendSpeedCommand(float normalized_speed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!is_connected_) {
+        return;
+    }
+    
+    normalized_speed = std::max(-1.0f, std::min(normalized_speed, 1.0f));
+    int16_t speed = static_cast<int16_t>(std::lround(normalized_speed * SPEED_FRAME_FULL_SCALE));
+    bool keepalive = false;
+    if (!shouldSend(CommandKind::SPEED, speed, keepalive)) {
+        return;
+    }
+    if (serial_port_.sendSpeedFrame(speed)) {
+        markSent(CommandKind::SPEED, speed, keepalive);
+        last_speed_command_ = normalized_speed;
+        // 界面仍显示 -5..5，按满速比例折算
+        last_data_value_ = static_cast<int8_t>(std::lround(normalized_speed * 5.0f));
+        if (speed == 0) {
+            state_ = MotorState::STOPPED;
+        } else {
+            state_ = (speed > 0) ? MotorState::MOVING_RIGHT : MotorState::MOVING_LEFT;
+        }
+        
+        if (log_commands_ && !keepalive) {
+            std::cout << "电机控制: 速度指令=" << normalized_speed * 100.0f
+                      << "%, 状态=" << getStateString() << std::endl;
+        }
     }
 }
 
@@ -144,9 +333,14 @@ std::string MotorController::getStateString() const {
 void MotorController::stop() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (is_connected_) {
-        serial_port_.sendDataFrame(0);
+        // 档位帧 0 在两种指令模式下都表示停止；停止不去重，总是发送
+        command_stats_.requested++;
+        if (serial_port_.sendDataFrame(0)) {
+            markSent(CommandKind::LEVEL, 0, false);
+        }
         state_ = MotorState::STOPPED;
         last_data_value_ = 0;
+        last_speed_command_ = 0.0f;
         std::cout << "电机紧急停止" << std::endl;
     }
 }
@@ -157,20 +351,47 @@ MotorState MotorController::getState() const {
 }
 
 float MotorController::getCurrentPosition() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return current_position_;
+    MotorTelemetry telemetry;
+    return serial_port_.getTelemetry(telemetry) ? static_cast<float>(telemetry.position) : 0.0f;
 }
 
 float MotorController::getCurrentSpeed() const {
+    MotorTelemetry telemetry;
+    return serial_port_.getTelemetry(telemetry) ? static_cast<float>(telemetry.velocity) : 0.0f;
+}
+
+bool MotorController::getTelemetry(MotorTelemetry& telemetry) const {
+    return serial_port_.getTelemetry(telemetry);
+}
+
+int8_t MotorController::getLastDataValue() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return last_data_value_ * 10.0f;
+    return last_data_value_;
+}
+
+float MotorController::getLastSpeedCommand() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_speed_command_;
 }
 
 bool MotorController::isConnected() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return is_connected_;
+    // 串口自动重连期间视为未连接
+    return is_connected_ && serial_port_.isConnected();
 }
 
 std::string MotorController::getPortName() const {
     return serial_port_.getPortName();
-}
\ No newline at end of file
+}
+
+double MotorController::getLastWriteDurationMs() const {
+    return serial_port_.getLastWriteDurationMs();
+}
+
+SerialWriteStats MotorController::getSerialStats() const {
+    return serial_port_.getWriteStats();
+}
+
+SerialReceiveStats MotorController::getReceiveStats() const {
+    return serial_port_.getReceiveStats();
+}
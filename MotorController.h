@@ -4,8 +4,32 @@
 #include <string>
 #include <mutex>
 #include <atomic>
+#include <functional>
 #include "SerialPort.h"
 
+// 角度空间的速度分档（弧度）：|误差| < thresholds[0] 为死区，
+// 依次小于 thresholds[1..4] 对应速度 1..4，超过 thresholds[4] 为速度 5
+struct AngularSpeedBands {
+    float target_offset = 0.0f;   // 期望的目标水平角（发射架中轴线相对相机光轴），右为正
+    float thresholds[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// 指令调度：与上次发出的指令相同时不重复发送，只按保活周期重发一次（同时补上可能丢失的帧）。
+// 保活只由调用方的指令驱动，不由后台定时器代发：视觉/控制线程卡住时保活随之停止，
+// 下位机看门狗（协议 v2）在电机转动且超时未收到指令时自行停止
+struct CommandSchedule {
+    bool deduplicate = true;
+    double keepalive_ms = 100.0;     // 指令不变时的重发周期，<= 0 只在变化时发送
+    int mcu_watchdog_ms = 300;       // 下位机看门狗超时，0 关闭；应为保活周期的数倍
+};
+
+struct CommandStats {
+    unsigned long requested = 0;     // 调用方提交的指令
+    unsigned long sent = 0;          // 实际交给串口的帧（含保活）
+    unsigned long keepalives = 0;    // 指令不变、按保活周期重发
+    unsigned long deduplicated = 0;  // 与上次相同而未发送
+};
+
 enum class MotorState {
     IDLE,
     MOVING_LEFT,
@@ -19,26 +43,80 @@ public:
     MotorController();
     ~MotorController();
 
-    bool connect(const std::string& port_name);
+    bool connect(const std::string& port_name, int baud_rate = 115200);
     void disconnect();
+    // 仿真模式：指令帧的字节交给 sink，不打开串口设备；clock_ms 为保活计时用的仿真时钟（毫秒）
+    bool connectSimulated(const SerialPort::WriteSink& sink, const std::function<double()>& clock_ms = nullptr);
+    // 仿真模式下下位机回复的字节
+    void receiveSimulated(const uint8_t* data, size_t size);
+    // 串口协议版本（1: 旧固件只写帧；2: 带 ACK 与遥测），连接前设置
+    bool setProtocolVersion(int version);
+    // 低延迟配置（ASYNC_LOW_LATENCY、USB latency_timer、收发线程优先级），连接前设置
+    void setLatencyProfile(const SerialLatencyProfile& profile);
+    SerialTuningReport getTuningReport() const;
+    // 串口设备拔出或 USB 复位后在后台自动重连（默认开启），重连后先发送停止指令
+    void setAutoReconnect(bool enabled);
+    SerialLinkStats getLinkStats() const;
+    // 指令去重、保活周期与下位机看门狗
+    void setCommandSchedule(const CommandSchedule& schedule);
+    CommandSchedule getCommandSchedule() const;
+    CommandStats getCommandStats() const;
     void sendData(float pixel_error);
+    // 角度误差模式：angle_error 为目标相对光轴的水平角（弧度），按角度分档
+    void sendAngularError(float angle_error);
+    // 连续速度指令：normalized_speed 为 -1..1 的满速比例，> 0 向右转
+    void sendSpeedCommand(float normalized_speed);
+    void setAngularSpeedBands(const AngularSpeedBands& bands);
+    AngularSpeedBands getAngularSpeedBands() const;
+    // 旧像素分档在标称焦距下对应的角度分档
+    static AngularSpeedBands defaultAngularSpeedBands();
     void stop();
     
     MotorState getState() const;
     std::string getStateString() const;
+    // 下位机遥测的转台角度（弧度）与角速度（弧度/秒）；未收到遥测（协议 v1）时为 0
     float getCurrentPosition() const;
     float getCurrentSpeed() const;
+    bool getTelemetry(MotorTelemetry& telemetry) const;
+    int8_t getLastDataValue() const;
+    float getLastSpeedCommand() const;   // 最近一次连续速度指令（满速比例）
     bool isConnected() const;
     std::string getPortName() const;
+    double getLastWriteDurationMs() const;  // 最近一帧从入队到发送完毕的时间
+    SerialWriteStats getSerialStats() const;
+    SerialReceiveStats getReceiveStats() const;
+    // 打印发生变化的指令（保活与去重的不打印）；高频控制线程中关闭，避免终端输出拖慢控制周期
+    void setCommandLogging(bool enabled) { log_commands_ = enabled; }
+    // 打印写出的串口帧字节（调试用，默认关闭）
+    void setFrameLogging(bool enabled) { serial_port_.setFrameLogging(enabled); }
 
 private:
     SerialPort serial_port_;
     mutable std::mutex mutex_;
     
     std::atomic<MotorState> state_;
-    float current_position_;
     std::atomic<bool> is_connected_;
+    std::atomic<bool> log_commands_;
     int8_t last_data_value_;
+    float last_speed_command_;
+    AngularSpeedBands angular_bands_;
+    
+    // 指令调度（mutex_ 保护）
+    enum class CommandKind { NONE, LEVEL, SPEED };
+    CommandSchedule schedule_;
+    CommandStats command_stats_;
+    CommandKind last_sent_kind_;
+    int last_sent_value_;
+    double last_sent_ms_;
+    unsigned long last_reconnects_;  // 串口重连后（下位机已收到停止）不再沿用上次的去重状态
+    std::function<double()> clock_ms_;
+
+    // 本次指令是否需要发送；keepalive 返回是否为保活重发。调用方持有 mutex_
+    bool shouldSend(CommandKind kind, int value, bool& keepalive);
+    void markSent(CommandKind kind, int value, bool keepalive);
+
+    // 按分档阈值把带符号误差映射为 -5..5 的命令值并更新状态
+    int8_t speedLevel(float control_error, const float thresholds[5]);
 };
 
 #endif // MOTOR_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "PackedMorphology.h"
+#include <cstring>
+
+namespace {
+
+// 8字节中每个非零字节置最高位，其余清零
+inline uint64_t nonZeroBytes(uint64_t v) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    return (((v & low7) + low7) | v) & 0x8080808080808080ULL;
+}
+
+// 将 8 个字节的最高位收集为 8 个连续位（小端序，字节 k -> 位 k）
+inline uint64_t gatherBytes(uint64_t high_bits) {
+    return ((high_bits >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+// 8 位 -> 8 个 0/255 字节的查找表
+struct UnpackTable {
+    uint64_t entries[256];
+    UnpackTable() {
+        for (int b = 0; b < 256; ++b) {
+            uint64_t v = 0;
+            for (int k = 0; k < 8; ++k) {
+                if (b & (1 << k)) v |= 0xFFULL << (8 * k);
+            }
+            entries[b] = v;
+        }
+    }
+};
+
+const UnpackTable& unpackTable() {
+    static const UnpackTable table;
+    return table;
+}
+
+// 十字形 3x3 结构元素的逐字运算；kErode 为 true 时做腐蚀，否则做膨胀
+template <bool kErode>
+void crossKernel(const BitMask& src, BitMask& dst) {
+    const int rows = src.rows();
+    const int wpr = src.wordsPerRow();
+    const uint64_t fill = kErode ? ~0ULL : 0ULL;   // 图像外像素的取值
+    const uint64_t tail = src.tailMask();
+
+    dst.create(rows, src.cols());
+
+    // 读取一个字；越界时返回边界值，腐蚀时行尾填充位视为前景
+    auto word = [&](const uint64_t* r, int i) -> uint64_t {
+        if (r == nullptr || i < 0 || i >= wpr) return fill;
+        uint64_t v = r[i];
+        if (kErode && i == wpr - 1) v |= ~tail;
+        return v;
+    };
+
+    for (int y = 0; y < rows; ++y) {
+        const uint64_t* up = (y > 0) ? src.row(y - 1) : nullptr;
+        const uint64_t* cur = src.row(y);
+        const uint64_t* down = (y + 1 < rows) ? src.row(y + 1) : nullptr;
+        uint64_t* out = dst.row(y);
+
+        for (int i = 0; i < wpr; ++i) {
+            uint64_t c = word(cur, i);
+            uint64_t l = (c << 1) | (word(cur, i - 1) >> 63);   // 左邻像素 x-1
+            uint64_t r = (c >> 1) | (word(cur, i + 1) << 63);   // 右邻像素 x+1
+            uint64_t u = word(up, i);
+            uint64_t d = word(down, i);
+            uint64_t v = kErode ? (c & l & r & u & d) : (c | l | r | u | d);
+            out[i] = (i == wpr - 1) ? (v & tail) : v;
+        }
+    }
+}
+
+} // namespace
+
+BitMask::BitMask() : rows_(0), cols_(0), words_per_row_(0) {}
+
+BitMask::BitMask(int rows, int cols) : BitMask() {
+    create(rows, cols);
+}
+
+void BitMask::create(int rows, int cols) {
+    if (rows == rows_ && cols == cols_ && !data_.empty()) return;
+    rows_ = rows;
+    cols_ = cols;
+    words_per_row_ = (cols + 63) / 64;
+    data_.assign(static_cast<size_t>(rows_) * words_per_row_, 0);
+}
+
+uint64_t BitMask::tailMask() const {
+    int valid = cols_ - (words_per_row_ - 1) * 64;
+    return (valid >= 64) ? ~0ULL : ((1ULL << valid) - 1);
+}
+
+void BitMask::pack(const cv::Mat& mask, BitMask& dst) {
+    CV_Assert(mask.type() == CV_8UC1);
+    dst.create(mask.rows, mask.cols);
+
+    const int cols = mask.cols;
+    for (int y = 0; y < mask.rows; ++y) {
+        const uchar* src = mask.ptr<uchar>(y);
+        uint64_t* out = dst.row(y);
+
+        for (int i = 0; i < dst.words_per_row_; ++i) {
+            const int x0 = i * 64;
+            const int n = std::min(64, cols - x0);
+            uint64_t w = 0;
+            int k = 0;
+            // 每次处理 8 个像素
+            for (; k + 8 <= n; k += 8) {
+                uint64_t bytes;
+                std::memcpy(&bytes, src + x0 + k, sizeof(bytes));
+                w |= gatherBytes(nonZeroBytes(bytes)) << k;
+            }
+            for (; k < n; ++k) {
+                if (src[x0 + k]) w |= 1ULL << k;
+            }
+            out[i] = w;
+        }
+    }
+}
+
+void BitMask::unpack(cv::Mat& dst) const {
+    dst.create(rows_, cols_, CV_8UC1);
+    const UnpackTable& table = unpackTable();
+
+    for (int y = 0; y < rows_; ++y) {
+        const uint64_t* in = row(y);
+        uchar* out = dst.ptr<uchar>(y);
+
+        for (int i = 0; i < words_per_row_; ++i) {
+            const int x0 = i * 64;
+            const int n = std::min(64, cols_ - x0);
+            uint64_t w = in[i];
+            int k = 0;
+            for (; k + 8 <= n; k += 8) {
+                uint64_t bytes = table.entries[(w >> k) & 0xFF];
+                std::memcpy(out + x0 + k, &bytes, sizeof(bytes));
+            }
+            for (; k < n; ++k) {
+                out[x0 + k] = ((w >> k) & 1ULL) ? 255 : 0;
+            }
+        }
+    }
+}
+
+void BitMask::andWith(const BitMask& other) {
+    CV_Assert(other.rows_ == rows_ && other.cols_ == cols_);
+    for (size_t i = 0; i < data_.size(); ++i) data_[i] &= other.data_[i];
+}
+
+void BitMask::orWith(const BitMask& other) {
+    CV_Assert(other.rows_ == rows_ && other.cols_ == cols_);
+    for (size_t i = 0; i < data_.size(); ++i) data_[i] |= other.data_[i];
+}
+
+void PackedMorphology::dilate3x3(const BitMask& src, BitMask& dst) {
+    crossKernel<false>(src, dst);
+}
+
+void PackedMorphology::erode3x3(const BitMask& src, BitMask& dst) {
+    crossKernel<true>(src, dst);
+}
+
+void PackedMorphology::close3x3(BitMask& mask, BitMask& tmp) {
+    dilate3x3(mask, tmp);
+    erode3x3(tmp, mask);
+}
+
+void PackedMorphology::closeOpen3x3(BitMask& mask, BitMask& tmp) {
+    dilate3x3(mask, tmp);
+    erode3x3(tmp, mask);
+    erode3x3(mask, tmp);
+    dilate3x3(tmp, mask);
+}
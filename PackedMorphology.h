@@ -0,0 +1,61 @@
+#ifndef PACKEDMORPHOLOGY_H
+#define PACKEDMORPHOLOGY_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <cstdint>
+
+// 位压缩二值掩码：1 bit/像素，每个 uint64_t 存放一行中连续的 64 个像素
+// 第 i 个字的第 j 位对应像素 x = i * 64 + j；行尾填充位始终保持为 0
+class BitMask {
+private:
+    int rows_;
+    int cols_;
+    int words_per_row_;
+    std::vector<uint64_t> data_;
+
+public:
+    BitMask();
+    BitMask(int rows, int cols);
+
+    // 分配存储（尺寸不变时不重新分配）
+    void create(int rows, int cols);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int wordsPerRow() const { return words_per_row_; }
+    bool empty() const { return data_.empty(); }
+
+    uint64_t* row(int y) { return data_.data() + static_cast<size_t>(y) * words_per_row_; }
+    const uint64_t* row(int y) const { return data_.data() + static_cast<size_t>(y) * words_per_row_; }
+
+    // 每行最后一个字中有效位的掩码
+    uint64_t tailMask() const;
+
+    // 8位掩码（非零即为前景）压缩为位掩码
+    static void pack(const cv::Mat& mask, BitMask& dst);
+
+    // 解压为 0/255 的 CV_8UC1 掩码
+    void unpack(cv::Mat& dst) const;
+
+    // 逐字逻辑运算：this = this & other / this | other
+    void andWith(const BitMask& other);
+    void orWith(const BitMask& other);
+};
+
+// 基于位压缩掩码的 3x3 形态学运算
+// 3x3 的 MORPH_ELLIPSE 结构元素即十字形，每个字一次处理 64 个像素；
+// 边界处理与 cv::morphologyEx 默认行为一致（腐蚀时边界视为前景，膨胀时视为背景）
+class PackedMorphology {
+public:
+    static void dilate3x3(const BitMask& src, BitMask& dst);
+    static void erode3x3(const BitMask& src, BitMask& dst);
+
+    // 闭运算（膨胀后腐蚀），tmp 为复用的中间缓冲
+    static void close3x3(BitMask& mask, BitMask& tmp);
+
+    // 融合的闭运算+开运算：膨胀-腐蚀-腐蚀-膨胀，全程不解压
+    static void closeOpen3x3(BitMask& mask, BitMask& tmp);
+};
+
+#endif // PACKEDMORPHOLOGY_H
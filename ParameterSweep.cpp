@@ -0,0 +1,382 @@
+#include "ParameterSweep.h"
+#include "VisionDetector.h"
+#include "DetectionResult.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// 比较两个评估点：F1 优先，其次单帧耗时
+bool betterThan(const SweepPoint& a, const SweepPoint& b) {
+    if (std::fabs(a.f1 - b.f1) > 1e-9) return a.f1 > b.f1;
+    return a.mean_latency_ms < b.mean_latency_ms;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+ParameterSweep::ParameterSweep(const SweepOptions& options) : options_(options) {
+    options_.workers = std::max(1, options_.workers);
+}
+
+bool ParameterSweep::loadLabels(const std::string& file_name) {
+    std::ifstream in(file_name);
+    if (!in.is_open()) {
+        std::cerr << "无法打开标注文件: " << file_name << std::endl;
+        return false;
+    }
+
+    namespace fs = std::filesystem;
+    fs::path base = fs::path(file_name).parent_path();
+
+    // 同一图像可以有多行（多个目标），按出现顺序合并
+    std::map<std::string, size_t> index_of;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(trim(field));
+        if (fields.empty() || fields[0] == "file" || fields[0] == "filename") continue;
+
+        std::string path = (base / fields[0]).string();
+        auto it = index_of.find(path);
+        if (it == index_of.end()) {
+            LabelledFrame frame;
+            frame.path = path;
+            frames_.push_back(frame);
+            it = index_of.emplace(path, frames_.size() - 1).first;
+        }
+
+        if (fields.size() >= 3 && !fields[1].empty() && !fields[2].empty()) {
+            float radius = (fields.size() >= 4 && !fields[3].empty()) ? std::stof(fields[3]) : 0.0f;
+            frames_[it->second].targets.push_back(cv::Vec3f(std::stof(fields[1]), std::stof(fields[2]), radius));
+        }
+    }
+
+    // 图像只解码一次，所有评估点共享（只读）
+    size_t targets = 0;
+    for (auto& frame : frames_) {
+        frame.image = cv::imread(frame.path, cv::IMREAD_COLOR);
+        if (frame.image.empty()) {
+            std::cerr << "无法读取标注图像: " << frame.path << std::endl;
+            return false;
+        }
+        targets += frame.targets.size();
+    }
+
+    std::cout << "已加载标注回放集: " << frames_.size() << " 帧, " << targets << " 个目标" << std::endl;
+    return !frames_.empty();
+}
+
+bool ParameterSweep::loadSearchSpace(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开搜索空间文件: " << file_name << std::endl;
+        return false;
+    }
+
+    const auto& known = VisionDetector::parameterNames();
+    cv::FileNode root = fs.root();
+    for (const auto& name : root.keys()) {
+        if (std::find(known.begin(), known.end(), name) == known.end()) {
+            std::cerr << "未知的检测参数: " << name << std::endl;
+            return false;
+        }
+
+        cv::FileNode node = root[name];
+        std::vector<double> values;
+        if (node.isSeq()) {
+            for (size_t i = 0; i < node.size(); ++i) values.push_back(static_cast<double>(node[static_cast<int>(i)]));
+        } else if (node.isMap()) {
+            double lo = static_cast<double>(node["min"]);
+            double hi = static_cast<double>(node["max"]);
+            double step = static_cast<double>(node["step"]);
+            if (step <= 0 || hi < lo) {
+                std::cerr << "参数 " << name << " 的范围无效" << std::endl;
+                return false;
+            }
+            for (double v = lo; v <= hi + step * 1e-6; v += step) values.push_back(v);
+        } else {
+            values.push_back(static_cast<double>(node));
+        }
+
+        if (values.empty()) {
+            std::cerr << "参数 " << name << " 没有候选值" << std::endl;
+            return false;
+        }
+        space_.emplace_back(name, values);
+    }
+
+    std::cout << "搜索空间: " << space_.size() << " 个参数, 网格共 " << gridSize() << " 个点" << std::endl;
+    return !space_.empty();
+}
+
+size_t ParameterSweep::gridSize() const {
+    size_t total = 1;
+    for (const auto& dim : space_) total *= dim.second.size();
+    return total;
+}
+
+std::string ParameterSweep::pointKey(const std::map<std::string, double>& params) const {
+    std::ostringstream key;
+    key << std::setprecision(10);
+    for (const auto& p : params) key << p.first << '=' << p.second << ';';
+    return key.str();
+}
+
+std::vector<std::map<std::string, double>> ParameterSweep::gridPoints() const {
+    std::vector<std::map<std::string, double>> points;
+    std::vector<size_t> index(space_.size(), 0);
+    while (true) {
+        std::map<std::string, double> params;
+        for (size_t d = 0; d < space_.size(); ++d) params[space_[d].first] = space_[d].second[index[d]];
+        points.push_back(params);
+
+        // 多维计数器递增
+        size_t d = 0;
+        while (d < space_.size() && ++index[d] == space_[d].second.size()) {
+            index[d] = 0;
+            ++d;
+        }
+        if (d == space_.size()) break;
+    }
+    return points;
+}
+
+std::vector<std::map<std::string, double>> ParameterSweep::randomPoints(int count) const {
+    std::mt19937 rng(options_.seed);
+    std::vector<std::map<std::string, double>> points;
+    for (int i = 0; i < count; ++i) {
+        std::map<std::string, double> params;
+        for (const auto& dim : space_) {
+            std::uniform_int_distribution<size_t> pick(0, dim.second.size() - 1);
+            params[dim.first] = dim.second[pick(rng)];
+        }
+        points.push_back(params);
+    }
+    return points;
+}
+
+std::vector<std::map<std::string, double>> ParameterSweep::neighbours(const std::map<std::string, double>& params) const {
+    std::vector<std::map<std::string, double>> points;
+    for (const auto& dim : space_) {
+        const std::vector<double>& values = dim.second;
+        auto it = std::find(values.begin(), values.end(), params.at(dim.first));
+        if (it == values.end()) continue;
+        size_t i = static_cast<size_t>(it - values.begin());
+        if (i > 0) {
+            auto p = params;
+            p[dim.first] = values[i - 1];
+            points.push_back(p);
+        }
+        if (i + 1 < values.size()) {
+            auto p = params;
+            p[dim.first] = values[i + 1];
+            points.push_back(p);
+        }
+    }
+    return points;
+}
+
+void ParameterSweep::matchDetections(const std::vector<cv::Vec3f>& labels, const std::vector<cv::Point2f>& detections,
+                                     double tolerance_px, int& true_positives, int& false_positives, int& false_negatives) {
+    std::vector<bool> used(detections.size(), false);
+    for (const auto& label : labels) {
+        double limit = std::max<double>(tolerance_px, label[2]);
+        int best = -1;
+        double best_dist = limit;
+        for (size_t i = 0; i < detections.size(); ++i) {
+            if (used[i]) continue;
+            double dist = std::hypot(detections[i].x - label[0], detections[i].y - label[1]);
+            if (dist <= best_dist) {
+                best_dist = dist;
+                best = static_cast<int>(i);
+            }
+        }
+        if (best >= 0) {
+            used[best] = true;
+            true_positives++;
+        } else {
+            false_negatives++;
+        }
+    }
+    for (bool u : used) {
+        if (!u) false_positives++;
+    }
+}
+
+SweepPoint ParameterSweep::evaluate(const std::map<std::string, double>& params) const {
+    VisionDetector detector;
+    detector.setRenderResults(false);
+    if (!options_.base_params_path.empty()) {
+        detector.loadParameters(options_.base_params_path);
+    }
+    for (const auto& p : params) detector.setParameter(p.first, p.second);
+
+    SweepPoint point;
+    point.params = params;
+
+    std::vector<double> latencies;
+    latencies.reserve(frames_.size());
+    std::vector<DetectionResult> results;
+    std::vector<cv::Point2f> centers;
+    for (const auto& frame : frames_) {
+        auto start = std::chrono::high_resolution_clock::now();
+        detector.detectGreenCirclesWithResults(frame.image, results);
+        auto end = std::chrono::high_resolution_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        centers.clear();
+        for (const auto& res : results) centers.push_back(cv::Point2f(res.circle[0], res.circle[1]));
+        matchDetections(frame.targets, centers, options_.match_tolerance_px,
+                        point.true_positives, point.false_positives, point.false_negatives);
+    }
+
+    int tp = point.true_positives;
+    point.precision = (tp + point.false_positives > 0) ? static_cast<double>(tp) / (tp + point.false_positives) : 1.0;
+    point.recall = (tp + point.false_negatives > 0) ? static_cast<double>(tp) / (tp + point.false_negatives) : 1.0;
+    point.f1 = (point.precision + point.recall > 0)
+        ? 2.0 * point.precision * point.recall / (point.precision + point.recall) : 0.0;
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0.0;
+    for (double v : latencies) sum += v;
+    point.mean_latency_ms = latencies.empty() ? 0.0 : sum / latencies.size();
+    point.p95_latency_ms = latencies.empty() ? 0.0
+        : latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+    return point;
+}
+
+void ParameterSweep::evaluateAll(const std::vector<std::map<std::string, double>>& candidates) {
+    // 去重后并行评估，每个线程独立创建检测器
+    std::vector<std::map<std::string, double>> pending;
+    for (const auto& params : candidates) {
+        if (evaluated_keys_.insert(pointKey(params)).second) pending.push_back(params);
+    }
+    if (pending.empty()) return;
+
+    std::vector<SweepPoint> results(pending.size());
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> done(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < options_.workers; ++w) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < pending.size(); i = next++) {
+                results[i] = evaluate(pending[i]);
+                size_t finished = ++done;
+                if (finished % 10 == 0 || finished == pending.size()) {
+                    std::cout << "\r已评估 " << finished << "/" << pending.size() << std::flush;
+                }
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    std::cout << std::endl;
+
+    evaluated_.insert(evaluated_.end(), results.begin(), results.end());
+}
+
+bool ParameterSweep::run() {
+    if (frames_.empty() || space_.empty()) {
+        std::cerr << "参数搜索需要先加载标注回放集和搜索空间" << std::endl;
+        return false;
+    }
+    if (options_.workers > 1) {
+        cv::setNumThreads(1);
+    }
+
+    if (options_.random_samples > 0) {
+        evaluateAll(randomPoints(options_.random_samples));
+    } else {
+        if (gridSize() > 100000) {
+            std::cerr << "网格点数过多 (" << gridSize() << ")，请使用 --random 随机采样" << std::endl;
+            return false;
+        }
+        evaluateAll(gridPoints());
+    }
+
+    // 局部细化：在当前最优点的相邻网格值上逐参数尝试，直到不再改进
+    for (int round = 0; round < options_.refine_rounds; ++round) {
+        SweepPoint current = *best();
+        evaluateAll(neighbours(current.params));
+        if (!betterThan(*best(), current)) break;
+        std::cout << "细化第 " << round + 1 << " 轮: F1 " << current.f1 << " -> " << best()->f1 << std::endl;
+    }
+    return true;
+}
+
+const SweepPoint* ParameterSweep::best() const {
+    const SweepPoint* result = nullptr;
+    for (const auto& point : evaluated_) {
+        if (result == nullptr || betterThan(point, *result)) result = &point;
+    }
+    return result;
+}
+
+bool ParameterSweep::writeReport(const std::string& file_name) const {
+    std::ofstream out(file_name);
+    if (!out.is_open()) {
+        std::cerr << "无法写入文件: " << file_name << std::endl;
+        return false;
+    }
+    for (const auto& dim : space_) out << dim.first << ',';
+    out << "true_positives,false_positives,false_negatives,precision,recall,f1,mean_latency_ms,p95_latency_ms\n";
+    out << std::fixed << std::setprecision(4);
+    for (const auto& point : evaluated_) {
+        for (const auto& dim : space_) out << point.params.at(dim.first) << ',';
+        out << point.true_positives << ',' << point.false_positives << ',' << point.false_negatives << ','
+            << point.precision << ',' << point.recall << ',' << point.f1 << ','
+            << point.mean_latency_ms << ',' << point.p95_latency_ms << '\n';
+    }
+    std::cout << "搜索报告已写入: " << file_name << std::endl;
+    return true;
+}
+
+bool ParameterSweep::writeBestParameters(const std::string& file_name) const {
+    const SweepPoint* point = best();
+    if (point == nullptr) return false;
+
+    VisionDetector detector;
+    if (!options_.base_params_path.empty()) {
+        detector.loadParameters(options_.base_params_path);
+    }
+    for (const auto& p : point->params) detector.setParameter(p.first, p.second);
+    if (!detector.saveParameters(file_name)) return false;
+
+    std::cout << "最优检测参数已写入: " << file_name << std::endl;
+    return true;
+}
+
+void ParameterSweep::printBest() const {
+    const SweepPoint* point = best();
+    if (point == nullptr) {
+        std::cout << "没有评估结果" << std::endl;
+        return;
+    }
+    std::cout << "=== 最优参数 (共评估 " << evaluated_.size() << " 个点) ===" << std::endl;
+    for (const auto& p : point->params) {
+        std::cout << "  " << p.first << " = " << p.second << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(4)
+              << "精确率: " << point->precision << ", 召回率: " << point->recall << ", F1: " << point->f1 << std::endl
+              << "单帧耗时 平均: " << point->mean_latency_ms << "ms, P95: " << point->p95_latency_ms << "ms" << std::endl;
+}
@@ -0,0 +1,82 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 带标注的回放帧：targets 为标注目标 (x, y, 半径)，为空表示该帧无目标
+struct LabelledFrame {
+    std::string path;
+    cv::Mat image;
+    std::vector<cv::Vec3f> targets;
+};
+
+// 参数空间中的一个评估点
+struct SweepPoint {
+    std::map<std::string, double> params;
+    int true_positives = 0;
+    int false_positives = 0;
+    int false_negatives = 0;
+    double precision = 0.0;
+    double recall = 0.0;
+    double f1 = 0.0;
+    double mean_latency_ms = 0.0;
+    double p95_latency_ms = 0.0;
+};
+
+struct SweepOptions {
+    int workers = 1;                  // 并行评估的线程数
+    int random_samples = 0;           // >0 时随机采样该数量的点，否则遍历完整网格
+    int refine_rounds = 0;            // 在最优点邻域做逐参数的局部细化轮数
+    unsigned int seed = 12345;        // 随机采样种子
+    double match_tolerance_px = 8.0;  // 检测中心与标注中心的匹配容差（像素）
+    std::string base_params_path;     // 可选：作为起点的检测参数文件
+};
+
+// 检测阈值参数搜索：在标注回放集上并行评估参数组合，输出精确率/召回率/单帧耗时
+class ParameterSweep {
+private:
+    SweepOptions options_;
+    std::vector<LabelledFrame> frames_;
+    // 搜索空间：参数名 -> 候选值（保持配置文件中的顺序）
+    std::vector<std::pair<std::string, std::vector<double>>> space_;
+    std::vector<SweepPoint> evaluated_;
+    std::set<std::string> evaluated_keys_;
+
+    SweepPoint evaluate(const std::map<std::string, double>& params) const;
+    void evaluateAll(const std::vector<std::map<std::string, double>>& candidates);
+    std::vector<std::map<std::string, double>> gridPoints() const;
+    std::vector<std::map<std::string, double>> randomPoints(int count) const;
+    std::vector<std::map<std::string, double>> neighbours(const std::map<std::string, double>& params) const;
+    std::string pointKey(const std::map<std::string, double>& params) const;
+    size_t gridSize() const;
+
+public:
+    explicit ParameterSweep(const SweepOptions& options);
+
+    // 标注文件：CSV，每行 "图像路径,x,y,半径"；x 为空表示该帧无目标；路径相对标注文件所在目录
+    bool loadLabels(const std::string& file_name);
+
+    // 搜索空间：YAML 映射，每个参数为候选值序列或 {min, max, step}
+    bool loadSearchSpace(const std::string& file_name);
+
+    bool run();
+
+    // 最优点（F1 最高，相同时耗时更短），没有结果时返回空指针
+    const SweepPoint* best() const;
+    const std::vector<SweepPoint>& getEvaluated() const { return evaluated_; }
+
+    bool writeReport(const std::string& file_name) const;
+    bool writeBestParameters(const std::string& file_name) const;
+    void printBest() const;
+
+    // 统计检测结果与标注的匹配情况
+    static void matchDetections(const std::vector<cv::Vec3f>& labels, const std::vector<cv::Point2f>& detections,
+                                double tolerance_px, int& true_positives, int& false_positives, int& false_negatives);
+};
+
+#endif // PARAMETERSWEEP_H
@@ -0,0 +1,116 @@
+#include "PidController.h"
+#include <algorithm>
+#include <cmath>
+
+PidController::PidController()
+    : integral_(0.0f),
+      derivative_(0.0f),
+      prev_error_(0.0f),
+      has_prev_(false),
+      output_(0.0f),
+      gimbal_rate_(0.0f),
+      target_rate_(0.0f) {
+}
+
+bool PidController::readGains(const cv::FileNode& node, PidGains& gains) {
+    if (node.empty() || !node.isMap()) {
+        return false;
+    }
+    PidGains result = gains;
+    auto read = [&node](const char* key, float& value) {
+        cv::FileNode item = node[key];
+        if (!item.empty()) value = static_cast<float>(item);
+    };
+    read("kp", result.kp);
+    read("ki", result.ki);
+    read("kd", result.kd);
+    read("kff", result.kff);
+    read("max_rate", result.max_rate);
+    read("max_accel", result.max_accel);
+    read("integral_limit", result.integral_limit);
+    read("integral_zone", result.integral_zone);
+    read("derivative_tau", result.derivative_tau);
+    read("response_lag", result.response_lag);
+    read("feedforward_tau", result.feedforward_tau);
+
+    if (result.kp < 0 || result.ki < 0 || result.kd < 0 || result.max_rate <= 0 ||
+        result.integral_limit < 0 || result.derivative_tau < 0 ||
+        result.response_lag < 0 || result.feedforward_tau < 0) {
+        return false;
+    }
+    gains = result;
+    return true;
+}
+
+void PidController::setGains(const PidGains& gains) {
+    gains_ = gains;
+    integral_ = std::max(-gains_.integral_limit, std::min(integral_, gains_.integral_limit));
+}
+
+void PidController::reset() {
+    integral_ = 0.0f;
+    derivative_ = 0.0f;
+    prev_error_ = 0.0f;
+    has_prev_ = false;
+    output_ = 0.0f;
+    gimbal_rate_ = 0.0f;
+    target_rate_ = 0.0f;
+}
+
+float PidController::update(float error, float relative_rate, float dt) {
+    return step(error, relative_rate, dt, nullptr);
+}
+
+float PidController::update(float error, float relative_rate, float dt, float measured_gimbal_rate) {
+    return step(error, relative_rate, dt, &measured_gimbal_rate);
+}
+
+float PidController::step(float error, float relative_rate, float dt, const float* measured_gimbal_rate) {
+    if (dt <= 0.0f) {
+        prev_error_ = error;
+        has_prev_ = true;
+        return output_;
+    }
+
+    // 误差导数经一阶低通，抑制检测抖动被放大
+    if (has_prev_) {
+        float raw = (error - prev_error_) / dt;
+        float alpha = dt / (gains_.derivative_tau + dt);
+        derivative_ += alpha * (raw - derivative_);
+    }
+    prev_error_ = error;
+    has_prev_ = true;
+
+    float proportional = gains_.kp * error;
+    float derivative = gains_.kd * derivative_;
+    // 跟踪器在图像坐标系中测速，包含云台自身转动；补回云台转速得到目标角速度。
+    // 云台转速估计与视觉测量之间有时间差，不经低通会形成正反馈，因此目标角速度只取慢变分量
+    if (measured_gimbal_rate) {
+        gimbal_rate_ = *measured_gimbal_rate;
+    } else {
+        gimbal_rate_ += (output_ - gimbal_rate_) * std::min(1.0f, dt / std::max(gains_.response_lag, 1e-3f));
+    }
+    target_rate_ += (relative_rate + gimbal_rate_ - target_rate_) * std::min(1.0f, dt / std::max(gains_.feedforward_tau, 1e-3f));
+    target_rate_ = std::max(-gains_.max_rate, std::min(target_rate_, gains_.max_rate));
+    float feedforward = gains_.kff * target_rate_;
+
+    // 抗饱和：大误差（阶跃、重新捕获）时不积分；未积分前已饱和且误差会使输出继续向饱和方向增长时，冻结积分
+    float unsaturated = proportional + integral_ + derivative + feedforward;
+    bool saturating = std::fabs(unsaturated) >= gains_.max_rate && (unsaturated > 0) == (error > 0);
+    bool outside_zone = gains_.integral_zone > 0.0f && std::fabs(error) >= gains_.integral_zone;
+    if (!saturating && !outside_zone) {
+        integral_ += gains_.ki * error * dt;
+        integral_ = std::max(-gains_.integral_limit, std::min(integral_, gains_.integral_limit));
+    }
+
+    float target = proportional + integral_ + derivative + feedforward;
+    target = std::max(-gains_.max_rate, std::min(target, gains_.max_rate));
+
+    // 输出变化率限制：避免阶跃误差时电机瞬间满速
+    if (gains_.max_accel > 0.0f) {
+        float step = gains_.max_accel * dt;
+        target = std::max(output_ - step, std::min(target, output_ + step));
+    }
+    output_ = target;
+    return output_;
+}
@@ -0,0 +1,59 @@
+#ifndef PIDCONTROLLER_H
+#define PIDCONTROLLER_H
+
+#include <opencv2/opencv.hpp>
+
+// 水平轴速度控制器参数：输入角度误差（弧度），输出电机角速度指令（弧度/秒）
+struct PidGains {
+    float kp = 6.0f;               // 1/s：每弧度误差对应的角速度
+    float ki = 5.0f;               // 1/s^2
+    float kd = 0.0f;               // s
+    float kff = 1.0f;              // 目标角速度前馈系数
+    float max_rate = 0.35f;        // 输出限幅，对应满量程速度指令
+    float max_accel = 6.0f;        // 输出变化率限制（弧度/秒^2），<= 0 表示不限制
+    float integral_limit = 0.05f;  // 积分项输出上限（弧度/秒）
+    float integral_zone = 0.003f;  // 积分分离：|误差| 小于该值（弧度）才积分，<= 0 表示始终积分
+    float derivative_tau = 0.02f;  // 微分项一阶低通时间常数（秒）
+    float response_lag = 0.05f;    // 指令到云台实际转速的等效滞后（指令延迟 + 电机时间常数，秒）
+    float feedforward_tau = 0.2f;  // 目标角速度估计的低通时间常数（秒），目标自身速度变化远慢于控制回路
+};
+
+// PID + 速度前馈，带积分抗饱和（积分分离；输出饱和且误差同向时停止积分）和输出变化率限制。
+// 积分状态以输出单位保存，运行中修改 ki 不会使输出跳变。
+class PidController {
+private:
+    PidGains gains_;
+    float integral_;      // 积分项输出（弧度/秒）
+    float derivative_;    // 滤波后的误差导数（弧度/秒）
+    float prev_error_;
+    bool has_prev_;
+    float output_;
+    float gimbal_rate_;   // 按 response_lag 滞后的输出，估计云台当前转速
+    float target_rate_;   // 低通后的目标自身角速度
+
+    float step(float error, float relative_rate, float dt, const float* measured_gimbal_rate);
+
+public:
+    PidController();
+
+    // 从配置节点读取参数（缺省的键保持原值），参数无效时返回 false 且不修改 gains
+    static bool readGains(const cv::FileNode& node, PidGains& gains);
+
+    void setGains(const PidGains& gains);
+    const PidGains& getGains() const { return gains_; }
+
+    // 清除积分、微分和输出状态
+    void reset();
+
+    // error: 当前误差（弧度，> 0 表示需要向右转）；relative_rate: 跟踪器给出的目标相对相机的角速度（弧度/秒），
+    // 加上估计的云台转速即为目标自身角速度，作为前馈；
+    // dt: 距上次更新的时间（秒），<= 0 时只返回上次输出
+    float update(float error, float relative_rate, float dt);
+    // 有下位机遥测时：measured_gimbal_rate 为实测云台角速度，代替按 response_lag 推算的值
+    float update(float error, float relative_rate, float dt, float measured_gimbal_rate);
+
+    float getOutput() const { return output_; }
+    float getIntegral() const { return integral_; }
+};
+
+#endif // PIDCONTROLLER_H
@@ -0,0 +1,179 @@
+#include "PlantSimulator.h"
+#include "SerialPort.h"
+#include <algorithm>
+#include <cmath>
+
+PlantSimulator::PlantSimulator(const PlantConfig& config)
+    : config_(config),
+      rng_(7),
+      handler_(*this),
+      parser_(handler_) {
+    reset();
+}
+
+void PlantSimulator::reset() {
+    parser_.reset();
+    feed_time_ = 0.0;
+    framed_ = false;
+    next_telemetry_ = 0.0;
+    output_.clear();
+    acks_ = 0;
+    watchdog_timeout_ = 0.0;
+    last_command_time_ = 0.0;
+    watchdog_tripped_ = false;
+    watchdog_trips_ = 0;
+    pending_.clear();
+    time_ = 0.0;
+    commanded_rate_ = 0.0;
+    rate_ = 0.0;
+    acceleration_ = 0.0;
+    motor_angle_ = 0.0;
+    camera_angle_ = 0.0;
+    frames_ = 0;
+}
+
+void PlantSimulator::feed(const uint8_t* data, size_t size, double time) {
+    feed_time_ = time;
+    parser_.feed(data, size);
+}
+
+void PlantSimulator::CommandHandler::onLevel(int seq, int8_t level) {
+    // 档位：-5..5 线性对应满速
+    int clamped = std::max(-5, std::min(5, static_cast<int>(level)));
+    plant_.setCommand(clamped / 5.0 * plant_.config_.max_rate);
+    if (seq >= 0) plant_.acknowledge(static_cast<uint8_t>(seq), ACK_OK);
+}
+
+void PlantSimulator::CommandHandler::onSpeed(int seq, int16_t speed) {
+    double normalized = std::max(-1.0, std::min(1.0, static_cast<double>(speed) / SPEED_FRAME_FULL_SCALE));
+    plant_.setCommand(normalized * plant_.config_.max_rate);
+    if (seq >= 0) plant_.acknowledge(static_cast<uint8_t>(seq), ACK_OK);
+}
+
+void PlantSimulator::CommandHandler::onStop(int seq) {
+    plant_.setCommand(0.0);
+    if (seq >= 0) plant_.acknowledge(static_cast<uint8_t>(seq), ACK_OK);
+}
+
+void PlantSimulator::CommandHandler::onWatchdog(uint8_t seq, uint16_t timeout_ms) {
+    plant_.watchdog_timeout_ = timeout_ms * 1e-3;
+    plant_.last_command_time_ = plant_.feed_time_;
+    plant_.acknowledge(seq, ACK_OK);
+}
+
+void PlantSimulator::CommandHandler::onUnknown(uint8_t, uint8_t seq, const uint8_t*, size_t) {
+    plant_.acknowledge(seq, ACK_UNSUPPORTED);
+}
+
+void PlantSimulator::setCommand(double rate) {
+    pending_.emplace_back(feed_time_ + config_.command_delay, rate);
+    frames_++;
+    last_command_time_ = feed_time_;
+    watchdog_tripped_ = false;
+}
+
+void PlantSimulator::checkWatchdog() {
+    if (watchdog_timeout_ <= 0.0 || watchdog_tripped_ || time_ < last_command_time_ + watchdog_timeout_) {
+        return;
+    }
+    // 电机已停止（或即将停止）时超时不算触发
+    bool moving = commanded_rate_ != 0.0;
+    for (const auto& command : pending_) {
+        moving = command.second != 0.0;
+    }
+    if (!moving) {
+        return;
+    }
+    pending_.clear();
+    commanded_rate_ = 0.0;
+    watchdog_tripped_ = true;
+    watchdog_trips_++;
+}
+
+void PlantSimulator::acknowledge(uint8_t seq, uint8_t status) {
+    framed_ = true;
+    uint8_t ack[2] = {seq, status};
+    uint8_t reply[FRAME_MAX_SIZE];
+    size_t size = encodeFrame(MessageType::ACK, seq, ack, sizeof(ack), reply);
+    output_.insert(output_.end(), reply, reply + size);
+    acks_++;
+}
+
+void PlantSimulator::emitTelemetry() {
+    MotorTelemetry telemetry;
+    telemetry.mcu_time_ms = static_cast<uint32_t>(std::lround(time_ * 1000.0));
+    telemetry.position = motor_angle_;
+    telemetry.velocity = rate_;
+    telemetry.flags = static_cast<uint8_t>(TELEMETRY_ENABLED | (watchdog_tripped_ ? TELEMETRY_WATCHDOG : 0));
+    uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+    size_t payload_size = encodeTelemetry(telemetry, payload);
+    uint8_t reply[FRAME_MAX_SIZE];
+    // 遥测不需要确认，序号取下位机时间的低 8 位
+    size_t size = encodeFrame(MessageType::TELEMETRY, static_cast<uint8_t>(telemetry.mcu_time_ms), payload, payload_size, reply);
+    output_.insert(output_.end(), reply, reply + size);
+}
+
+std::vector<uint8_t> PlantSimulator::takeOutput() {
+    std::vector<uint8_t> output;
+    output.swap(output_);
+    return output;
+}
+
+void PlantSimulator::advanceTo(double time, double max_step) {
+    while (true) {
+        while (!pending_.empty() && pending_.front().first <= time_) {
+            commanded_rate_ = pending_.front().second;
+            pending_.pop_front();
+        }
+        checkWatchdog();
+        bool telemetry = framed_ && config_.telemetry_period > 0.0;
+        if (telemetry && time_ >= next_telemetry_) {
+            emitTelemetry();
+            next_telemetry_ = time_ + config_.telemetry_period;
+        }
+        if (time_ >= time) {
+            break;
+        }
+        // 步长截到下一条指令的生效时刻（和下一次遥测时刻），结果与步长无关
+        double dt = std::min(max_step, time - time_);
+        if (!pending_.empty()) {
+            dt = std::min(dt, pending_.front().first - time_);
+        }
+        if (telemetry) {
+            dt = std::min(dt, next_telemetry_ - time_);
+        }
+        if (watchdog_timeout_ > 0.0 && !watchdog_tripped_ && last_command_time_ + watchdog_timeout_ > time_) {
+            dt = std::min(dt, last_command_time_ + watchdog_timeout_ - time_);
+        }
+        step(dt);
+        time_ += dt;
+    }
+}
+
+void PlantSimulator::step(double dt) {
+    if (config_.order >= 2) {
+        double omega = 2.0 * CV_PI * config_.natural_freq_hz;
+        acceleration_ += (omega * omega * (commanded_rate_ - rate_) - 2.0 * config_.damping * omega * acceleration_) * dt;
+        rate_ += acceleration_ * dt;
+    } else {
+        rate_ += (commanded_rate_ - rate_) * std::min(1.0, dt / config_.tau);
+    }
+    motor_angle_ += rate_ * dt;
+
+    // 齿隙：电机轴在空程内转动时相机不动
+    double half_gap = 0.5 * config_.backlash;
+    if (motor_angle_ - camera_angle_ > half_gap) {
+        camera_angle_ = motor_angle_ - half_gap;
+    } else if (motor_angle_ - camera_angle_ < -half_gap) {
+        camera_angle_ = motor_angle_ + half_gap;
+    }
+}
+
+cv::Point2f PlantSimulator::observe(double target_angle, double target_elevation) {
+    double cx = (config_.image_size.width - 1) * 0.5;
+    double cy = (config_.image_size.height - 1) * 0.5;
+    double x = cx + config_.focal_px * std::tan(target_angle - camera_angle_);
+    double y = cy - config_.focal_px * std::tan(target_elevation);
+    return cv::Point2f(static_cast<float>(x + rng_.gaussian(config_.noise_px)),
+                       static_cast<float>(y + rng_.gaussian(config_.noise_px)));
+}
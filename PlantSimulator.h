@@ -0,0 +1,113 @@
+#ifndef PLANTSIMULATOR_H
+#define PLANTSIMULATOR_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "SerialProtocol.h"
+#include "FrameParser.h"
+
+// 水平转台 + 电机 + 相机的仿真参数（时间单位秒，角度单位弧度）
+struct PlantConfig {
+    int order = 1;                    // 1: 转速一阶响应；2: 二阶（固有频率 + 阻尼）
+    double tau = 0.03;                // 一阶时间常数
+    double natural_freq_hz = 8.0;     // 二阶固有频率
+    double damping = 0.7;             // 二阶阻尼比
+    double command_delay = 0.02;      // 下位机收到指令到电机开始响应
+    double max_rate = 0.35;           // 满速（档位 5 / 速度帧满量程）对应的转速
+    double backlash = 0.0005;         // 齿隙：电机轴与相机之间的空程
+    double focal_px = 4968.4;         // 相机等效焦距（像素）
+    cv::Size image_size = cv::Size(2448, 2048);
+    double noise_px = 0.3;            // 检测位置噪声（1σ，像素）
+    double telemetry_period = 0.005;  // 协议 v2 遥测周期，<= 0 不上报
+};
+
+// 下位机侧仿真：解析 SerialPort 实际写出的字节（v1 档位帧 AA 55 / 速度帧 AA 56，v2 帧 AA 5A），
+// 按延迟和动力学积分转台角度，并给出目标在相机图像中的位置，用于无硬件的闭环测试。
+// 收到 v2 帧后按固件行为回复 ACK，并周期性上报电机轴（编码器侧，不含齿隙）的角度与转速；
+// 主机设置看门狗后，电机转动时超时没有收到指令即停止。
+// 时间由调用方推进，可远快于实时运行。
+class PlantSimulator {
+private:
+    PlantConfig config_;
+    cv::RNG rng_;
+
+    // 字节流解析：与主机接收共用 FrameParser，下位机一侧只处理指令
+    class CommandHandler : public FrameParser::Handler {
+    public:
+        explicit CommandHandler(PlantSimulator& plant) : plant_(plant) {}
+        void onLevel(int seq, int8_t level) override;
+        void onSpeed(int seq, int16_t speed) override;
+        void onStop(int seq) override;
+        void onWatchdog(uint8_t seq, uint16_t timeout_ms) override;
+        void onUnknown(uint8_t type, uint8_t seq, const uint8_t* payload, size_t size) override;
+    private:
+        PlantSimulator& plant_;
+    };
+    CommandHandler handler_;
+    FrameParser parser_;
+    double feed_time_;              // 正在解析的字节的到达时刻
+
+    bool framed_;                   // 已收到 v2 帧，开始回复
+    double next_telemetry_;
+    std::vector<uint8_t> output_;   // 待主机读取的回复字节
+    long acks_;
+
+    // 看门狗（固件行为）：timeout 为 0 时关闭
+    double watchdog_timeout_;
+    double last_command_time_;      // 最近一次收到指令（含看门狗设置）的时刻
+    bool watchdog_tripped_;
+    long watchdog_trips_;
+
+    std::deque<std::pair<double, double>> pending_;   // (生效时刻, 目标转速)
+    double time_;
+    double commanded_rate_;   // 已生效的转速指令
+    double rate_;             // 电机转速
+    double acceleration_;     // 二阶模型的转速变化率
+    double motor_angle_;      // 电机轴角度
+    double camera_angle_;     // 经齿隙后的相机角度
+
+    long frames_;             // 生效的指令帧数
+
+    void setCommand(double rate);
+    void checkWatchdog();
+    // v2 指令：按固件行为回复 ACK
+    void acknowledge(uint8_t seq, uint8_t status);
+    void emitTelemetry();
+    void step(double dt);
+
+public:
+    explicit PlantSimulator(const PlantConfig& config = PlantConfig());
+
+    // 仿真时钟从 0 开始，状态全部清零
+    void reset();
+    const PlantConfig& getConfig() const { return config_; }
+
+    // 在仿真时刻 time 收到的串口字节（time 不早于当前仿真时刻）
+    void feed(const uint8_t* data, size_t size, double time);
+
+    // 积分到仿真时刻 time
+    void advanceTo(double time, double max_step = 1e-4);
+
+    // 目标水平角为 target_angle（弧度，右为正）时，当前时刻目标在图像中的像素位置（含噪声）
+    cv::Point2f observe(double target_angle, double target_elevation = 0.0);
+
+    double getTime() const { return time_; }
+    double getCameraAngle() const { return camera_angle_; }
+    double getMotorAngle() const { return motor_angle_; }
+    double getRate() const { return rate_; }
+    double getCommandedRate() const { return commanded_rate_; }
+    long getFrameCount() const { return frames_; }
+    // 无法组成合法帧的字节
+    long getRejectedBytes() const { return static_cast<long>(parser_.getStats().dropped_bytes); }
+    long getAckCount() const { return acks_; }
+    long getWatchdogTrips() const { return watchdog_trips_; }
+
+    // 取走自上次调用以来下位机发给主机的字节（ACK、遥测）
+    std::vector<uint8_t> takeOutput();
+};
+
+#endif // PLANTSIMULATOR_H
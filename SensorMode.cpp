@@ -0,0 +1,42 @@
+#include "SensorMode.h"
+#include <cmath>
+
+float SensorMode::scale(const cv::Size& frame_size, const cv::Size& calibration_size) const {
+    if (binning > 0) {
+        return static_cast<float>(binning);
+    }
+    if (frame_size.width <= 0 || calibration_size.width <= 0) {
+        return 1.0f;
+    }
+    return static_cast<float>(calibration_size.width) / frame_size.width;
+}
+
+cv::Point2f SensorMode::toCalibration(const cv::Point2f& pixel, float scale) const {
+    return cv::Point2f(roi_offset.x + (pixel.x + 0.5f) * scale - 0.5f,
+                       roi_offset.y + (pixel.y + 0.5f) * scale - 0.5f);
+}
+
+cv::Mat SensorMode::frameCameraMatrix(const cv::Mat& camera_matrix, float scale) const {
+    cv::Mat k;
+    camera_matrix.convertTo(k, CV_64F);
+    k = k.clone();
+    // 标定像素 u = roi + (p + 0.5) s - 0.5，代入 u = fx x + cx 解出 p = (fx / s) x + (cx - roi + 0.5) / s - 0.5
+    k.at<double>(0, 0) /= scale;
+    k.at<double>(0, 1) /= scale;
+    k.at<double>(1, 1) /= scale;
+    k.at<double>(0, 2) = (k.at<double>(0, 2) - roi_offset.x + 0.5) / scale - 0.5;
+    k.at<double>(1, 2) = (k.at<double>(1, 2) - roi_offset.y + 0.5) / scale - 0.5;
+    return k;
+}
+
+cv::Size readCalibrationSize(const cv::FileStorage& fs, const cv::Mat& camera_matrix) {
+    int width = fs["imageWidth"].empty() ? 0 : static_cast<int>(fs["imageWidth"]);
+    int height = fs["imageHeight"].empty() ? 0 : static_cast<int>(fs["imageHeight"]);
+    if (width <= 0 || height <= 0) {
+        cv::Mat k;
+        camera_matrix.convertTo(k, CV_64F);
+        width = static_cast<int>(std::lround(k.at<double>(0, 2) * 2.0));
+        height = static_cast<int>(std::lround(k.at<double>(1, 2) * 2.0));
+    }
+    return cv::Size(width, height);
+}
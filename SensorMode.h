@@ -0,0 +1,24 @@
+#ifndef SENSORMODE_H
+#define SENSORMODE_H
+
+#include <opencv2/opencv.hpp>
+
+// 相机工作模式：内参在全分辨率传感器上标定，相机使用 ROI 或像素合并时，
+// 帧像素 p 对应的标定像素为 roi_offset + (p + 0.5) * scale - 0.5。
+// 测距、去畸变查找表和对准控制共用这一换算。
+struct SensorMode {
+    cv::Point2f roi_offset = cv::Point2f(0.0f, 0.0f);  // ROI 在传感器上的偏移（像素，标定分辨率）
+    int binning = 0;                                   // 像素合并倍数，0 表示按帧宽与标定宽度之比推断
+
+    // 帧像素 -> 标定像素的缩放倍数
+    float scale(const cv::Size& frame_size, const cv::Size& calibration_size) const;
+    cv::Point2f toCalibration(const cv::Point2f& pixel, float scale) const;
+    // 帧像素下的等效相机矩阵：对帧像素直接使用（undistortPoints / 查找表），
+    // 与先换算到标定像素再用原内参的结果一致；畸变系数作用于归一化坐标，不需要换算
+    cv::Mat frameCameraMatrix(const cv::Mat& camera_matrix, float scale) const;
+};
+
+// 标定文件中的标定图像尺寸；旧文件没有记录时按主点估计
+cv::Size readCalibrationSize(const cv::FileStorage& fs, const cv::Mat& camera_matrix);
+
+#endif // SENSORMODE_H
@@ -0,0 +1,84 @@
+// termios2 与 glibc 的 <termios.h> 定义冲突：本文件只包含内核头文件
+#include "SerialLowLatency.h"
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+bool setCustomBaudRate(int fd, int baud, int& actual_baud, std::string& error) {
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        error = std::string("TCGETS2 失败: ") + strerror(errno);
+        return false;
+    }
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_cflag &= ~(CBAUD << IBSHIFT);
+    tio.c_cflag |= BOTHER << IBSHIFT;
+    tio.c_ospeed = static_cast<speed_t>(baud);
+    tio.c_ispeed = static_cast<speed_t>(baud);
+    if (ioctl(fd, TCSETS2, &tio) != 0) {
+        error = std::string("TCSETS2 失败: ") + strerror(errno);
+        return false;
+    }
+    // 驱动按时钟分频取最接近的值，回读实际波特率
+    actual_baud = readBaudRate(fd);
+    return true;
+}
+
+int readBaudRate(int fd) {
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return 0;
+    }
+    return static_cast<int>(tio.c_ospeed);
+}
+
+bool setAsyncLowLatency(int fd, bool enabled, std::string& error) {
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) != 0) {
+        error = std::string("TIOCGSERIAL 不支持: ") + strerror(errno);
+        return false;
+    }
+    if (enabled) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+    } else {
+        serial.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    if (ioctl(fd, TIOCSSERIAL, &serial) != 0) {
+        error = std::string("TIOCSSERIAL 失败: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool setUsbLatencyTimer(const std::string& port_name, int ms, int& previous_ms, std::string& error) {
+    previous_ms = -1;
+    // /dev/serial/by-id/... 等符号链接解析到真实的 ttyUSBn
+    char resolved[PATH_MAX];
+    std::string device = realpath(port_name.c_str(), resolved) ? resolved : port_name;
+    std::string name = device.substr(device.find_last_of('/') + 1);
+    std::string path = "/sys/class/tty/" + name + "/device/latency_timer";
+
+    std::ifstream in(path);
+    if (!in || !(in >> previous_ms)) {
+        error = "设备没有 latency_timer（非 FTDI 芯片）";
+        previous_ms = -1;
+        return false;
+    }
+    in.close();
+    if (previous_ms == ms) {
+        return true;
+    }
+    std::ofstream out(path);
+    if (!out || !(out << ms << std::endl)) {
+        error = "无法写入 " + path + "（需要 root 或 udev 规则）";
+        return false;
+    }
+    return true;
+}
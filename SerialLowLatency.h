@@ -0,0 +1,36 @@
+#ifndef SERIALLOWLATENCY_H
+#define SERIALLOWLATENCY_H
+
+#include <string>
+
+// 低延迟串口配置。FTDI/CH340 等 USB 转串口默认攒满缓冲或等 latency_timer（FTDI 默认 16ms）才上送，
+// 小帧往返会多出十几毫秒。
+struct SerialLatencyProfile {
+    bool low_latency = false;        // 启用 ASYNC_LOW_LATENCY 与下面的 USB latency_timer
+    int usb_latency_timer_ms = 1;    // FTDI 的 sysfs latency_timer（1..255ms）
+    int rt_priority = 0;             // > 0 时串口收发线程使用 SCHED_FIFO
+};
+
+// 实际生效的配置（不支持的项只记录原因，不影响连接）
+struct SerialTuningReport {
+    int requested_baud = 0;
+    int actual_baud = 0;             // 驱动回读的波特率
+    bool custom_baud = false;        // 通过 termios2/BOTHER 设置的非标准波特率
+    bool async_low_latency = false;
+    int latency_timer_ms = -1;       // -1 表示设备没有 latency_timer
+    std::string warnings;
+};
+
+// 以下函数所在的编译单元使用 <asm/termbits.h> 的 termios2，与 glibc <termios.h> 不能同时包含，
+// 因此接口中不出现 termios 类型。
+
+// 在已用 termios 配置好数据位等参数的 fd 上，用 TCSETS2 + BOTHER 设置任意波特率（如 1–3 Mbaud）
+bool setCustomBaudRate(int fd, int baud, int& actual_baud, std::string& error);
+// 读回当前输出波特率（termios2），失败返回 0
+int readBaudRate(int fd);
+// TIOCSSERIAL 设置 / 清除 ASYNC_LOW_LATENCY
+bool setAsyncLowLatency(int fd, bool enabled, std::string& error);
+// 写 /sys/class/tty/<设备>/device/latency_timer（需要写权限），previous_ms 返回原值
+bool setUsbLatencyTimer(const std::string& port_name, int ms, int& previous_ms, std::string& error);
+
+#endif // SERIALLOWLATENCY_H
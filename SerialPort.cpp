@@ -1,26 +1,72 @@
 //串口通信模块
 #include "SerialPort.h"
 #include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <termios.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
+namespace {
+// 下位机处理一条指令并回复 ACK 的时限；超过即记为丢失，停止指令重发
+constexpr auto ACK_TIMEOUT = std::chrono::milliseconds(50);
+constexpr int STOP_RETRY_LIMIT = 5;
+// 设备断开后的重试周期：inotify 通常在设备节点出现时立即唤醒，该周期兜底（udev 尚未改好权限、
+// 目录不支持 inotify 的 devpts 等），决定设备重新可用到恢复发送的最长时间
+constexpr int RECONNECT_RETRY_MS = 100;
+
+double steadyMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 低延迟配置下收发线程使用 SCHED_FIFO，避免被视觉线程抢占而推迟 ACK 处理与发送；无权限时保持普通调度
+void applyThreadPriority(int priority, const char* name) {
+    if (priority <= 0) {
+        return;
+    }
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = std::max(sched_get_priority_min(SCHED_FIFO),
+                                    std::min(priority, sched_get_priority_max(SCHED_FIFO)));
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+        std::cerr << "串口" << name << "线程无法设置 SCHED_FIFO (" << std::strerror(err) << ")，以普通优先级运行" << std::endl;
+    }
+}
+}
+
 template<typename T>
 T clamp_value(T value, T min_val, T max_val) {
     return (value < min_val) ? min_val : ((value > max_val) ? max_val : value);
 }
 
-SerialPort::SerialPort() : serial_fd_(-1), is_connected_(false) {}
+SerialPort::SerialPort()
+    : serial_fd_(-1), is_connected_(false), baud_rate_(115200), protocol_version_(1), tx_seq_(0),
+      auto_reconnect_(true), link_up_(false), monitor_running_(false), link_lost_(false),
+      monitor_wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), mcu_watchdog_ms_(0), log_frames_(false),
+      writer_running_(false), has_stop_(false), has_latest_(false), has_config_(false), frame_log_counter_(0),
+      awaiting_ack_(), stop_unacked_(false), stop_retries_(0),
+      reader_running_(false), receive_handler_(*this), parser_(receive_handler_), has_telemetry_(false) {}
 
 SerialPort::~SerialPort() {
     disconnect();
+    if (monitor_wake_fd_ >= 0) {
+        close(monitor_wake_fd_);
+    }
 }
 
 bool SerialPort::connect(const std::string& port_name, int baud_rate) {
+    stopMonitor();
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (is_connected_) disconnect();
+    if (is_connected_) disconnectLocked();
     port_name_ = port_name;
     
     serial_fd_ = open(port_name_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
@@ -29,16 +75,54 @@ bool SerialPort::connect(const std::string& port_name, int baud_rate) {
         return false;
     }
     
+    std::string error;
+    tuning_report_ = SerialTuningReport();
+    if (!configureTty(serial_fd_, port_name_, baud_rate, latency_profile_, tuning_report_, error)) {
+        std::cerr << error << std::endl;
+        close(serial_fd_);
+        serial_fd_ = -1;
+        return false;
+    }
+    if (!tuning_report_.warnings.empty()) {
+        std::cerr << "警告: 低延迟设置未完全生效: " << tuning_report_.warnings << std::endl;
+    }
+    
+    baud_rate_ = baud_rate;
+    is_connected_ = true;
+    link_up_ = true;
+    link_stats_ = SerialLinkStats();
+    startWriter();
+    startReader();
+    writeWatchdog();
+    if (auto_reconnect_) {
+        startMonitor();
+    }
+    std::cout << "串口连接成功: " << port_name_ << " @ " << baud_rate << " bps";
+    if (tuning_report_.actual_baud > 0 && tuning_report_.actual_baud != baud_rate) {
+        std::cout << " (实际 " << tuning_report_.actual_baud << " bps)";
+    }
+    if (latency_profile_.low_latency) {
+        std::cout << ", 低延迟: ASYNC_LOW_LATENCY " << (tuning_report_.async_low_latency ? "开" : "不支持");
+        if (tuning_report_.latency_timer_ms >= 0) {
+            std::cout << ", latency_timer " << tuning_report_.latency_timer_ms << "ms";
+        }
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+bool SerialPort::configureTty(int fd, const std::string& port_name, int baud_rate, const SerialLatencyProfile& profile,
+                              SerialTuningReport& report, std::string& error) {
     struct termios tty;
     memset(&tty, 0, sizeof(tty));
     
-    if (tcgetattr(serial_fd_, &tty) != 0) {
-        std::cerr << "获取串口配置失败: " << strerror(errno) << std::endl;
-        close(serial_fd_);
-        serial_fd_ = -1;
+    if (tcgetattr(fd, &tty) != 0) {
+        error = std::string("获取串口配置失败: ") + strerror(errno);
         return false;
     }
     
+    report.requested_baud = baud_rate;
+    report.custom_baud = false;
     speed_t speed;
     switch (baud_rate) {
         case 9600: speed = B9600; break;
@@ -50,10 +134,14 @@ bool SerialPort::connect(const std::string& port_name, int baud_rate) {
         case 460800: speed = B460800; break;
         case 921600: speed = B921600; break;
         default:
-            std::cerr << "不支持的波特率: " << baud_rate << std::endl;
-            close(serial_fd_);
-            serial_fd_ = -1;
-            return false;
+            if (baud_rate <= 0) {
+                error = "不支持的波特率: " + std::to_string(baud_rate);
+                return false;
+            }
+            // 先按占位值完成其余配置，再用 termios2 写入任意波特率
+            speed = B38400;
+            report.custom_baud = true;
+            break;
     }
     cfsetospeed(&tty, speed);
     cfsetispeed(&tty, speed);
@@ -69,71 +157,739 @@ bool SerialPort::connect(const std::string& port_name, int baud_rate) {
     tty.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
     tty.c_oflag &= ~OPOST;
     
+    // fd 为非阻塞且收发线程用 poll 等待，VMIN/VTIME 不参与延迟
     tty.c_cc[VMIN] = 0;
     tty.c_cc[VTIME] = 5;
     
-    tcflush(serial_fd_, TCIOFLUSH);
+    tcflush(fd, TCIOFLUSH);
     
-    if (tcsetattr(serial_fd_, TCSANOW, &tty) != 0) {
-        std::cerr << "设置串口配置失败: " << strerror(errno) << std::endl;
-        close(serial_fd_);
-        serial_fd_ = -1;
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        error = std::string("设置串口配置失败: ") + strerror(errno);
         return false;
     }
     
-    is_connected_ = true;
-    std::cout << "串口连接成功: " << port_name_ << " @ " << baud_rate << " bps" << std::endl;
+    if (report.custom_baud) {
+        std::string baud_error;
+        if (!setCustomBaudRate(fd, baud_rate, report.actual_baud, baud_error)) {
+            error = "不支持的波特率: " + std::to_string(baud_rate) + " (" + baud_error + ")";
+            return false;
+        }
+        // 分频误差超过 3% 时 8N1 无法可靠通信
+        if (report.actual_baud > 0 && std::abs(report.actual_baud - baud_rate) * 100 > baud_rate * 3) {
+            error = "不支持的波特率: " + std::to_string(baud_rate) + " (驱动只能提供 " +
+                    std::to_string(report.actual_baud) + ")";
+            return false;
+        }
+    } else {
+        report.actual_baud = readBaudRate(fd);
+    }
+    
+    report.async_low_latency = false;
+    report.latency_timer_ms = -1;
+    if (profile.low_latency) {
+        std::string tuning_error;
+        if (setAsyncLowLatency(fd, true, tuning_error)) {
+            report.async_low_latency = true;
+        } else {
+            report.warnings += (report.warnings.empty() ? "" : "; ") + tuning_error;
+        }
+        int previous_ms = -1;
+        tuning_error.clear();
+        if (setUsbLatencyTimer(port_name, profile.usb_latency_timer_ms, previous_ms, tuning_error)) {
+            report.latency_timer_ms = profile.usb_latency_timer_ms;
+        } else {
+            report.latency_timer_ms = previous_ms;
+            report.warnings += (report.warnings.empty() ? "" : "; ") + tuning_error;
+        }
+    }
     return true;
 }
 
+void SerialPort::setLatencyProfile(const SerialLatencyProfile& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_profile_ = profile;
+}
+
+SerialTuningReport SerialPort::getTuningReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tuning_report_;
+}
+
+bool SerialPort::connectSimulated(const WriteSink& sink) {
+    stopMonitor();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopReader();
+    stopWriter();
+    if (serial_fd_ >= 0) {
+        close(serial_fd_);
+        serial_fd_ = -1;
+    }
+    port_name_ = "simulated";
+    tx_seq_ = 0;
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        std::fill(std::begin(awaiting_ack_), std::end(awaiting_ack_), false);
+        stop_unacked_ = false;
+    }
+    {
+        std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+        parser_.reset();
+        receive_stats_ = SerialReceiveStats();
+        has_telemetry_ = false;
+    }
+    sink_ = sink;
+    is_connected_ = static_cast<bool>(sink_);
+    link_up_ = is_connected_;
+    if (is_connected_) {
+        writeWatchdog();
+    }
+    return is_connected_;
+}
+
 void SerialPort::disconnect() {
+    stopMonitor();
     std::lock_guard<std::mutex> lock(mutex_);
+    disconnectLocked();
+}
+
+void SerialPort::disconnectLocked() {
+    // 先让发送线程写完已排队的帧（尤其是停止指令），再关闭设备
+    stopReader();
+    stopWriter();
     if (serial_fd_ >= 0) {
         close(serial_fd_);
         serial_fd_ = -1;
     }
+    sink_ = nullptr;
     is_connected_ = false;
+    link_up_ = false;
     std::cout << "串口已断开" << std::endl;
 }
 
 bool SerialPort::isConnected() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return is_connected_;
+    return is_connected_ && link_up_;
 }
 
-bool SerialPort::sendDataFrame(int8_t data_value) {
+void SerialPort::setAutoReconnect(bool enabled) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (!is_connected_ || serial_fd_ < 0) {
-        std::cerr << "串口未连接，无法发送数据" << std::endl;
+    auto_reconnect_ = enabled;
+}
+
+unsigned long SerialPort::getReconnectCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return link_stats_.reconnects;
+}
+
+SerialLinkStats SerialPort::getLinkStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SerialLinkStats stats = link_stats_;
+    stats.link_up = is_connected_ && link_up_;
+    return stats;
+}
+
+bool SerialPort::setProtocolVersion(int version) {
+    if (version != 1 && version != 2) {
+        std::cerr << "不支持的串口协议版本: " << version << std::endl;
         return false;
     }
+    std::lock_guard<std::mutex> lock(mutex_);
+    protocol_version_ = version;
+    return true;
+}
+
+int SerialPort::getProtocolVersion() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return protocol_version_;
+}
+
+void SerialPort::setMcuWatchdog(int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mcu_watchdog_ms_ = std::max(0, std::min(timeout_ms, 65535));
+    if (is_connected_ && link_up_) {
+        writeWatchdog();
+    }
+}
+
+void SerialPort::writeWatchdog() {
+    if (protocol_version_ != 2 || mcu_watchdog_ms_ <= 0) {
+        return;
+    }
+    uint8_t payload[2];
+    writeLe16(payload, static_cast<uint16_t>(mcu_watchdog_ms_));
+    writeMessage(MessageType::WATCHDOG, payload, sizeof(payload), "watchdog", false, true);
+}
+
+void SerialPort::setFrameLogging(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_frames_ = enabled;
+}
+
+bool SerialPort::sendDataFrame(int8_t data_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeLevel(data_value);
+}
+
+bool SerialPort::writeLevel(int8_t data_value) {
+    data_value = clamp_value(data_value, static_cast<int8_t>(-5), static_cast<int8_t>(5));
+    if (protocol_version_ == 2) {
+        if (data_value == 0) {
+            return writeMessage(MessageType::STOP, nullptr, 0, "stop", true);
+        }
+        uint8_t payload = static_cast<uint8_t>(data_value);
+        return writeMessage(MessageType::LEVEL, &payload, 1, "level");
+    }
     
     DartDataFrame frame;
     frame.header[0] = 0xAA;
     frame.header[1] = 0x55;
-    frame.data = clamp_value(data_value, static_cast<int8_t>(-5), static_cast<int8_t>(5));
+    frame.data = data_value;
+    frame.footer[0] = 0x0D;
+    frame.footer[1] = 0x0A;
+    
+    // 档位 0 即停止指令，必须送达
+    return writeFrame(&frame, sizeof(frame), "data", frame.data == 0);
+}
+
+bool SerialPort::sendSpeedFrame(int16_t speed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    speed = clamp_value(speed, static_cast<int16_t>(-SPEED_FRAME_FULL_SCALE), SPEED_FRAME_FULL_SCALE);
+    if (protocol_version_ == 2) {
+        uint8_t payload[2];
+        writeLe16(payload, static_cast<uint16_t>(speed));
+        return writeMessage(MessageType::SPEED, payload, sizeof(payload), "speed");
+    }
+    DartSpeedFrame frame;
+    frame.header[0] = 0xAA;
+    frame.header[1] = 0x56;
+    // 显式按小端写入，与主机字节序无关
+    uint16_t raw = static_cast<uint16_t>(speed);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&frame.speed);
+    bytes[0] = static_cast<uint8_t>(raw & 0xFF);
+    bytes[1] = static_cast<uint8_t>(raw >> 8);
     frame.footer[0] = 0x0D;
     frame.footer[1] = 0x0A;
     
-    ssize_t bytes_written = write(serial_fd_, &frame, sizeof(DartDataFrame));
+    return writeFrame(&frame, sizeof(frame), "speed");
+}
+
+bool SerialPort::writeMessage(MessageType type, const uint8_t* payload, size_t size, const char* description, bool is_stop,
+                              bool is_config) {
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t seq = tx_seq_++;
+    size_t frame_size = encodeFrame(type, seq, payload, size, frame);
+    return writeFrame(frame, frame_size, description, is_stop, seq, is_config);
+}
+
+bool SerialPort::writeFrame(const void* frame, size_t size, const char* description, bool is_stop, int seq,
+                            bool is_config) {
+    if (!sink_ && is_connected_ && !link_up_) {
+        // 等待自动重连：只计数，重连后由停止指令和后续新指令接管
+        link_stats_.dropped_commands++;
+        return false;
+    }
+    if (!sink_ && (!is_connected_ || serial_fd_ < 0)) {
+        std::cerr << "串口未连接，无法发送数据" << std::endl;
+        return false;
+    }
     
-    if (bytes_written == sizeof(DartDataFrame)) {
-        static int debug_counter = 0;
-        if (debug_counter++ % 20 == 0) {
-            std::cout << "发送串口数据(5字节): data=" << static_cast<int>(frame.data) 
-                      << " (0x" << std::hex << (frame.data & 0xFF) << std::dec << ")" << std::endl;
+    PendingFrame pending;
+    std::memcpy(pending.bytes, frame, std::min(size, sizeof(pending.bytes)));
+    pending.size = std::min(size, sizeof(pending.bytes));
+    pending.is_stop = is_stop;
+    pending.seq = seq;
+    pending.enqueued = std::chrono::steady_clock::now();
+    if (sink_) {
+        // 仿真模式同步写出
+        {
+            std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+            write_stats_.enqueued++;
         }
-        tcdrain(serial_fd_);
+        sink_(pending.bytes, pending.size);
+        recordWrite(pending, true, std::string());
         return true;
-    } else {
-        std::cerr << "发送串口数据失败: 预期" << sizeof(DartDataFrame) 
-                  << "字节，实际" << bytes_written << "字节" << std::endl;
-        return false;
     }
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        write_stats_.enqueued++;
+        if (is_stop) {
+            // 停止之前尚未发出的速度指令已失效
+            if (has_latest_) write_stats_.coalesced++;
+            has_latest_ = false;
+            stop_frame_ = pending;
+            has_stop_ = true;
+        } else if (is_config) {
+            config_frame_ = pending;
+            has_config_ = true;
+        } else {
+            if (has_latest_) write_stats_.coalesced++;
+            latest_frame_ = pending;
+            has_latest_ = true;
+        }
+        if (log_frames_ && frame_log_counter_++ % 20 == 0) {
+            std::cout << "发送串口数据(" << size << "字节, " << description << "):" << std::hex;
+            for (size_t i = 0; i < pending.size; ++i) {
+                std::cout << " " << static_cast<int>(pending.bytes[i]);
+            }
+            std::cout << std::dec << std::endl;
+        }
+    }
+    queue_cv_.notify_one();
+    return true;
+}
+
+void SerialPort::startWriter() {
+    tx_seq_ = 0;
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        writer_running_ = true;
+        has_stop_ = false;
+        has_latest_ = false;
+        has_config_ = false;
+        stop_unacked_ = false;
+        std::fill(std::begin(awaiting_ack_), std::end(awaiting_ack_), false);
+    }
+    writer_thread_ = std::thread(&SerialPort::writerLoop, this, serial_fd_, latency_profile_.rt_priority);
+}
+
+void SerialPort::stopWriter() {
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        writer_running_ = false;
+    }
+    queue_cv_.notify_one();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+}
+
+void SerialPort::writerLoop(int fd, int priority) {
+    applyThreadPriority(priority, "发送");
+    while (true) {
+        PendingFrame frame;
+        bool retransmit = false;
+        {
+            std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+            auto ready = [this]() { return !writer_running_ || has_stop_ || has_config_ || has_latest_; };
+            if (stop_unacked_) {
+                if (!queue_cv_.wait_until(queue_lock, stop_deadline_, ready)) {
+                    if (!stop_unacked_) {
+                        continue;   // 等待期间已确认
+                    }
+                    if (stop_retries_ >= STOP_RETRY_LIMIT) {
+                        stop_unacked_ = false;
+                        write_stats_.errors++;
+                        write_stats_.last_error = "停止指令未被下位机确认";
+                        std::cerr << "警告: 停止指令重发 " << STOP_RETRY_LIMIT << " 次仍未确认" << std::endl;
+                        continue;
+                    }
+                    // 同一序号重发，下位机按序号去重
+                    stop_retries_++;
+                    write_stats_.retransmits++;
+                    stop_deadline_ = std::chrono::steady_clock::now() + ACK_TIMEOUT;
+                    frame = stop_retry_;
+                    frame.enqueued = std::chrono::steady_clock::now();
+                    retransmit = true;
+                }
+            } else {
+                queue_cv_.wait(queue_lock, ready);
+            }
+            if (!retransmit) {
+                if (has_stop_) {
+                    frame = stop_frame_;
+                    has_stop_ = false;
+                    stop_retries_ = 0;
+                } else if (has_config_) {
+                    frame = config_frame_;
+                    has_config_ = false;
+                } else if (has_latest_) {
+                    frame = latest_frame_;
+                    has_latest_ = false;
+                    stop_unacked_ = false;   // 更新的指令取代未确认的停止
+                } else {
+                    break;   // 已请求退出且没有待发帧
+                }
+            }
+        }
+        std::string error;
+        bool ok = writeAll(fd, frame.bytes, frame.size, error);
+        recordWrite(frame, ok, error);
+    }
+}
+
+bool SerialPort::writeAll(int fd, const uint8_t* data, size_t size, std::string& error) {
+    const int timeout_ms = 100;
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t n = write(fd, data + offset, size - offset);
+        if (n > 0) {
+            offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            error = strerror(errno);
+            return false;
+        }
+        // 发送缓冲区满：等待可写
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready == 0) {
+            error = "发送超时";
+            return false;
+        }
+        if (ready < 0 && errno != EINTR) {
+            error = strerror(errno);
+            return false;
+        }
+        if (ready > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+            error = "设备错误或已断开";
+            return false;
+        }
+    }
+    return true;
+}
+
+void SerialPort::recordWrite(const PendingFrame& frame, bool ok, const std::string& error) {
+    // write() 返回时字节还在 UART 缓冲区中：按波特率补上移出时间（8N1 每字节 10 位），不调用 tcdrain 阻塞
+    double shift_ms = frame.size * 10.0 * 1000.0 / baud_rate_;
+    double latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - frame.enqueued).count() + shift_ms;
+    
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    if (!ok) {
+        // 只记录，不打断调用方；每 100 次打印一次避免刷屏
+        if (write_stats_.errors++ % 100 == 0) {
+            std::cerr << "发送串口数据失败: " << error << " (累计 " << write_stats_.errors << " 次)" << std::endl;
+        }
+        write_stats_.last_error = error;
+        return;
+    }
+    if (frame.seq >= 0) {
+        auto now = std::chrono::steady_clock::now();
+        // 清理超时未确认的序号（序号 8 位回绕，必须在复用前清掉）
+        for (int i = 0; i < 256; ++i) {
+            if (awaiting_ack_[i] && now - sent_at_[i] > ACK_TIMEOUT) {
+                awaiting_ack_[i] = false;
+                write_stats_.ack_lost++;
+            }
+        }
+        awaiting_ack_[frame.seq] = true;
+        sent_at_[frame.seq] = now;
+        if (frame.is_stop) {
+            stop_unacked_ = true;
+            stop_retry_ = frame;
+            stop_deadline_ = now + ACK_TIMEOUT;
+        }
+    }
+    write_stats_.written++;
+    write_stats_.last_latency_ms = latency_ms;
+    write_stats_.mean_latency_ms += (latency_ms - write_stats_.mean_latency_ms) / write_stats_.written;
+    write_stats_.max_latency_ms = std::max(write_stats_.max_latency_ms, latency_ms);
 }
 
 std::string SerialPort::getPortName() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return port_name_;
-}
\ No newline at end of file
+}
+
+double SerialPort::getLastWriteDurationMs() const {
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    return write_stats_.last_latency_ms;
+}
+
+SerialWriteStats SerialPort::getWriteStats() const {
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    return write_stats_;
+}
+
+SerialReceiveStats SerialPort::getReceiveStats() const {
+    std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+    SerialReceiveStats stats = receive_stats_;
+    const FrameParserStats& parsed = parser_.getStats();
+    stats.frames = parsed.frames + parsed.legacy_frames;
+    stats.crc_errors = parsed.crc_errors;
+    stats.invalid_frames = parsed.crc_errors + parsed.framing_errors + parsed.unknown_messages;
+    stats.dropped_bytes = parsed.dropped_bytes;
+    return stats;
+}
+
+bool SerialPort::getTelemetry(MotorTelemetry& telemetry) const {
+    std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+    if (!has_telemetry_) {
+        return false;
+    }
+    telemetry = telemetry_;
+    return true;
+}
+
+void SerialPort::receiveSimulated(const uint8_t* data, size_t size) {
+    handleReceived(data, size);
+}
+
+void SerialPort::startReader() {
+    {
+        std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+        parser_.reset();
+        receive_stats_ = SerialReceiveStats();
+        has_telemetry_ = false;
+    }
+    reader_running_ = true;
+    reader_thread_ = std::thread(&SerialPort::readerLoop, this, serial_fd_, latency_profile_.rt_priority);
+}
+
+void SerialPort::stopReader() {
+    reader_running_ = false;
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+}
+
+void SerialPort::readerLoop(int fd, int priority) {
+    applyThreadPriority(priority, "接收");
+    // poll 超时决定 disconnect 时最长的等待
+    const int timeout_ms = 20;
+    uint8_t buffer[256];
+    while (reader_running_) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            continue;
+        }
+        std::string error;
+        if (ready < 0) {
+            error = strerror(errno);
+        } else if (pfd.revents & POLLIN) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                handleReceived(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            error = (n == 0) ? "设备已关闭" : strerror(errno);
+        } else {
+            error = "设备错误或已断开";
+        }
+        {
+            std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+            receive_stats_.read_errors++;
+            receive_stats_.last_error = error;
+        }
+        std::cerr << "串口接收失败: " << error << "，接收线程退出" << std::endl;
+        reportLinkLost();
+        break;
+    }
+}
+
+void SerialPort::handleReceived(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+    parser_.feed(data, size);
+}
+
+// 以下回调在 handleReceived 持有 rx_mutex_ 时执行
+void SerialPort::ReceiveHandler::onAck(uint8_t, uint8_t acked_seq, uint8_t status) {
+    port_.receive_stats_.acks++;
+    port_.handleAck(acked_seq, status);
+}
+
+void SerialPort::ReceiveHandler::onTelemetry(uint8_t, const MotorTelemetry& telemetry) {
+    port_.telemetry_ = telemetry;
+    port_.telemetry_.received_ms = steadyMs();
+    port_.has_telemetry_ = true;
+    port_.receive_stats_.telemetry++;
+}
+
+void SerialPort::ReceiveHandler::onUnknown(uint8_t type, uint8_t seq, const uint8_t*, size_t size) {
+    port_.receive_stats_.last_error = "未知消息类型 " + std::to_string(static_cast<int>(type)) +
+                                      " (序号 " + std::to_string(seq) + ", 负载 " + std::to_string(size) + " 字节)";
+}
+
+void SerialPort::handleAck(uint8_t seq, uint8_t status) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    if (!awaiting_ack_[seq]) {
+        return;   // 重发引起的重复确认，或已超时
+    }
+    awaiting_ack_[seq] = false;
+    write_stats_.acked++;
+    double rtt_ms = std::chrono::duration<double, std::milli>(now - sent_at_[seq]).count();
+    write_stats_.last_rtt_ms = rtt_ms;
+    write_stats_.mean_rtt_ms += (rtt_ms - write_stats_.mean_rtt_ms) / write_stats_.acked;
+    if (status != ACK_OK) {
+        write_stats_.errors++;
+        write_stats_.last_error = "下位机拒绝指令 (序号 " + std::to_string(seq) + ", 状态 " +
+                                  std::to_string(static_cast<int>(status)) + ")";
+    }
+    if (stop_unacked_ && stop_retry_.seq == seq) {
+        stop_unacked_ = false;
+        queue_cv_.notify_one();
+    }
+}
+
+void SerialPort::startMonitor() {
+    if (monitor_wake_fd_ < 0) {
+        std::cerr << "警告: 无法创建 eventfd，串口断开后不会自动重连" << std::endl;
+        return;
+    }
+    uint64_t drained;
+    while (read(monitor_wake_fd_, &drained, sizeof(drained)) > 0) {}
+    link_lost_ = false;
+    monitor_running_ = true;
+    monitor_thread_ = std::thread(&SerialPort::monitorLoop, this);
+}
+
+void SerialPort::stopMonitor() {
+    monitor_running_ = false;
+    if (monitor_thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t n = write(monitor_wake_fd_, &one, sizeof(one));
+        (void)n;
+        monitor_thread_.join();
+    }
+}
+
+void SerialPort::reportLinkLost() {
+    link_lost_ = true;
+    uint64_t one = 1;
+    ssize_t n = write(monitor_wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void SerialPort::monitorLoop() {
+    std::string port_name;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        port_name = port_name_;
+    }
+    // 监视 /dev 与设备所在目录（如 /dev/serial/by-id）：设备节点删除即断开，创建或 udev 修改权限后立即重试
+    size_t slash = port_name.find_last_of('/');
+    std::string device_dir = (slash == std::string::npos || slash == 0) ? "/" : port_name.substr(0, slash);
+    std::string device_name = port_name.substr(slash == std::string::npos ? 0 : slash + 1);
+    const uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_TO;
+    int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    auto addWatches = [&]() {
+        if (inotify_fd < 0) return;
+        // by-id 目录在最后一个 USB 串口拔出时被删除，需要在它重新出现后再次添加
+        inotify_add_watch(inotify_fd, "/dev", watch_mask);
+        if (device_dir != "/dev") {
+            inotify_add_watch(inotify_fd, device_dir.c_str(), watch_mask);
+        }
+    };
+    addWatches();
+    
+    alignas(struct inotify_event) char events[4096];
+    while (monitor_running_) {
+        bool up;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            up = link_up_;
+        }
+        struct pollfd fds[2];
+        fds[0].fd = monitor_wake_fd_;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = inotify_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int ready = poll(fds, inotify_fd >= 0 ? 2 : 1, up ? -1 : RECONNECT_RETRY_MS);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "串口监视失败: " << strerror(errno) << std::endl;
+            break;
+        }
+        uint64_t drained;
+        while (read(monitor_wake_fd_, &drained, sizeof(drained)) > 0) {}
+        bool deleted = false;
+        ssize_t n;
+        while (inotify_fd >= 0 && (n = read(inotify_fd, events, sizeof(events))) > 0) {
+            for (char* p = events; p < events + n;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                if ((event->mask & IN_DELETE) && event->len > 0 && device_name == event->name) {
+                    deleted = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (!monitor_running_) {
+            break;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool lost = link_lost_.exchange(false);
+        if (lost || (deleted && link_up_)) {
+            std::string reason = "设备节点已删除";
+            if (lost) {
+                std::lock_guard<std::mutex> rx_lock(rx_mutex_);
+                reason = receive_stats_.last_error;
+            }
+            handleLinkLost(reason);
+        }
+        if (!link_up_) {
+            addWatches();
+            tryReconnect();
+        }
+    }
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+}
+
+void SerialPort::handleLinkLost(const std::string& reason) {
+    if (!is_connected_ || !link_up_) {
+        return;
+    }
+    // 尽快关闭旧设备：旧 fd 不释放时，重新枚举的适配器会被编号为下一个 ttyUSBn
+    stopReader();
+    stopWriter();
+    link_lost_ = false;   // 已停止的接收线程此前的报告
+    if (serial_fd_ >= 0) {
+        close(serial_fd_);
+        serial_fd_ = -1;
+    }
+    link_up_ = false;
+    link_down_since_ = std::chrono::steady_clock::now();
+    link_stats_.disconnects++;
+    link_stats_.last_error = reason;
+    std::cerr << "串口设备断开: " << port_name_ << " (" << reason << ")，等待设备重新出现" << std::endl;
+}
+
+bool SerialPort::tryReconnect() {
+    // 设备节点尚未出现或权限尚未就绪：静默等待下一次唤醒
+    int fd = open(port_name_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+    SerialTuningReport report;
+    std::string error;
+    if (!configureTty(fd, port_name_, baud_rate_, latency_profile_, report, error)) {
+        link_stats_.last_error = error;
+        close(fd);
+        return false;
+    }
+    serial_fd_ = fd;
+    tuning_report_ = report;
+    link_up_ = true;
+    // startWriter 清空断开前未发出的指令；下位机可能已随适配器复位，也可能仍在执行断开前的指令，
+    // 重连后第一帧一律为停止，由上层的下一条新指令重新驱动
+    startWriter();
+    startReader();
+    writeLevel(0);
+    writeWatchdog();
+    
+    double outage_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - link_down_since_).count();
+    link_stats_.reconnects++;
+    link_stats_.last_outage_ms = outage_ms;
+    link_stats_.max_outage_ms = std::max(link_stats_.max_outage_ms, outage_ms);
+    std::cout << "串口已重新连接: " << port_name_ << "，中断 " << outage_ms << "ms，已发送停止指令" << std::endl;
+    return true;
+}
@@ -3,32 +3,230 @@
 
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <cstdint>
+#include <chrono>
+#include <functional>
+#include "SerialProtocol.h"
+#include "FrameParser.h"
+#include "SerialLowLatency.h"
 
+// 协议 v1（旧固件）：只写、无校验的固定帧。协议 v2 见 SerialProtocol.h
 #pragma pack(push, 1)
 typedef struct {
     uint8_t header[2];   // 帧头：0xAA, 0x55
     int8_t data;         // 数据：-5到5
     uint8_t footer[2];   // 帧尾：0x0D, 0x0A (CR LF)
 } DartDataFrame;
+
+// 连续速度指令帧：供 PID 控制使用，下位机按比例输出速度
+typedef struct {
+    uint8_t header[2];   // 帧头：0xAA, 0x56
+    int16_t speed;       // 速度：-10000到10000 对应反向/正向满速，小端
+    uint8_t footer[2];   // 帧尾：0x0D, 0x0A (CR LF)
+} DartSpeedFrame;
 #pragma pack(pop)
 
+constexpr int16_t SPEED_FRAME_FULL_SCALE = 10000;
+
+// 异步发送统计
+struct SerialWriteStats {
+    unsigned long enqueued = 0;     // 调用方提交的指令
+    unsigned long written = 0;      // 实际写出的帧
+    unsigned long coalesced = 0;    // 发送前被更新指令覆盖的速度指令
+    unsigned long errors = 0;
+    double last_latency_ms = 0.0;   // 入队到写完并按波特率发送完毕（估算）
+    double mean_latency_ms = 0.0;
+    double max_latency_ms = 0.0;
+    // 以下仅协议 v2
+    unsigned long acked = 0;
+    unsigned long ack_lost = 0;      // 超时未确认
+    unsigned long retransmits = 0;   // 停止指令重发
+    double last_rtt_ms = 0.0;        // 写出到收到 ACK
+    double mean_rtt_ms = 0.0;
+    std::string last_error;
+};
+
+// 接收统计（协议 v2）
+struct SerialReceiveStats {
+    unsigned long frames = 0;
+    unsigned long acks = 0;
+    unsigned long telemetry = 0;
+    unsigned long invalid_frames = 0;   // 校验、帧格式错误或未知类型
+    unsigned long crc_errors = 0;
+    unsigned long dropped_bytes = 0;    // 不属于任何合法帧的字节
+    unsigned long read_errors = 0;
+    std::string last_error;
+};
+
+// 热插拔与自动重连统计
+struct SerialLinkStats {
+    bool link_up = false;
+    unsigned long disconnects = 0;       // 检测到设备断开（拔出、USB 复位）
+    unsigned long reconnects = 0;
+    unsigned long dropped_commands = 0;  // 断开期间丢弃的指令
+    double last_outage_ms = 0.0;         // 断开到重新连接并发出停止指令
+    double max_outage_ms = 0.0;
+    std::string last_error;
+};
+
 class SerialPort {
+public:
+    // 仿真模式下接收写出的字节
+    using WriteSink = std::function<void(const uint8_t* data, size_t size)>;
+    
 private:
     int serial_fd_;
     std::string port_name_;
     bool is_connected_;
     mutable std::mutex mutex_;
+    WriteSink sink_;         // 非空时为仿真模式
+    int baud_rate_;
+    int protocol_version_;
+    uint8_t tx_seq_;         // 协议 v2 的下一个序号，按提交顺序递增（被合并的指令不发送，序号可能不连续）
+    SerialLatencyProfile latency_profile_;
+    SerialTuningReport tuning_report_;
+    
+    // 热插拔：接收线程读到挂断 / EIO，或 /dev 下设备节点被删除时，监视线程关闭设备并等待其重新出现，
+    // 重新打开后先发送停止指令。is_connected_ 表示调用方要求保持连接，link_up_ 表示设备当前可用
+    bool auto_reconnect_;
+    bool link_up_;
+    SerialLinkStats link_stats_;         // mutex_ 保护
+    std::chrono::steady_clock::time_point link_down_since_;
+    std::thread monitor_thread_;
+    std::atomic<bool> monitor_running_;
+    std::atomic<bool> link_lost_;
+    int monitor_wake_fd_;                // eventfd：收发线程报告断开、停止监视线程
+    int mcu_watchdog_ms_;                // 协议 v2：连接和重连后发给下位机的看门狗超时，0 不发送
+    bool log_frames_;                    // 打印写出的帧（调试用）
+    
+    // 异步发送：调用方只把帧放入待发槽，发送线程用 poll 等待可写后写出，不阻塞视觉/控制线程。
+    // 速度指令只保留最新一条（中间值合并掉），停止指令与配置帧（看门狗）各自单独排队，不会被覆盖。
+    // 发送顺序：停止、配置、速度
+    struct PendingFrame {
+        uint8_t bytes[FRAME_MAX_SIZE];
+        size_t size = 0;
+        bool is_stop = false;
+        int seq = -1;        // 协议 v2 帧的序号，需要等待 ACK
+        std::chrono::steady_clock::time_point enqueued;
+    };
+    std::thread writer_thread_;
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    bool writer_running_;
+    bool has_stop_;
+    PendingFrame stop_frame_;
+    bool has_latest_;
+    PendingFrame latest_frame_;
+    bool has_config_;
+    PendingFrame config_frame_;
+    SerialWriteStats write_stats_;
+    int frame_log_counter_;              // 打印写出帧的抽样计数（queue_mutex_ 保护）
+    
+    // ACK 跟踪（queue_mutex_ 保护）：写出时登记，超时未确认记为丢失。
+    // 停止指令未确认时按 ACK 超时重发，直到确认、有更新的指令或达到重发上限
+    bool awaiting_ack_[256];
+    std::chrono::steady_clock::time_point sent_at_[256];
+    bool stop_unacked_;
+    PendingFrame stop_retry_;
+    int stop_retries_;
+    std::chrono::steady_clock::time_point stop_deadline_;
+    
+    // 接收线程：流式解析下位机的 ACK 与遥测
+    class ReceiveHandler : public FrameParser::Handler {
+    public:
+        explicit ReceiveHandler(SerialPort& port) : port_(port) {}
+        void onAck(uint8_t seq, uint8_t acked_seq, uint8_t status) override;
+        void onTelemetry(uint8_t seq, const MotorTelemetry& telemetry) override;
+        void onUnknown(uint8_t type, uint8_t seq, const uint8_t* payload, size_t size) override;
+    private:
+        SerialPort& port_;
+    };
+    std::thread reader_thread_;
+    std::atomic<bool> reader_running_;
+    mutable std::mutex rx_mutex_;        // 保护以下接收状态；解析回调在持有该锁时执行
+    ReceiveHandler receive_handler_;
+    FrameParser parser_;
+    SerialReceiveStats receive_stats_;   // 只用其中 ACK/遥测计数与读错误，其余取自 parser_
+    bool has_telemetry_;
+    MotorTelemetry telemetry_;
+    
+    void startWriter();
+    void stopWriter();
+    void writerLoop(int fd, int priority);
+    // 非阻塞 fd 上写完整帧，EAGAIN 时 poll 等待可写
+    static bool writeAll(int fd, const uint8_t* data, size_t size, std::string& error);
+    void recordWrite(const PendingFrame& frame, bool ok, const std::string& error);
+    
+    void startReader();
+    void stopReader();
+    void readerLoop(int fd, int priority);
+    void handleReceived(const uint8_t* data, size_t size);
+    void handleAck(uint8_t seq, uint8_t status);
+    
+    void startMonitor();
+    void stopMonitor();        // 不能持有 mutex_ 调用：监视线程重连时需要 mutex_
+    void monitorLoop();
+    // 接收线程调用，不加锁
+    void reportLinkLost();
+    // 以下调用方持有 mutex_
+    void handleLinkLost(const std::string& reason);
+    bool tryReconnect();
+    void disconnectLocked();
+    
+    // 调用方持有 mutex_；is_stop 与 is_config 的帧不会被合并；seq >= 0 的帧等待 ACK
+    bool writeFrame(const void* frame, size_t size, const char* description, bool is_stop = false, int seq = -1,
+                    bool is_config = false);
+    // 协议 v2：编码并发送一条消息，调用方持有 mutex_
+    bool writeMessage(MessageType type, const uint8_t* payload, size_t size, const char* description, bool is_stop = false,
+                      bool is_config = false);
+    // 协议 v2 且设置了看门狗时发送 WATCHDOG，调用方持有 mutex_
+    void writeWatchdog();
+    // 档位指令（0 为停止），调用方持有 mutex_
+    bool writeLevel(int8_t data_value);
     
 public:
     SerialPort();
     ~SerialPort();
     
+    // baud_rate 不在标准表中时（如 1000000、2000000、3000000）通过 termios2/BOTHER 设置
     bool connect(const std::string& port_name = "/dev/ttyUSB0", int baud_rate = 115200);
     void disconnect();
+    // 仿真模式：不打开设备，每帧的字节原样交给 sink（PlantSimulator 闭环测试）
+    bool connectSimulated(const WriteSink& sink);
+    // 仿真模式下把下位机回复的字节交给接收解析（代替接收线程）
+    void receiveSimulated(const uint8_t* data, size_t size);
+    // 自动重连期间设备不可用时返回 false
     bool isConnected() const;
+    // 设备拔出或 USB 复位后自动重连（默认开启），连接前设置
+    void setAutoReconnect(bool enabled);
+    SerialLinkStats getLinkStats() const;
+    unsigned long getReconnectCount() const;
+    // 1: 旧固件的只写固定帧（默认）；2: 带序号、校验和 ACK 的双向协议，并接收遥测
+    bool setProtocolVersion(int version);
+    int getProtocolVersion() const;
+    // 下位机看门狗超时（协议 v2）：连接、重连时以及连接中调用时下发；0 关闭
+    void setMcuWatchdog(int timeout_ms);
+    // 打印写出的帧（每 20 帧一次），默认关闭
+    void setFrameLogging(bool enabled);
+    // 低延迟配置，下次 connect 时生效
+    void setLatencyProfile(const SerialLatencyProfile& profile);
+    // 最近一次 connect 实际生效的波特率与低延迟设置
+    SerialTuningReport getTuningReport() const;
+    // 把已打开的 fd 配置为 8N1 原始模式并应用波特率与低延迟设置（connect 与 dart_bench latency 共用）。
+    // 波特率设置失败返回 false；低延迟各项不被支持时只写入 report.warnings
+    static bool configureTty(int fd, const std::string& port_name, int baud_rate, const SerialLatencyProfile& profile,
+                             SerialTuningReport& report, std::string& error);
     bool sendDataFrame(int8_t data_value);
+    bool sendSpeedFrame(int16_t speed);
     std::string getPortName() const;
+    double getLastWriteDurationMs() const;   // 最近一帧从入队到发送完毕的时间
+    SerialWriteStats getWriteStats() const;
+    SerialReceiveStats getReceiveStats() const;
+    // 最近一次遥测；尚未收到时返回 false
+    bool getTelemetry(MotorTelemetry& telemetry) const;
 };
 
 #endif
\ No newline at end of file
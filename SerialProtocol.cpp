@@ -0,0 +1,51 @@
+#include "SerialProtocol.h"
+#include <cmath>
+#include <cstring>
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t size, uint16_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t encodeFrame(MessageType type, uint8_t seq, const uint8_t* payload, size_t size, uint8_t* out) {
+    if (size > FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+    out[0] = FRAME_START;
+    out[1] = FRAME_HEADER_V2;
+    out[2] = PROTOCOL_VERSION;
+    out[3] = static_cast<uint8_t>(type);
+    out[4] = seq;
+    out[5] = static_cast<uint8_t>(size);
+    if (size > 0) {
+        std::memcpy(out + 6, payload, size);
+    }
+    writeLe16(out + 6 + size, crc16Ccitt(out + 2, 4 + size));
+    out[8 + size] = FRAME_END_0;
+    out[9 + size] = FRAME_END_1;
+    return FRAME_OVERHEAD + size;
+}
+
+size_t encodeTelemetry(const MotorTelemetry& telemetry, uint8_t* payload) {
+    writeLe32(payload, telemetry.mcu_time_ms);
+    writeLe32(payload + 4, static_cast<uint32_t>(static_cast<int32_t>(std::lround(telemetry.position * 1e6))));
+    writeLe32(payload + 8, static_cast<uint32_t>(static_cast<int32_t>(std::lround(telemetry.velocity * 1e6))));
+    payload[12] = telemetry.flags;
+    return TELEMETRY_PAYLOAD_SIZE;
+}
+
+bool decodeTelemetry(const uint8_t* payload, size_t size, MotorTelemetry& telemetry) {
+    if (size < TELEMETRY_PAYLOAD_SIZE) {
+        return false;
+    }
+    telemetry.mcu_time_ms = readLe32(payload);
+    telemetry.position = static_cast<int32_t>(readLe32(payload + 4)) * 1e-6;
+    telemetry.velocity = static_cast<int32_t>(readLe32(payload + 8)) * 1e-6;
+    telemetry.flags = payload[12];
+    return true;
+}
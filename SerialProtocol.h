@@ -0,0 +1,92 @@
+#ifndef SERIALPROTOCOL_H
+#define SERIALPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 串口协议 v2：双向、带序号与校验的变长帧，与旧的 AA 55 / AA 56 固定帧共用 0xAA 起始字节
+//
+//   AA 5A | 版本 | 类型 | 序号 | 长度 | 负载[长度] | CRC16 (小端) | 0D 0A
+//
+// CRC16 为 CRC-16/CCITT-FALSE（多项式 0x1021，初值 0xFFFF），覆盖 版本..负载。
+// 多字节字段一律小端。主机发出的每条指令由下位机用 ACK 回复同一序号；
+// 下位机周期性上报转台位置与速度（TELEMETRY）。
+// 主机用 WATCHDOG 设置下位机看门狗：电机转动时超过超时时间没有收到任何指令即自行停止，
+// 主机在指令不变时按保活周期重发，保证正常运行时不会触发。
+
+constexpr uint8_t FRAME_START = 0xAA;
+constexpr uint8_t FRAME_HEADER_V1_LEVEL = 0x55;   // v1 档位帧 AA 55 data 0D 0A
+constexpr uint8_t FRAME_HEADER_V1_SPEED = 0x56;   // v1 速度帧 AA 56 speed(2) 0D 0A
+constexpr uint8_t FRAME_HEADER_V2 = 0x5A;
+constexpr uint8_t FRAME_END_0 = 0x0D;
+constexpr uint8_t FRAME_END_1 = 0x0A;
+constexpr size_t V1_LEVEL_FRAME_SIZE = 5;
+constexpr size_t V1_SPEED_FRAME_SIZE = 6;
+constexpr uint8_t PROTOCOL_VERSION = 2;
+constexpr size_t FRAME_MAX_PAYLOAD = 16;
+constexpr size_t FRAME_OVERHEAD = 10;   // 帧头 2 + 版本/类型/序号/长度 4 + CRC 2 + 帧尾 2
+constexpr size_t FRAME_MAX_SIZE = FRAME_OVERHEAD + FRAME_MAX_PAYLOAD;
+
+enum class MessageType : uint8_t {
+    // 主机 -> 下位机
+    SPEED = 0x01,      // int16 速度，-10000..10000 对应满速
+    LEVEL = 0x02,      // int8 档位，-5..5
+    STOP = 0x03,       // 无负载
+    WATCHDOG = 0x04,   // uint16 看门狗超时 ms，0 关闭（上电默认关闭）
+    // 下位机 -> 主机
+    ACK = 0x81,        // uint8 被确认的序号, uint8 状态
+    TELEMETRY = 0x82   // 见 MotorTelemetry
+};
+
+enum AckStatus : uint8_t {
+    ACK_OK = 0,
+    ACK_UNSUPPORTED = 1   // 下位机不认识的类型或版本
+};
+
+// 遥测标志位
+enum TelemetryFlags : uint8_t {
+    TELEMETRY_ENABLED = 0x01,    // 电机使能
+    TELEMETRY_LIMIT = 0x02,      // 到达限位
+    TELEMETRY_FAULT = 0x04,      // 驱动器故障
+    TELEMETRY_WATCHDOG = 0x08    // 看门狗超时已停止电机，收到下一条指令后清除
+};
+
+// 下位机上报的转台状态（负载 13 字节：uint32 时间 ms, int32 位置 μrad, int32 速度 μrad/s, uint8 标志）
+struct MotorTelemetry {
+    uint32_t mcu_time_ms = 0;   // 下位机时钟
+    double position = 0.0;      // 水平轴角度（弧度，右为正），编码器零点为上电位置
+    double velocity = 0.0;      // 弧度/秒
+    uint8_t flags = 0;
+    double received_ms = 0.0;   // 主机收到的时刻（steady_clock 毫秒）
+};
+
+constexpr size_t TELEMETRY_PAYLOAD_SIZE = 13;
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t size, uint16_t crc = 0xFFFF);
+
+// 编码一帧到 out（至少 FRAME_OVERHEAD + size 字节），返回帧长；负载过长返回 0
+size_t encodeFrame(MessageType type, uint8_t seq, const uint8_t* payload, size_t size, uint8_t* out);
+
+// 负载编解码
+size_t encodeTelemetry(const MotorTelemetry& telemetry, uint8_t* payload);
+bool decodeTelemetry(const uint8_t* payload, size_t size, MotorTelemetry& telemetry);
+
+inline void writeLe16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline uint16_t readLe16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+inline void writeLe32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline uint32_t readLe32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+#endif // SERIALPROTOCOL_H
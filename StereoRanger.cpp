@@ -0,0 +1,313 @@
+#include "StereoRanger.h"
+#include "DistanceEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+// 相邻帧差的标准差 / sqrt(2)
+double jitter(const std::vector<double>& diffs) {
+    if (diffs.size() < 2) return 0.0;
+    double mean = 0.0;
+    for (double d : diffs) mean += d;
+    mean /= diffs.size();
+    double var = 0.0;
+    for (double d : diffs) var += (d - mean) * (d - mean);
+    return std::sqrt(var / (diffs.size() - 1) / 2.0);
+}
+
+} // namespace
+
+StereoRanger::StereoRanger()
+    : rotation_(cv::Matx33d::eye()), translation_(0, 0, 0), essential_(cv::Matx33d::zeros()),
+      right_center_(0, 0, 0), baseline_(0.0), focal_(0.0), ready_(false), scale_(1.0f),
+      max_epipolar_px_(3.0f), max_size_ratio_(1.5f), disparity_noise_px_(0.3f) {}
+
+bool StereoRanger::loadCalibration(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开双目标定文件: " << file_name << std::endl;
+        return false;
+    }
+
+    cv::Mat k1, d1, k2, d2, r, t;
+    fs["K1"] >> k1;
+    fs["D1"] >> d1;
+    fs["K2"] >> k2;
+    fs["D2"] >> d2;
+    fs["R"] >> r;
+    fs["T"] >> t;
+    if (k1.empty() || k2.empty() || r.empty() || t.empty()) {
+        std::cerr << "双目标定文件缺少 K1/K2/R/T: " << file_name << std::endl;
+        return false;
+    }
+
+    setCalibration(k1, d1, k2, d2, r, t);
+    calibration_size_ = readCalibrationSize(fs, k1);
+    if (!ready_) {
+        std::cerr << "双目外参无效: " << file_name << std::endl;
+        return false;
+    }
+    std::cout << "已加载双目标定: " << file_name << " (基线 " << baseline_ * 1000.0 << "mm)" << std::endl;
+    return true;
+}
+
+void StereoRanger::setCalibration(const cv::Mat& left_matrix, const cv::Mat& left_dist,
+                                  const cv::Mat& right_matrix, const cv::Mat& right_dist,
+                                  const cv::Mat& rotation, const cv::Mat& translation) {
+    left_matrix.convertTo(left_matrix_, CV_64F);
+    right_matrix.convertTo(right_matrix_, CV_64F);
+    if (left_dist.empty()) {
+        left_dist_ = cv::Mat::zeros(5, 1, CV_64F);
+    } else {
+        left_dist.convertTo(left_dist_, CV_64F);
+    }
+    if (right_dist.empty()) {
+        right_dist_ = cv::Mat::zeros(5, 1, CV_64F);
+    } else {
+        right_dist.convertTo(right_dist_, CV_64F);
+    }
+
+    cv::Mat r, t;
+    rotation.convertTo(r, CV_64F);
+    translation.convertTo(t, CV_64F);
+    if (r.total() == 3) {
+        cv::Rodrigues(r.reshape(1, 3), r);
+    }
+    ready_ = r.rows == 3 && r.cols == 3 && t.total() == 3 &&
+             left_matrix_.rows == 3 && left_matrix_.cols == 3 &&
+             right_matrix_.rows == 3 && right_matrix_.cols == 3;
+    if (!ready_) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            rotation_(i, j) = r.at<double>(i, j);
+        }
+        translation_[i] = t.at<double>(i);
+    }
+    cv::Matx33d t_cross(0, -translation_[2], translation_[1],
+                        translation_[2], 0, -translation_[0],
+                        -translation_[1], translation_[0], 0);
+    essential_ = t_cross * rotation_;
+    right_center_ = -(rotation_.t() * translation_);
+    baseline_ = cv::norm(translation_);
+    focal_ = 0.25 * (left_matrix_.at<double>(0, 0) + left_matrix_.at<double>(1, 1) +
+                     right_matrix_.at<double>(0, 0) + right_matrix_.at<double>(1, 1));
+    ready_ = baseline_ > 1e-6 && focal_ > 0;
+}
+
+void StereoRanger::setSensorMode(const SensorMode& mode) {
+    sensor_mode_ = mode;
+}
+
+void StereoRanger::setFrameSize(const cv::Size& frame_size) {
+    scale_ = sensor_mode_.scale(frame_size, calibration_size_);
+}
+
+void StereoRanger::setMatchParameters(float max_epipolar_px, float max_size_ratio, float disparity_noise_px) {
+    max_epipolar_px_ = std::max(0.1f, max_epipolar_px);
+    max_size_ratio_ = std::max(1.0f, max_size_ratio);
+    disparity_noise_px_ = std::max(0.0f, disparity_noise_px);
+}
+
+bool StereoRanger::triangulate(const cv::Point2f& left_normalized, const cv::Point2f& right_normalized,
+                               cv::Point3f& position) const {
+    // 左视线 s * r1，右视线 C2 + t * r2（均在左相机坐标系），取公垂线中点
+    cv::Vec3d r1(left_normalized.x, left_normalized.y, 1.0);
+    cv::Vec3d r2 = rotation_.t() * cv::Vec3d(right_normalized.x, right_normalized.y, 1.0);
+    double a = r1.dot(r1), b = r1.dot(r2), c = r2.dot(r2);
+    double d = r1.dot(right_center_), e = r2.dot(right_center_);
+    double det = b * b - a * c;
+    if (std::fabs(det) < 1e-12) {
+        return false;   // 视线平行（目标在无穷远）
+    }
+    double s = (b * e - c * d) / det;
+    double t = (a * e - b * d) / det;
+    if (s <= 0 || t <= 0) {
+        return false;
+    }
+    cv::Vec3d point = 0.5 * (s * r1 + right_center_ + t * r2);
+    position = cv::Point3f(static_cast<float>(point[0]), static_cast<float>(point[1]), static_cast<float>(point[2]));
+    return true;
+}
+
+std::vector<StereoMatch> StereoRanger::match(const std::vector<DetectionResult>& left,
+                                             const std::vector<DetectionResult>& right) const {
+    std::vector<StereoMatch> matches;
+    if (!ready_ || left.empty() || right.empty()) {
+        return matches;
+    }
+
+    // 帧像素先换算到标定像素（ROI / 像素合并），每侧一次 undistortPoints 得到归一化坐标
+    std::vector<cv::Point2f> left_pixels, right_pixels, left_norm, right_norm;
+    for (const auto& det : left) {
+        left_pixels.push_back(sensor_mode_.toCalibration(cv::Point2f(det.circle[0], det.circle[1]), scale_));
+    }
+    for (const auto& det : right) {
+        right_pixels.push_back(sensor_mode_.toCalibration(cv::Point2f(det.circle[0], det.circle[1]), scale_));
+    }
+    cv::undistortPoints(left_pixels, left_norm, left_matrix_, left_dist_);
+    cv::undistortPoints(right_pixels, right_norm, right_matrix_, right_dist_);
+    // 门限与视差噪声以帧像素计
+    const double right_focal = right_matrix_.at<double>(0, 0) / scale_;
+    const double frame_focal = focal_ / scale_;
+
+    struct Candidate {
+        float cost;
+        StereoMatch match;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < left.size(); ++i) {
+        cv::Vec3d x1(left_norm[i].x, left_norm[i].y, 1.0);
+        cv::Vec3d line = essential_ * x1;
+        double line_norm = std::sqrt(line[0] * line[0] + line[1] * line[1]);
+        if (line_norm < 1e-12) continue;
+        for (size_t j = 0; j < right.size(); ++j) {
+            cv::Vec3d x2(right_norm[j].x, right_norm[j].y, 1.0);
+            float epipolar_px = static_cast<float>(std::fabs(x2.dot(line)) / line_norm * right_focal);
+            if (epipolar_px > max_epipolar_px_) continue;
+
+            float size_ratio = 1.0f;
+            if (left[i].circle[2] > 0 && right[j].circle[2] > 0) {
+                size_ratio = left[i].circle[2] / right[j].circle[2];
+                if (size_ratio < 1.0f) size_ratio = 1.0f / size_ratio;
+                if (size_ratio > max_size_ratio_) continue;
+            }
+
+            StereoMatch m;
+            if (!triangulate(left_norm[i], right_norm[j], m.position)) continue;
+            m.left_index = static_cast<int>(i);
+            m.right_index = static_cast<int>(j);
+            m.epipolar_error_px = epipolar_px;
+            m.range = static_cast<float>(cv::norm(m.position));
+            // 深度误差 ≈ Z^2 / (f * B) * 视差误差
+            m.range_std = static_cast<float>(m.position.z * m.position.z / (frame_focal * baseline_) * disparity_noise_px_);
+            candidates.push_back({epipolar_px / max_epipolar_px_ + std::log(size_ratio), m});
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+    std::vector<bool> left_used(left.size(), false), right_used(right.size(), false);
+    for (const auto& c : candidates) {
+        if (left_used[c.match.left_index] || right_used[c.match.right_index]) continue;
+        left_used[c.match.left_index] = true;
+        right_used[c.match.right_index] = true;
+        matches.push_back(c.match);
+    }
+    return matches;
+}
+
+int StereoRanger::estimate(std::vector<DetectionResult>& left, const std::vector<DetectionResult>& right) const {
+    std::vector<StereoMatch> matches = match(left, right);
+    int estimated = 0;
+    for (const auto& m : matches) {
+        // 与单目相同的有效距离范围；超出时保留单目结果
+        if (!DistanceEstimator::isDistanceValid(m.range)) {
+            continue;
+        }
+        DetectionResult& res = left[m.left_index];
+        const cv::Point3f& p = m.position;
+        res.distance = m.range;
+        res.has_distance = true;
+        res.distance_variance = m.range_std * m.range_std;
+        res.position = p;
+        res.yaw = static_cast<float>(std::atan2(p.x, p.z));
+        res.pitch = static_cast<float>(std::atan2(-p.y, std::sqrt(p.x * p.x + p.z * p.z)));
+        res.has_position = true;
+        estimated++;
+    }
+    return estimated;
+}
+
+StereoEvaluation StereoRanger::evaluateReplay(const std::vector<StereoReplayFrame>& frames) const {
+    StereoEvaluation eval;
+    eval.frames = static_cast<int>(frames.size());
+
+    double sum_diff = 0.0, sum_epipolar = 0.0;
+    int diff_samples = 0;
+    double mono_abs = 0.0, mono_sq = 0.0, mono_sum = 0.0;
+    double stereo_abs = 0.0, stereo_sq = 0.0, stereo_sum = 0.0;
+    std::vector<double> mono_diffs, stereo_diffs;
+    double prev_mono = -1.0, prev_stereo = -1.0;
+
+    for (const auto& frame : frames) {
+        double mono = -1.0, stereo = -1.0;
+        std::vector<StereoMatch> matches = match(frame.left, frame.right);
+        if (!matches.empty()) {
+            const StereoMatch* best = &matches[0];
+            for (const auto& m : matches) {
+                if (m.epipolar_error_px < best->epipolar_error_px) best = &m;
+            }
+            stereo = best->range;
+            sum_epipolar += best->epipolar_error_px;
+            eval.stereo_samples++;
+            const DetectionResult& det = frame.left[best->left_index];
+            if (det.has_distance && det.distance > 0) {
+                mono = det.distance;
+                eval.mono_samples++;
+                sum_diff += mono - stereo;
+                diff_samples++;
+            }
+        }
+
+        // 只比较两种方法都有结果的帧，保证样本一致
+        if (stereo > 0 && mono > 0) {
+            if (prev_stereo > 0 && prev_mono > 0) {
+                mono_diffs.push_back(mono - prev_mono);
+                stereo_diffs.push_back(stereo - prev_stereo);
+            }
+            if (frame.truth_range > 0) {
+                double em = mono - frame.truth_range;
+                double es = stereo - frame.truth_range;
+                mono_abs += std::fabs(em);
+                mono_sq += em * em;
+                mono_sum += em;
+                stereo_abs += std::fabs(es);
+                stereo_sq += es * es;
+                stereo_sum += es;
+                eval.truth_samples++;
+            }
+        }
+        prev_mono = mono;
+        prev_stereo = stereo;
+    }
+
+    if (eval.stereo_samples > 0) eval.mean_epipolar_px = sum_epipolar / eval.stereo_samples;
+    if (diff_samples > 0) eval.mean_mono_minus_stereo = sum_diff / diff_samples;
+    eval.mono_jitter = jitter(mono_diffs);
+    eval.stereo_jitter = jitter(stereo_diffs);
+    if (eval.truth_samples > 0) {
+        double n = eval.truth_samples;
+        eval.mono_mae = mono_abs / n;
+        eval.mono_rmse = std::sqrt(mono_sq / n);
+        eval.mono_bias = mono_sum / n;
+        eval.stereo_mae = stereo_abs / n;
+        eval.stereo_rmse = std::sqrt(stereo_sq / n);
+        eval.stereo_bias = stereo_sum / n;
+    }
+    return eval;
+}
+
+void StereoRanger::printEvaluation(const StereoEvaluation& eval) {
+    std::cout << "=== 双目 vs 单目测距 ===" << std::endl;
+    std::cout << "回放帧数: " << eval.frames << ", 双目匹配: " << eval.stereo_samples
+              << ", 单目有效: " << eval.mono_samples << std::endl;
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "平均极线误差: " << eval.mean_epipolar_px << "px, 单目 - 双目 平均差: "
+              << eval.mean_mono_minus_stereo << "m" << std::endl;
+    std::cout << "逐帧抖动: 单目 " << eval.mono_jitter << "m, 双目 " << eval.stereo_jitter << "m" << std::endl;
+    if (eval.truth_samples > 0) {
+        std::cout << "真值对比 (" << eval.truth_samples << " 帧):" << std::endl;
+        std::cout << "  单目: MAE " << eval.mono_mae << "m, RMSE " << eval.mono_rmse
+                  << "m, 偏差 " << eval.mono_bias << "m" << std::endl;
+        std::cout << "  双目: MAE " << eval.stereo_mae << "m, RMSE " << eval.stereo_rmse
+                  << "m, 偏差 " << eval.stereo_bias << "m" << std::endl;
+    } else {
+        std::cout << "未提供真值距离，只报告一致性与抖动" << std::endl;
+    }
+}
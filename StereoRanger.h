@@ -0,0 +1,102 @@
+#ifndef STEREORANGER_H
+#define STEREORANGER_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "DetectionResult.h"
+#include "SensorMode.h"
+
+// 左右图检测结果的一对匹配
+struct StereoMatch {
+    int left_index = -1;
+    int right_index = -1;
+    float epipolar_error_px = 0.0f;  // 右图中心到左图中心对应极线的距离（像素）
+    cv::Point3f position;            // 三角化得到的目标中心（左相机坐标系，米）
+    float range = -1.0f;             // 到左相机光心的距离（米）
+    float range_std = -1.0f;         // 由视差噪声传播的距离标准差（米）
+};
+
+// 一帧回放数据：左右相机的检测结果，可选的真值距离
+struct StereoReplayFrame {
+    std::vector<DetectionResult> left;
+    std::vector<DetectionResult> right;
+    float truth_range = -1.0f;
+};
+
+// 回放评估：双目与单目（目标尺寸）测距对比
+struct StereoEvaluation {
+    int frames = 0;
+    int stereo_samples = 0;          // 双目匹配成功的帧
+    int mono_samples = 0;            // 同一目标单目距离有效的帧
+    double mean_epipolar_px = 0.0;
+    double mean_mono_minus_stereo = 0.0;
+    // 逐帧抖动：相邻帧距离差的标准差 / sqrt(2)，静止目标时即为单帧噪声
+    double mono_jitter = 0.0;
+    double stereo_jitter = 0.0;
+    // 有真值时的误差（米）
+    int truth_samples = 0;
+    double mono_mae = 0.0;
+    double mono_rmse = 0.0;
+    double mono_bias = 0.0;
+    double stereo_mae = 0.0;
+    double stereo_rmse = 0.0;
+    double stereo_bias = 0.0;
+};
+
+// 双目测距：只对两台相机检测到的目标中心做极线约束匹配和三角化，不做稠密立体匹配
+// 外参 R, T 把左相机坐标系中的点变换到右相机坐标系（与 cv::stereoCalibrate 输出一致）
+class StereoRanger {
+private:
+    cv::Mat left_matrix_, left_dist_;
+    cv::Mat right_matrix_, right_dist_;
+    cv::Matx33d rotation_;
+    cv::Vec3d translation_;
+    cv::Matx33d essential_;     // 归一化坐标下的本质矩阵 [T]x R
+    cv::Vec3d right_center_;    // 右相机光心在左相机坐标系中的位置
+    double baseline_;           // 基线长度（米）
+    double focal_;              // 左右相机平均焦距（像素，标定分辨率）
+    bool ready_;
+    cv::Size calibration_size_; // 标定图像尺寸（来自标定文件）
+    SensorMode sensor_mode_;    // 两台相机使用相同的 ROI / 像素合并
+    float scale_;               // 当前帧像素 -> 标定像素的缩放倍数
+
+    float max_epipolar_px_;     // 极线距离门限（像素）
+    float max_size_ratio_;      // 左右像素直径比门限
+    float disparity_noise_px_;  // 视差观测噪声（像素），用于估计距离标准差
+
+    // 两条视线的中点三角化，深度非正时返回 false
+    bool triangulate(const cv::Point2f& left_normalized, const cv::Point2f& right_normalized,
+                     cv::Point3f& position) const;
+
+public:
+    StereoRanger();
+
+    // 读取 K1, D1, K2, D2, R, T（T 的单位为米）
+    bool loadCalibration(const std::string& file_name);
+    void setCalibration(const cv::Mat& left_matrix, const cv::Mat& left_dist,
+                        const cv::Mat& right_matrix, const cv::Mat& right_dist,
+                        const cv::Mat& rotation, const cv::Mat& translation);
+    bool isReady() const { return ready_; }
+    double getBaseline() const { return baseline_; }
+
+    // 检测坐标为帧像素，与 DistanceEstimator 相同地换算到标定像素后再去畸变
+    void setSensorMode(const SensorMode& mode);
+    void setFrameSize(const cv::Size& frame_size);
+
+    void setMatchParameters(float max_epipolar_px, float max_size_ratio, float disparity_noise_px);
+
+    // 极线约束 + 尺寸一致性的贪心一对一匹配，按代价从小到大
+    std::vector<StereoMatch> match(const std::vector<DetectionResult>& left,
+                                   const std::vector<DetectionResult>& right) const;
+
+    // 用双目结果覆盖匹配到的左图检测的距离、三维位置和方位角（距离方差为单帧视差噪声传播），
+    // 距离超出有效范围的匹配保留单目结果；返回覆盖数
+    int estimate(std::vector<DetectionResult>& left, const std::vector<DetectionResult>& right) const;
+
+    // 回放评估：每帧取极线误差最小的匹配，与同一左图检测的单目距离对比
+    StereoEvaluation evaluateReplay(const std::vector<StereoReplayFrame>& frames) const;
+    static void printEvaluation(const StereoEvaluation& evaluation);
+};
+
+#endif // STEREORANGER_H
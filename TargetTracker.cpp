@@ -0,0 +1,207 @@
+#include "TargetTracker.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+const int STATE_DIM = 5;        // x, y, vx, vy, d
+const int MEASUREMENT_DIM = 3;  // x, y, d
+}
+
+TargetTracker::TargetTracker()
+    : filter_(STATE_DIM, MEASUREMENT_DIM, 0, CV_32F),
+      state_(TrackState::LOST),
+      last_update_ms_(0.0),
+      last_detection_ms_(0.0),
+      hits_(0),
+      track_id_(0),
+      associated_index_(-1),
+      max_coast_ms_(150.0f),
+      gate_px_(40.0f),
+      accel_noise_(1e-3f),
+      diameter_noise_(1e-2f),
+      measurement_noise_px_(1.5f) {
+    // 观测矩阵：直接观测位置和直径
+    filter_.measurementMatrix = cv::Mat::zeros(MEASUREMENT_DIM, STATE_DIM, CV_32F);
+    filter_.measurementMatrix.at<float>(0, 0) = 1.0f;
+    filter_.measurementMatrix.at<float>(1, 1) = 1.0f;
+    filter_.measurementMatrix.at<float>(2, 4) = 1.0f;
+    setNoise(accel_noise_, measurement_noise_px_);
+}
+
+void TargetTracker::setNoise(float accel_noise, float measurement_noise_px) {
+    accel_noise_ = accel_noise;
+    measurement_noise_px_ = measurement_noise_px;
+    cv::setIdentity(filter_.measurementNoiseCov, cv::Scalar::all(measurement_noise_px_ * measurement_noise_px_));
+}
+
+void TargetTracker::reset() {
+    state_ = TrackState::LOST;
+    hits_ = 0;
+}
+
+void TargetTracker::initialize(const DetectionResult& detection, double timestamp_ms) {
+    filter_.statePost = (cv::Mat_<float>(STATE_DIM, 1)
+        << detection.circle[0], detection.circle[1], 0.0f, 0.0f, detection.circle[2] * 2.0f);
+
+    // 初始速度未知，给较大的方差
+    float r = measurement_noise_px_ * measurement_noise_px_;
+    filter_.errorCovPost = cv::Mat::zeros(STATE_DIM, STATE_DIM, CV_32F);
+    filter_.errorCovPost.at<float>(0, 0) = r;
+    filter_.errorCovPost.at<float>(1, 1) = r;
+    filter_.errorCovPost.at<float>(2, 2) = 1.0f;
+    filter_.errorCovPost.at<float>(3, 3) = 1.0f;
+    filter_.errorCovPost.at<float>(4, 4) = r;
+
+    last_update_ms_ = timestamp_ms;
+    last_detection_ms_ = timestamp_ms;
+    hits_ = 1;
+    track_id_++;
+    state_ = TrackState::TRACKING;
+}
+
+void TargetTracker::predictTo(double timestamp_ms) {
+    float dt = static_cast<float>(timestamp_ms - last_update_ms_);
+    if (dt < 0.0f) dt = 0.0f;
+
+    // 匀速模型的状态转移
+    cv::setIdentity(filter_.transitionMatrix);
+    filter_.transitionMatrix.at<float>(0, 2) = dt;
+    filter_.transitionMatrix.at<float>(1, 3) = dt;
+
+    // 白噪声加速度模型的过程噪声
+    float dt2 = dt * dt;
+    float q = accel_noise_;
+    filter_.processNoiseCov = cv::Mat::zeros(STATE_DIM, STATE_DIM, CV_32F);
+    for (int axis = 0; axis < 2; ++axis) {
+        int p = axis, v = axis + 2;
+        filter_.processNoiseCov.at<float>(p, p) = q * dt2 * dt / 3.0f;
+        filter_.processNoiseCov.at<float>(p, v) = q * dt2 / 2.0f;
+        filter_.processNoiseCov.at<float>(v, p) = q * dt2 / 2.0f;
+        filter_.processNoiseCov.at<float>(v, v) = q * dt;
+    }
+    filter_.processNoiseCov.at<float>(4, 4) = diameter_noise_ * dt;
+
+    filter_.predict();
+    // 未观测时 predict() 的结果也作为后验，保证连续外推
+    filter_.statePre.copyTo(filter_.statePost);
+    filter_.errorCovPre.copyTo(filter_.errorCovPost);
+    last_update_ms_ = timestamp_ms;
+}
+
+int TargetTracker::associate(const std::vector<DetectionResult>& detections) const {
+    cv::Point2f predicted = getCenter();
+    float gate = std::max(gate_px_, getDiameter() * 2.0f);
+
+    int best = -1;
+    float best_dist = gate;
+    for (size_t i = 0; i < detections.size(); ++i) {
+        float dist = std::hypot(detections[i].circle[0] - predicted.x, detections[i].circle[1] - predicted.y);
+        if (dist <= best_dist) {
+            best_dist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+int TargetTracker::selectInitial(const std::vector<DetectionResult>& detections) {
+    // 检测器按轮廓查找顺序输出，不保证有序
+    int best = -1;
+    for (size_t i = 0; i < detections.size(); ++i) {
+        if (best < 0 || detections[i].confidence > detections[best].confidence) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+void TargetTracker::update(const std::vector<DetectionResult>& detections, double timestamp_ms) {
+    associated_index_ = -1;
+    if (state_ == TrackState::LOST) {
+        // 没有轨迹时用置信度最高的检测初始化
+        int index = selectInitial(detections);
+        if (index >= 0) {
+            initialize(detections[index], timestamp_ms);
+            associated_index_ = index;
+        }
+        return;
+    }
+
+    predictTo(timestamp_ms);
+
+    int index = associate(detections);
+    if (index >= 0) {
+        const DetectionResult& det = detections[index];
+        cv::Mat measurement = (cv::Mat_<float>(MEASUREMENT_DIM, 1)
+            << det.circle[0], det.circle[1], det.circle[2] * 2.0f);
+        filter_.correct(measurement);
+        last_detection_ms_ = timestamp_ms;
+        associated_index_ = index;
+        hits_++;
+        state_ = TrackState::TRACKING;
+        return;
+    }
+
+    // 丢检或检测都在门限外：外推，超时后放弃轨迹
+    hits_ = 0;
+    if (timestamp_ms - last_detection_ms_ > max_coast_ms_) {
+        state_ = TrackState::LOST;
+        // 门限外的检测可能是目标跳变，直接重新初始化
+        int index = selectInitial(detections);
+        if (index >= 0) {
+            initialize(detections[index], timestamp_ms);
+            associated_index_ = index;
+        }
+    } else {
+        state_ = TrackState::COASTING;
+    }
+}
+
+cv::Point2f TargetTracker::predictCenter(double timestamp_ms) const {
+    cv::Point2f center = getCenter();
+    if (state_ == TrackState::LOST) return center;
+
+    // 外推时长不超过最长外推时间，避免速度估计误差被无限放大
+    double horizon = timestamp_ms - last_update_ms_;
+    double limit = max_coast_ms_ - (last_update_ms_ - last_detection_ms_);
+    horizon = std::max(0.0, std::min(horizon, limit));
+
+    cv::Point2f velocity = getVelocity();
+    return cv::Point2f(center.x + velocity.x * static_cast<float>(horizon),
+                       center.y + velocity.y * static_cast<float>(horizon));
+}
+
+cv::Matx22f TargetTracker::predictCovariance(double timestamp_ms) const {
+    const cv::Mat& P = filter_.errorCovPost;
+    float h = static_cast<float>(std::max(0.0, timestamp_ms - last_update_ms_));
+    cv::Matx22f cov;
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            // 匀速外推：P_pp + h (P_pv + P_vp) + h^2 P_vv
+            cov(i, j) = P.at<float>(i, j) + h * (P.at<float>(i, j + 2) + P.at<float>(i + 2, j)) +
+                        h * h * P.at<float>(i + 2, j + 2);
+        }
+        cov(i, i) += accel_noise_ * h * h * h / 3.0f;
+    }
+    return cov;
+}
+
+cv::Point2f TargetTracker::getCenter() const {
+    return cv::Point2f(filter_.statePost.at<float>(0), filter_.statePost.at<float>(1));
+}
+
+cv::Point2f TargetTracker::getVelocity() const {
+    return cv::Point2f(filter_.statePost.at<float>(2), filter_.statePost.at<float>(3));
+}
+
+float TargetTracker::getDiameter() const {
+    return filter_.statePost.at<float>(4);
+}
+
+std::string TargetTracker::getStateString() const {
+    switch (state_) {
+        case TrackState::TRACKING: return "跟踪中";
+        case TrackState::COASTING: return "外推中";
+        default: return "丢失";
+    }
+}
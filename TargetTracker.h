@@ -0,0 +1,77 @@
+#ifndef TARGETTRACKER_H
+#define TARGETTRACKER_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "DetectionResult.h"
+
+// 目标跟踪状态
+enum class TrackState {
+    LOST,       // 没有有效轨迹
+    TRACKING,   // 当前帧有关联的检测
+    COASTING    // 短暂丢检，按速度外推
+};
+
+// 匀速模型卡尔曼跟踪器：状态为 (x, y, vx, vy, 像素直径)，时间单位毫秒
+// 位于检测与对准之间，平滑抖动并在短暂丢检时继续给出预测位置
+class TargetTracker {
+private:
+    cv::KalmanFilter filter_;
+    TrackState state_;
+    double last_update_ms_;      // 滤波器状态对应的时间戳
+    double last_detection_ms_;   // 最近一次关联到检测的时间戳
+    int hits_;                   // 连续关联成功的帧数
+    int track_id_;               // 当前轨迹 ID，每次重新初始化递增
+    int associated_index_;       // 最近一帧关联到的检测序号，未关联为 -1
+
+    float max_coast_ms_;         // 丢检后继续外推的最长时间
+    float gate_px_;              // 关联门限（像素），实际门限取它与预测直径 2 倍中的较大值
+    float accel_noise_;          // 过程噪声：加速度谱密度（像素/ms^2）
+    float diameter_noise_;       // 过程噪声：直径随机游走（像素/ms）
+    float measurement_noise_px_; // 观测噪声标准差（像素）
+
+    void initialize(const DetectionResult& detection, double timestamp_ms);
+    void predictTo(double timestamp_ms);
+    int associate(const std::vector<DetectionResult>& detections) const;
+    // 新建轨迹时选用的检测：置信度（圆度）最高者，检测为空返回 -1
+    static int selectInitial(const std::vector<DetectionResult>& detections);
+
+public:
+    TargetTracker();
+
+    // 输入一帧的检测结果及其采集时间戳，检测为空表示该帧丢检
+    void update(const std::vector<DetectionResult>& detections, double timestamp_ms);
+
+    // 丢弃当前轨迹
+    void reset();
+
+    // 是否存在可用于控制的轨迹（跟踪中或外推中）
+    bool hasTrack() const { return state_ != TrackState::LOST; }
+    bool isCoasting() const { return state_ == TrackState::COASTING; }
+    TrackState getState() const { return state_; }
+    std::string getStateString() const;
+
+    // 外推到指定时刻（通常为发送控制指令的时刻）的目标中心
+    cv::Point2f predictCenter(double timestamp_ms) const;
+
+    // 外推到指定时刻的中心位置协方差（像素^2），包含速度不确定度和过程噪声，不受外推时长上限限制
+    cv::Matx22f predictCovariance(double timestamp_ms) const;
+
+    cv::Point2f getCenter() const;
+    cv::Point2f getVelocity() const;   // 像素/ms
+    float getDiameter() const;
+    double getLastUpdateTime() const { return last_update_ms_; }     // getCenter/getVelocity 对应的时刻
+    double getLastDetectionTime() const { return last_detection_ms_; }
+    int getHits() const { return hits_; }
+    int getTrackId() const { return track_id_; }
+    int getAssociatedIndex() const { return associated_index_; }
+
+    // 参数设置
+    void setMaxCoastTime(float ms) { max_coast_ms_ = ms; }
+    void setGate(float px) { gate_px_ = px; }
+    void setNoise(float accel_noise, float measurement_noise_px);
+    float getMaxCoastTime() const { return max_coast_ms_; }
+};
+
+#endif // TARGETTRACKER_H
@@ -0,0 +1,247 @@
+#include "Undistorter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'D', 'A', 'R', 'T', 'U', 'N', 'D', '1'};
+
+// 缓存文件头，后面依次是 map1、map2、点网格，各段按 64 字节对齐
+struct CacheHeader {
+    char magic[8];
+    int32_t width;
+    int32_t height;
+    int32_t grid_step;
+    int32_t grid_cols;
+    int32_t grid_rows;
+    int32_t reserved;
+    uint64_t hash;
+    uint64_t map1_offset;
+    uint64_t map2_offset;
+    uint64_t grid_offset;
+    uint64_t total_size;
+};
+
+// 标定参数、分辨率和网格步长决定查找表内容
+uint64_t hashParameters(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& size, int grid_step) {
+    Fnv1aHash hash;
+    cv::Mat k, d;
+    camera_matrix.convertTo(k, CV_64F);
+    if (!dist_coeffs.empty()) dist_coeffs.convertTo(d, CV_64F);
+    k = k.clone();
+    d = d.clone();
+    hash.mix(k.data, k.total() * sizeof(double));
+    if (!d.empty()) hash.mix(d.data, d.total() * sizeof(double));
+    hash.mix(&size.width, sizeof(size.width));
+    hash.mix(&size.height, sizeof(size.height));
+    hash.mix(&grid_step, sizeof(grid_step));
+    return hash.value();
+}
+
+// 段布局
+void computeLayout(const cv::Size& image_size, const cv::Size& grid_size, CacheHeader& header) {
+    size_t pixels = static_cast<size_t>(image_size.width) * image_size.height;
+    header.map1_offset = alignCacheOffset(sizeof(CacheHeader));
+    header.map2_offset = alignCacheOffset(header.map1_offset + pixels * 2 * sizeof(int16_t));
+    header.grid_offset = alignCacheOffset(header.map2_offset + pixels * sizeof(uint16_t));
+    header.total_size = header.grid_offset + static_cast<size_t>(grid_size.area()) * 2 * sizeof(float);
+}
+
+} // namespace
+
+Undistorter::Undistorter()
+    : grid_step_(16) {}
+
+Undistorter::~Undistorter() {
+    releaseMapping();
+}
+
+void Undistorter::releaseMapping() {
+    map1_.release();
+    map2_.release();
+    point_grid_.release();
+    mapping_.release();
+}
+
+bool Undistorter::matches(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& image_size) const {
+    if (!isReady() || image_size != image_size_) return false;
+    return hashParameters(camera_matrix, dist_coeffs, image_size, grid_step_) ==
+           hashParameters(camera_matrix_, dist_coeffs_, image_size_, grid_step_);
+}
+
+bool Undistorter::init(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& image_size,
+                       const std::string& cache_file, int grid_step) {
+    if (camera_matrix.rows != 3 || camera_matrix.cols != 3 || image_size.width <= 0 || image_size.height <= 0) {
+        std::cerr << "[Undistorter] 相机矩阵或图像尺寸无效" << std::endl;
+        return false;
+    }
+
+    releaseMapping();
+    camera_matrix.convertTo(camera_matrix_, CV_64F);
+    if (dist_coeffs.empty()) {
+        dist_coeffs_ = cv::Mat::zeros(5, 1, CV_64F);
+    } else {
+        dist_coeffs.convertTo(dist_coeffs_, CV_64F);
+    }
+    image_size_ = image_size;
+    grid_step_ = std::max(1, grid_step);
+    grid_size_ = cv::Size(image_size.width / grid_step_ + 2, image_size.height / grid_step_ + 2);
+
+    if (!cache_file.empty() && loadCache(cache_file)) {
+        std::cout << "[Undistorter] 已映射校正查找表: " << cache_file << std::endl;
+        return true;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    buildTables();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "[Undistorter] 已生成校正查找表 " << image_size.width << "x" << image_size.height
+              << ", 耗时 " << std::chrono::duration<double, std::milli>(end - start).count() << "ms" << std::endl;
+
+    if (!cache_file.empty()) {
+        saveCache(cache_file);
+    }
+    return true;
+}
+
+void Undistorter::buildTables() {
+    // 校正后图像沿用原相机矩阵，定点表由 remap 直接使用
+    cv::initUndistortRectifyMap(camera_matrix_, dist_coeffs_, cv::Mat(), camera_matrix_,
+                                image_size_, CV_16SC2, map1_, map2_);
+
+    // 检测点网格：节点覆盖 [0, width] x [0, height]，最后一列/行超出图像一个步长以便插值
+    std::vector<cv::Point2f> nodes;
+    nodes.reserve(grid_size_.area());
+    for (int gy = 0; gy < grid_size_.height; ++gy) {
+        for (int gx = 0; gx < grid_size_.width; ++gx) {
+            nodes.push_back(cv::Point2f(static_cast<float>(gx * grid_step_), static_cast<float>(gy * grid_step_)));
+        }
+    }
+    std::vector<cv::Point2f> normalized;
+    cv::undistortPoints(nodes, normalized, camera_matrix_, dist_coeffs_);
+    point_grid_.create(grid_size_.height, grid_size_.width, CV_32FC2);
+    for (int gy = 0; gy < grid_size_.height; ++gy) {
+        cv::Point2f* row = point_grid_.ptr<cv::Point2f>(gy);
+        for (int gx = 0; gx < grid_size_.width; ++gx) {
+            row[gx] = normalized[gy * grid_size_.width + gx];
+        }
+    }
+}
+
+bool Undistorter::loadCache(const std::string& file_name) {
+    if (!mapping_.open(file_name, sizeof(CacheHeader))) {
+        return false;
+    }
+
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(mapping_.data());
+    CacheHeader expected;
+    computeLayout(image_size_, grid_size_, expected);
+    bool valid = std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header->width == image_size_.width &&
+                 header->height == image_size_.height &&
+                 header->grid_step == grid_step_ &&
+                 header->grid_cols == grid_size_.width &&
+                 header->grid_rows == grid_size_.height &&
+                 header->hash == hashParameters(camera_matrix_, dist_coeffs_, image_size_, grid_step_) &&
+                 header->map1_offset == expected.map1_offset &&
+                 header->map2_offset == expected.map2_offset &&
+                 header->grid_offset == expected.grid_offset &&
+                 header->total_size == expected.total_size &&
+                 mapping_.size() >= expected.total_size;
+    if (!valid) {
+        std::cout << "[Undistorter] 缓存与当前标定不匹配，重新生成: " << file_name << std::endl;
+        mapping_.release();
+        return false;
+    }
+
+    // 查找表直接指向映射区域（只读），不做拷贝
+    char* base = const_cast<char*>(mapping_.data());
+    map1_ = cv::Mat(image_size_, CV_16SC2, base + header->map1_offset);
+    map2_ = cv::Mat(image_size_, CV_16UC1, base + header->map2_offset);
+    point_grid_ = cv::Mat(grid_size_, CV_32FC2, base + header->grid_offset);
+    return true;
+}
+
+bool Undistorter::saveCache(const std::string& file_name) const {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.width = image_size_.width;
+    header.height = image_size_.height;
+    header.grid_step = grid_step_;
+    header.grid_cols = grid_size_.width;
+    header.grid_rows = grid_size_.height;
+    header.hash = hashParameters(camera_matrix_, dist_coeffs_, image_size_, grid_step_);
+    computeLayout(image_size_, grid_size_, header);
+
+    // 查找表由 buildTables 生成，均为连续存储
+    auto segment = [](uint64_t offset, const cv::Mat& mat) {
+        return CacheSegment{offset, mat.data, mat.total() * mat.elemSize()};
+    };
+    if (!writeCacheFile(file_name, &header, sizeof(header),
+                        {segment(header.map1_offset, map1_), segment(header.map2_offset, map2_),
+                         segment(header.grid_offset, point_grid_)})) {
+        return false;
+    }
+
+    std::cout << "[Undistorter] 校正查找表已缓存: " << file_name
+              << " (" << header.total_size / (1024 * 1024) << "MB)" << std::endl;
+    return true;
+}
+
+void Undistorter::remap(const cv::Mat& src, cv::Mat& dst, int interpolation) const {
+    cv::remap(src, dst, map1_, map2_, interpolation, cv::BORDER_CONSTANT);
+}
+
+void Undistorter::remapRoi(const cv::Mat& src, const cv::Rect& roi, cv::Mat& dst, int interpolation) const {
+    // 查找表中存的是原图坐标，取 ROI 子表即可只计算这部分输出
+    cv::Rect clipped = roi & cv::Rect(0, 0, image_size_.width, image_size_.height);
+    if (clipped.empty()) {
+        dst.release();
+        return;
+    }
+    cv::remap(src, dst, map1_(clipped), map2_(clipped), interpolation, cv::BORDER_CONSTANT);
+}
+
+void Undistorter::normalizePoints(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& normalized) const {
+    normalized.resize(pixels.size());
+    std::vector<size_t> fallback;
+    const float inv_step = 1.0f / grid_step_;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        float fx = pixels[i].x * inv_step;
+        float fy = pixels[i].y * inv_step;
+        int gx = static_cast<int>(std::floor(fx));
+        int gy = static_cast<int>(std::floor(fy));
+        if (gx < 0 || gy < 0 || gx + 1 >= grid_size_.width || gy + 1 >= grid_size_.height) {
+            fallback.push_back(i);
+            continue;
+        }
+        float ax = fx - gx;
+        float ay = fy - gy;
+        const cv::Point2f* r0 = point_grid_.ptr<cv::Point2f>(gy);
+        const cv::Point2f* r1 = point_grid_.ptr<cv::Point2f>(gy + 1);
+        cv::Point2f top = r0[gx] * (1.0f - ax) + r0[gx + 1] * ax;
+        cv::Point2f bottom = r1[gx] * (1.0f - ax) + r1[gx + 1] * ax;
+        normalized[i] = top * (1.0f - ay) + bottom * ay;
+    }
+
+    // 网格外的点（图像外）退回逐点求解
+    if (!fallback.empty()) {
+        std::vector<cv::Point2f> src, dst;
+        for (size_t i : fallback) src.push_back(pixels[i]);
+        cv::undistortPoints(src, dst, camera_matrix_, dist_coeffs_);
+        for (size_t k = 0; k < fallback.size(); ++k) normalized[fallback[k]] = dst[k];
+    }
+}
+
+void Undistorter::undistortPoints(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& undistorted) const {
+    normalizePoints(pixels, undistorted);
+    const double fx = camera_matrix_.at<double>(0, 0), fy = camera_matrix_.at<double>(1, 1);
+    const double cx = camera_matrix_.at<double>(0, 2), cy = camera_matrix_.at<double>(1, 2);
+    for (auto& p : undistorted) {
+        p = cv::Point2f(static_cast<float>(fx * p.x + cx), static_cast<float>(fy * p.y + cy));
+    }
+}
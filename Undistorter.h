@@ -0,0 +1,62 @@
+#ifndef UNDISTORTER_H
+#define UNDISTORTER_H
+
+#include "CacheFile.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 缓存的畸变校正：每个标定 + 分辨率只计算一次查找表
+// - 图像：initUndistortRectifyMap 生成的定点表（CV_16SC2 + CV_16UC1），支持只校正指定 ROI
+// - 检测点：稀疏网格上的归一化坐标表，双线性插值，替代逐点迭代求解
+// 查找表可写入磁盘，下次启动时 mmap 直接使用
+class Undistorter {
+private:
+    cv::Mat camera_matrix_;
+    cv::Mat dist_coeffs_;
+    cv::Size image_size_;
+    int grid_step_;
+    cv::Size grid_size_;
+
+    cv::Mat map1_;        // CV_16SC2：整数坐标
+    cv::Mat map2_;        // CV_16UC1：插值表索引
+    cv::Mat point_grid_;  // CV_32FC2：网格节点的归一化坐标
+
+    MappedFile mapping_;  // mmap 映射的缓存文件，未映射表示查找表在堆上
+
+    void buildTables();
+    bool loadCache(const std::string& file_name);
+    bool saveCache(const std::string& file_name) const;
+    void releaseMapping();
+
+public:
+    Undistorter();
+    ~Undistorter();
+    Undistorter(const Undistorter&) = delete;
+    Undistorter& operator=(const Undistorter&) = delete;
+
+    // 初始化查找表；cache_file 非空时优先 mmap 已有缓存，参数不匹配则重新计算并写入
+    bool init(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& image_size,
+              const std::string& cache_file = "", int grid_step = 16);
+
+    bool isReady() const { return !map1_.empty(); }
+    bool isMapped() const { return mapping_.isMapped(); }
+    bool matches(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs, const cv::Size& image_size) const;
+    cv::Size getImageSize() const { return image_size_; }
+
+    // 整幅图像校正
+    void remap(const cv::Mat& src, cv::Mat& dst, int interpolation = cv::INTER_LINEAR) const;
+
+    // 只校正输出图像中的 roi 区域（roi 为校正后坐标），dst 尺寸为 roi 尺寸
+    void remapRoi(const cv::Mat& src, const cv::Rect& roi, cv::Mat& dst, int interpolation = cv::INTER_LINEAR) const;
+
+    // 畸变像素点 -> 归一化相机坐标（与 cv::undistortPoints 不带 P 时一致）
+    void normalizePoints(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& normalized) const;
+
+    // 畸变像素点 -> 校正后图像中的像素坐标
+    void undistortPoints(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point2f>& undistorted) const;
+};
+
+#endif // UNDISTORTER_H
@@ -87,6 +87,16 @@ void UserInterface::displayResults(const cv::Mat& camera_frame, const cv::Mat& d
                    cv::Point(10, 120), 
                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 0), 1);
         
+        // 显示命中概率与发射许可
+        if (align_controller.getHitEstimate().valid) {
+            std::string hit_text = "P(hit): " + std::to_string(static_cast<int>(align_controller.getHitProbability() * 100.0f)) + "%";
+            cv::putText(result_display, 
+                       align_controller.isFirePermitted() ? hit_text + " FIRE OK" : hit_text,
+                       cv::Point(10, 145), 
+                       cv::FONT_HERSHEY_SIMPLEX, 0.6, 
+                       align_controller.isFirePermitted() ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 165, 255), 1);
+        }
+        
         // 显示电机状态
         std::string motor_state = "Motor: " + align_controller.getMotorStateString();
         cv::putText(result_display, 
@@ -206,6 +216,16 @@ void UserInterface::displayResults(const cv::Mat& camera_frame, const cv::Mat& d
                    cv::Point(10, 120), 
                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 0), 1);
         
+        // 显示命中概率与发射许可
+        if (align_controller.getHitEstimate().valid) {
+            std::string hit_text = "P(hit): " + std::to_string(static_cast<int>(align_controller.getHitProbability() * 100.0f)) + "%";
+            cv::putText(result_display, 
+                       align_controller.isFirePermitted() ? hit_text + " FIRE OK" : hit_text,
+                       cv::Point(10, 145), 
+                       cv::FONT_HERSHEY_SIMPLEX, 0.6, 
+                       align_controller.isFirePermitted() ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 165, 255), 1);
+        }
+        
         // 显示电机状态
         std::string motor_state = "Motor: " + align_controller.getMotorStateString();
         cv::putText(result_display, 
@@ -300,11 +320,13 @@ void UserInterface::handleKeyPress(int key, VisionDetector& vision_detector, Ali
     handleCircularityThreshold(key, vision_detector);
     handleDetectionMode(key, vision_detector);
     handleDebugToggle(key, vision_detector);
+    handleOpenCLToggle(key, vision_detector);
     handleGridToggle(key);
     handleAlignmentToggle(key, align_controller);
     handleAlignmentThreshold(key, align_controller);
     handleAlignmentStatus(key, align_controller);
     handleSerialPort(key, align_controller);
+    handlePidGains(key, align_controller);
     handleResetParameters(key, vision_detector, align_controller);
 }
 
@@ -338,10 +360,12 @@ void UserInterface::printHelp() {
     std::cout << "按 'm' 键切换检测模式" << std::endl;
     std::cout << "按 'd' 键显示/隐藏调试信息" << std::endl;
     std::cout << "按 'c' 键显示/隐藏中心网格线" << std::endl;
+    std::cout << "按 'g' 键开启/关闭 OpenCL 加速" << std::endl;
     std::cout << "按 'a' 键开启/关闭自动对准" << std::endl;
     std::cout << "按 't' 键设置对准阈值" << std::endl;
     std::cout << "按 'p' 键显示当前对准状态" << std::endl;
     std::cout << "按 'o' 键设置串口设备" << std::endl;
+    std::cout << "按 'k' 键调整 PID 参数" << std::endl;
     std::cout << "==========================================" << std::endl;
 }
 
@@ -386,6 +410,13 @@ void UserInterface::handleDebugToggle(int key, VisionDetector& vision_detector)
     }
 }
 
+void UserInterface::handleOpenCLToggle(int key, VisionDetector& vision_detector) {
+    if (key == 'g' || key == 'G') {
+        bool enabled = vision_detector.setUseOpenCL(!vision_detector.isUsingOpenCL());
+        std::cout << "OpenCL 加速: " << (enabled ? "开启" : "关闭") << std::endl;
+    }
+}
+
 void UserInterface::handleGridToggle(int key) {
     if (key == 'c' || key == 'C') {
         show_grid_ = !show_grid_;
@@ -401,12 +432,26 @@ void UserInterface::handleAlignmentToggle(int key, AlignmentController& align_co
 
 void UserInterface::handleAlignmentThreshold(int key, AlignmentController& align_controller) {
     if (key == 't' || key == 'T') {
-        std::cout << "当前对准阈值: " << align_controller.getAlignmentThreshold() << "px" << std::endl;
-        std::cout << "请输入新的阈值 (1-20像素): ";
+        // 角度模式下对准判定使用毫弧度阈值
+        bool angle_mode = align_controller.isAngleMode();
+        if (angle_mode) {
+            std::cout << "当前对准阈值: " << align_controller.getAngleAlignmentThreshold() << "mrad" << std::endl;
+            std::cout << "请输入新的阈值 (0.1-20毫弧度): ";
+        } else {
+            std::cout << "当前对准阈值: " << align_controller.getAlignmentThreshold() << "px" << std::endl;
+            std::cout << "请输入新的阈值 (1-20像素): ";
+        }
         
         float new_threshold;
-        std::cin >> new_threshold;
-        align_controller.setAlignmentThreshold(new_threshold);
+        if (!(std::cin >> new_threshold)) {
+            std::cin.clear();
+            std::cin.ignore(1024, '\n');
+            std::cout << "输入无效，保持原阈值" << std::endl;
+        } else if (angle_mode) {
+            align_controller.setAngleAlignmentThreshold(new_threshold);
+        } else {
+            align_controller.setAlignmentThreshold(new_threshold);
+        }
     }
 }
 
@@ -427,6 +472,25 @@ void UserInterface::handleSerialPort(int key, AlignmentController& align_control
     }
 }
 
+void UserInterface::handlePidGains(int key, AlignmentController& align_controller) {
+    if (key == 'k' || key == 'K') {
+        PidGains gains = align_controller.getPidGains();
+        std::cout << "当前 PID: kp=" << gains.kp << " ki=" << gains.ki << " kd=" << gains.kd
+                  << " kff=" << gains.kff << (align_controller.isContinuousControl() ? "" : " (未启用连续控制)") << std::endl;
+        std::cout << "请输入新的 kp ki kd kff: ";
+        
+        PidGains new_gains = gains;
+        if (std::cin >> new_gains.kp >> new_gains.ki >> new_gains.kd >> new_gains.kff &&
+            new_gains.kp >= 0 && new_gains.ki >= 0 && new_gains.kd >= 0) {
+            align_controller.setPidGains(new_gains);
+        } else {
+            std::cin.clear();
+            std::cin.ignore(1024, '\n');
+            std::cout << "输入无效，保持原参数" << std::endl;
+        }
+    }
+}
+
 void UserInterface::handleResetParameters(int key, VisionDetector& vision_detector, AlignmentController& align_controller) {
     if (key == 'r' || key == 'R') {
         // 重置视觉检测参数
@@ -437,6 +501,10 @@ void UserInterface::handleResetParameters(int key, VisionDetector& vision_detect
         // 重置对准参数
         align_controller.resetAlignment();
         align_controller.setAlignmentThreshold(5.0f);
+        if (align_controller.isAngleMode()) {
+            align_controller.setAngleAlignmentThreshold(
+                MotorController::defaultAngularSpeedBands().thresholds[0] * 1000.0f);
+        }
         
         // 重置UI参数
         show_grid_ = true;
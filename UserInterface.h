@@ -63,11 +63,13 @@ private:
     void handleCircularityThreshold(int key, VisionDetector& vision_detector);
     void handleDetectionMode(int key, VisionDetector& vision_detector);
     void handleDebugToggle(int key, VisionDetector& vision_detector);
+    void handleOpenCLToggle(int key, VisionDetector& vision_detector);
     void handleGridToggle(int key);
     void handleAlignmentToggle(int key, AlignmentController& align_controller);
     void handleAlignmentThreshold(int key, AlignmentController& align_controller);
     void handleAlignmentStatus(int key, AlignmentController& align_controller);
     void handleSerialPort(int key, AlignmentController& align_controller);
+    void handlePidGains(int key, AlignmentController& align_controller);
     void handleResetParameters(int key, VisionDetector& vision_detector, AlignmentController& align_controller);
 };
 #endif // USERINTERFACE_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "VisionDetector.h"
+#include <opencv2/core/ocl.hpp>
 #include <iostream>
 #include <algorithm>
 
@@ -45,64 +46,172 @@ void VisionDetector::setDebugInfo(bool show) {
     show_debug_info_ = show;
 }
 
-cv::Mat VisionDetector::detectGreenCircles(const cv::Mat& frame, std::vector<cv::Point2f>& detected_circles) {
-    detected_circles.clear();
-    
-    // 保存原始帧
-    frame.copyTo(current_frame_);
-    
-    // 对 2448x2048 等高分辨率摄像头进行缩放处理以提高性能
-    float scale = 1.0f;
-    const int max_dim = 1024; // 将较长边缩放到不超过此值
-    int max_side = std::max(frame.cols, frame.rows);
-    if (max_side > max_dim) {
-        scale = static_cast<float>(max_dim) / static_cast<float>(max_side);
+bool VisionDetector::setUseOpenCL(bool enable) {
+    if (enable && !isOpenCLAvailable()) {
+        std::cout << "当前平台不支持 OpenCL，继续使用 CPU 检测路径" << std::endl;
+        enable = false;
+    }
+    cv::ocl::setUseOpenCL(enable);
+    use_opencl_ = enable;
+    return use_opencl_;
+}
+
+bool VisionDetector::isUsingOpenCL() const {
+    return use_opencl_;
+}
+
+bool VisionDetector::isOpenCLAvailable() {
+    return cv::ocl::haveOpenCL();
+}
+
+void VisionDetector::setPackedMorphology(bool enable) {
+    use_packed_morphology_ = enable;
+}
+
+bool VisionDetector::isUsingPackedMorphology() const {
+    return use_packed_morphology_;
+}
+
+const std::vector<std::string>& VisionDetector::parameterNames() {
+    static const std::vector<std::string> names = {
+        "circularity_threshold",
+        "h_min", "s_min", "v_min", "h_max", "s_max", "v_max",
+        "min_area", "max_area", "min_radius", "max_radius",
+        "brightness_low", "gradient_low",
+        "morph_kernel_size", "detection_mode"
+    };
+    return names;
+}
+
+bool VisionDetector::setParameter(const std::string& name, double value) {
+    if (name == "circularity_threshold") circularity_threshold_ = value;
+    else if (name == "h_min") green_lower_[0] = value;
+    else if (name == "s_min") green_lower_[1] = value;
+    else if (name == "v_min") green_lower_[2] = value;
+    else if (name == "h_max") green_upper_[0] = value;
+    else if (name == "s_max") green_upper_[1] = value;
+    else if (name == "v_max") green_upper_[2] = value;
+    else if (name == "min_area") min_area_ = value;
+    else if (name == "max_area") max_area_ = value;
+    else if (name == "min_radius") min_radius_ = value;
+    else if (name == "max_radius") max_radius_ = value;
+    else if (name == "brightness_low") brightness_threshold_low_ = value;
+    else if (name == "gradient_low") gradient_threshold_low_ = value;
+    else if (name == "morph_kernel_size") morph_kernel_size_ = std::max(1, static_cast<int>(value)) | 1;
+    else if (name == "detection_mode") detection_mode_ = static_cast<int>(value);
+    else return false;
+    return true;
+}
+
+void VisionDetector::copySettingsFrom(const VisionDetector& other) {
+    for (const auto& name : parameterNames()) {
+        double value = 0.0;
+        if (other.getParameter(name, value)) {
+            setParameter(name, value);
+        }
+    }
+    use_opencl_ = other.use_opencl_;
+    use_packed_morphology_ = other.use_packed_morphology_;
+}
+
+bool VisionDetector::getParameter(const std::string& name, double& value) const {
+    if (name == "circularity_threshold") value = circularity_threshold_;
+    else if (name == "h_min") value = green_lower_[0];
+    else if (name == "s_min") value = green_lower_[1];
+    else if (name == "v_min") value = green_lower_[2];
+    else if (name == "h_max") value = green_upper_[0];
+    else if (name == "s_max") value = green_upper_[1];
+    else if (name == "v_max") value = green_upper_[2];
+    else if (name == "min_area") value = min_area_;
+    else if (name == "max_area") value = max_area_;
+    else if (name == "min_radius") value = min_radius_;
+    else if (name == "max_radius") value = max_radius_;
+    else if (name == "brightness_low") value = brightness_threshold_low_;
+    else if (name == "gradient_low") value = gradient_threshold_low_;
+    else if (name == "morph_kernel_size") value = morph_kernel_size_;
+    else if (name == "detection_mode") value = detection_mode_;
+    else return false;
+    return true;
+}
+
+bool VisionDetector::loadParameters(const std::string& file_name) {
+    cv::FileStorage fs(file_name, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "无法打开检测参数文件: " << file_name << std::endl;
+        return false;
     }
-    detection_scale_ = scale;
     
-    cv::Mat scaled_frame;
-    if (scale < 1.0f) {
-        cv::resize(frame, scaled_frame, cv::Size(), scale, scale, cv::INTER_AREA);
-    } else {
-        scaled_frame = frame;
+    int loaded = 0;
+    for (const auto& name : parameterNames()) {
+        cv::FileNode node = fs[name];
+        if (!node.empty()) {
+            setParameter(name, static_cast<double>(node));
+            loaded++;
+        }
     }
+    fs.release();
     
-    cv::Mat processed = preprocessFrame(scaled_frame);
-    cv::Mat color_mask = detectGreenColor(processed);
-    color_mask.copyTo(green_mask_);
+    std::cout << "已加载检测参数: " << file_name << " (" << loaded << " 项)" << std::endl;
+    return true;
+}
+
+bool VisionDetector::saveParameters(const std::string& file_name) const {
+    cv::FileStorage fs(file_name, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cerr << "无法写入检测参数文件: " << file_name << std::endl;
+        return false;
+    }
     
-    cv::Mat detection_mask;
+    for (const auto& name : parameterNames()) {
+        double value = 0.0;
+        getParameter(name, value);
+        fs << name << value;
+    }
+    fs.release();
+    return true;
+}
+
+void VisionDetector::setRenderResults(bool render) {
+    render_results_ = render;
+}
+
+bool VisionDetector::loadPipeline(const std::string& file_name) {
+    auto pipeline = std::make_unique<DetectionPipeline>();
+    if (!pipeline->load(file_name)) {
+        std::cerr << "检测流水线加载失败，继续使用内置检测流程" << std::endl;
+        return false;
+    }
+    pipeline_ = std::move(pipeline);
+    return true;
+}
+
+void VisionDetector::clearPipeline() {
+    pipeline_.reset();
+}
+
+bool VisionDetector::hasPipeline() const {
+    return pipeline_ != nullptr;
+}
+
+const DetectionPipeline* VisionDetector::getPipeline() const {
+    return pipeline_.get();
+}
+
+cv::Mat VisionDetector::detectGreenCircles(const cv::Mat& frame, std::vector<cv::Point2f>& detected_circles) {
+    detected_circles.clear();
     
-    // 🔧 关键修复：为每个case添加大括号，创建独立作用域
-    switch (detection_mode_) {
-        case 0: {
-            cv::Mat bright_core_mask = detectBrightCore(processed);
-            cv::bitwise_and(color_mask, bright_core_mask, detection_mask);
-            break;
-        }
-        case 1: {
-            cv::Mat gradient_mask = detectGradient(processed);
-            cv::bitwise_and(color_mask, gradient_mask, detection_mask);
-            break;
-        }
-        case 2:
-        default: {
-            cv::Mat bright_core_mask = detectBrightCore(processed);
-            cv::Mat gradient_mask = detectGradient(processed);
-            cv::Mat temp;
-            cv::bitwise_or(bright_core_mask, gradient_mask, temp);
-            cv::bitwise_and(color_mask, temp, detection_mask);
-            break;
-        }
+    // 保存原始帧
+    if (render_results_) {
+        frame.copyTo(current_frame_);
     }
     
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(morph_kernel_size_, morph_kernel_size_));
-    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_CLOSE, kernel);
-    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_OPEN, kernel);
-    detection_mask.copyTo(combined_mask_);
+    // 生成检测掩码（根据开关选择 CPU 或 OpenCL(T-API) 路径）
+    cv::Mat detection_mask = computeDetectionMask(frame);
     
     cv::Mat result;
-    frame.copyTo(result);
+    if (render_results_) {
+        frame.copyTo(result);
+    }
     
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(detection_mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
@@ -163,7 +272,9 @@ cv::Mat VisionDetector::detectGreenCircles(const cv::Mat& frame, std::vector<cv:
     }
     
     std::string stats = "检测到 " + std::to_string(detected_count) + " 个绿色圆形灯";
-    cv::putText(result, stats, cv::Point(10, result.rows - 50), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 0), 2);
+    if (render_results_) {
+        cv::putText(result, stats, cv::Point(10, result.rows - 50), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 0), 2);
+    }
     
     return result;
 }
@@ -171,61 +282,22 @@ cv::Mat VisionDetector::detectGreenCircles(const cv::Mat& frame, std::vector<cv:
 cv::Mat VisionDetector::detectGreenCirclesWithResults(const cv::Mat& frame, std::vector<DetectionResult>& results) {
     results.clear();
     
-    // 保存原始帧
-    frame.copyTo(current_frame_);
-    
-    // 对 2448x2048 等高分辨率摄像头进行缩放处理以提高性能
-    float scale = 1.0f;
-    const int max_dim = 1024; // 将较长边缩放到不超过此值
-    int max_side = std::max(frame.cols, frame.rows);
-    if (max_side > max_dim) {
-        scale = static_cast<float>(max_dim) / static_cast<float>(max_side);
-    }
-    detection_scale_ = scale;
-    
-    cv::Mat scaled_frame;
-    if (scale < 1.0f) {
-        cv::resize(frame, scaled_frame, cv::Size(), scale, scale, cv::INTER_AREA);
-    } else {
-        scaled_frame = frame;
+    if (pipeline_) {
+        return detectWithPipeline(frame, results);
     }
     
-    cv::Mat processed = preprocessFrame(scaled_frame);
-    cv::Mat color_mask = detectGreenColor(processed);
-    color_mask.copyTo(green_mask_);
-    
-    cv::Mat detection_mask;
-    
-    // 🔧 关键修复：为每个case添加大括号，创建独立作用域
-    switch (detection_mode_) {
-        case 0: {
-            cv::Mat bright_core_mask = detectBrightCore(processed);
-            cv::bitwise_and(color_mask, bright_core_mask, detection_mask);
-            break;
-        }
-        case 1: {
-            cv::Mat gradient_mask = detectGradient(processed);
-            cv::bitwise_and(color_mask, gradient_mask, detection_mask);
-            break;
-        }
-        case 2:
-        default: {
-            cv::Mat bright_core_mask = detectBrightCore(processed);
-            cv::Mat gradient_mask = detectGradient(processed);
-            cv::Mat temp;
-            cv::bitwise_or(bright_core_mask, gradient_mask, temp);
-            cv::bitwise_and(color_mask, temp, detection_mask);
-            break;
-        }
+    // 保存原始帧
+    if (render_results_) {
+        frame.copyTo(current_frame_);
     }
     
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(morph_kernel_size_, morph_kernel_size_));
-    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_CLOSE, kernel);
-    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_OPEN, kernel);
-    detection_mask.copyTo(combined_mask_);
+    // 生成检测掩码（根据开关选择 CPU 或 OpenCL(T-API) 路径）
+    cv::Mat detection_mask = computeDetectionMask(frame);
     
     cv::Mat result;
-    frame.copyTo(result);
+    if (render_results_) {
+        frame.copyTo(result);
+    }
     
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(detection_mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
@@ -266,9 +338,9 @@ cv::Mat VisionDetector::detectGreenCirclesWithResults(const cv::Mat& frame, std:
         res.circle = cv::Vec3f(center_orig.x, center_orig.y, radius_orig);  // x, y, radius
         res.confidence = circularity;  // 使用圆度作为置信度
         
-        // 使用面积等效直径，更准确地表示目标大小
+        // 使用面积等效直径，更准确地表示目标大小（面积在缩放图上计算，映射回原始帧像素）
         if (area > 0) {
-            float equivalent_radius = sqrt(area / CV_PI);
+            float equivalent_radius = sqrt(area / CV_PI) / detection_scale_;
             res.pixel_diameter = 2.0f * equivalent_radius;
         } else {
             res.pixel_diameter = 2.0f * radius_orig;  // 备用方法
@@ -298,7 +370,45 @@ cv::Mat VisionDetector::detectGreenCirclesWithResults(const cv::Mat& frame, std:
     }
     
     std::string stats = "检测到 " + std::to_string(detected_count) + " 个绿色圆形灯";
-    cv::putText(result, stats, cv::Point(10, result.rows - 50), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 0), 2);
+    if (render_results_) {
+        cv::putText(result, stats, cv::Point(10, result.rows - 50), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 0), 2);
+    }
+    
+    return result;
+}
+
+cv::Mat VisionDetector::detectWithPipeline(const cv::Mat& frame, std::vector<DetectionResult>& results) {
+    if (render_results_) {
+        frame.copyTo(current_frame_);
+    }
+    
+    pipeline_->run(frame, results);
+    green_mask_ = pipeline_->getBuffer("color");
+    combined_mask_ = pipeline_->getBuffer("mask");
+    
+    cv::Mat result;
+    if (render_results_) {
+        frame.copyTo(result);
+    }
+    
+    for (size_t i = 0; i < results.size(); ++i) {
+        const DetectionResult& res = results[i];
+        cv::Point2f center(res.circle[0], res.circle[1]);
+        drawDetectionResult(result, std::vector<cv::Point>(), center, res.circle[2],
+                            res.confidence, 0.0, cv::Point(center));
+        
+        if (show_debug_info_) {
+            std::cout << "✓ 检测到绿色圆形灯 #" << i + 1
+                      << " - 像素直径: " << res.pixel_diameter << "px"
+                      << ", 圆度: " << res.confidence
+                      << ", 中心: (" << center.x << ", " << center.y << ")" << std::endl;
+        }
+    }
+    
+    std::string stats = "检测到 " + std::to_string(results.size()) + " 个绿色圆形灯";
+    if (render_results_) {
+        cv::putText(result, stats, cv::Point(10, result.rows - 50), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 255, 0), 2);
+    }
     
     return result;
 }
@@ -339,19 +449,45 @@ void VisionDetector::saveCurrentFrame(int& frame_counter) {
     }
 }
 
+// 计算缩放因子：对 2448x2048 等高分辨率摄像头进行缩放处理以提高性能
+float VisionDetector::computeDetectionScale(const cv::Mat& frame) const {
+    float scale = 1.0f;
+    const int max_dim = 1024; // 将较长边缩放到不超过此值
+    int max_side = std::max(frame.cols, frame.rows);
+    if (max_side > max_dim) {
+        scale = static_cast<float>(max_dim) / static_cast<float>(max_side);
+    }
+    return scale;
+}
+
+namespace {
+// 将输入帧交给流水线：CPU 路径直接共享数据，T-API 路径上传为 UMat
+inline void uploadFrame(const cv::Mat& src, cv::Mat& dst) { dst = src; }
+inline void uploadFrame(const cv::Mat& src, cv::UMat& dst) { src.copyTo(dst); }
+}
+
 // 优化的预处理函数
-cv::Mat VisionDetector::preprocessFrame(const cv::Mat& frame) {
-    cv::Mat processed;
+template <typename MatT>
+MatT VisionDetector::preprocessFrame(const MatT& frame) {
+    MatT processed;
     cv::GaussianBlur(frame, processed, cv::Size(5, 5), 1.5);
     return processed;
 }
 
-// 亮核检测：检测最亮的区域
-cv::Mat VisionDetector::detectBrightCore(const cv::Mat& frame) {
-    cv::Mat gray, bright_core;
+// 亮度阈值：提取高亮像素（未做形态学处理）
+template <typename MatT>
+MatT VisionDetector::thresholdBrightness(const MatT& frame) {
+    MatT gray, bright_core;
     cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
     cv::GaussianBlur(gray, gray, cv::Size(3, 3), 0.5);
     cv::inRange(gray, brightness_threshold_low_, brightness_threshold_high_, bright_core);
+    return bright_core;
+}
+
+// 亮核检测：检测最亮的区域
+template <typename MatT>
+MatT VisionDetector::detectBrightCore(const MatT& frame) {
+    MatT bright_core = thresholdBrightness(frame);
     
     cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(morph_kernel_size_, morph_kernel_size_));
     cv::morphologyEx(bright_core, bright_core, cv::MORPH_CLOSE, kernel);
@@ -359,8 +495,9 @@ cv::Mat VisionDetector::detectBrightCore(const cv::Mat& frame) {
 }
 
 // 优化的梯度检测
-cv::Mat VisionDetector::detectGradient(const cv::Mat& frame) {
-    cv::Mat gray, gradient, gradient_mask;
+template <typename MatT>
+MatT VisionDetector::detectGradient(const MatT& frame) {
+    MatT gray, gradient, gradient_mask;
     cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
     cv::GaussianBlur(gray, gray, cv::Size(3, 3), 0.5);
     cv::Laplacian(gray, gradient, CV_16S, 3);
@@ -370,13 +507,120 @@ cv::Mat VisionDetector::detectGradient(const cv::Mat& frame) {
 }
 
 // 颜色分割：提取绿色区域
-cv::Mat VisionDetector::detectGreenColor(const cv::Mat& frame) {
-    cv::Mat hsv, color_mask;
+template <typename MatT>
+MatT VisionDetector::detectGreenColor(const MatT& frame) {
+    MatT hsv, color_mask;
     cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
     cv::inRange(hsv, green_lower_, green_upper_, color_mask);
     return color_mask;
 }
 
+// 缩放 -> 模糊 -> 颜色/亮核/梯度掩码 -> 形态学，MatT 为 cv::Mat 或 cv::UMat
+template <typename MatT>
+cv::Mat VisionDetector::buildDetectionMask(const cv::Mat& frame) {
+    MatT input;
+    uploadFrame(frame, input);
+    
+    MatT scaled_frame;
+    if (detection_scale_ < 1.0f) {
+        cv::resize(input, scaled_frame, cv::Size(), detection_scale_, detection_scale_, cv::INTER_AREA);
+    } else {
+        scaled_frame = input;
+    }
+    
+    MatT processed = preprocessFrame(scaled_frame);
+    MatT color_mask = detectGreenColor(processed);
+    color_mask.copyTo(green_mask_);
+    
+    MatT detection_mask;
+    
+    // 🔧 关键修复：为每个case添加大括号，创建独立作用域
+    switch (detection_mode_) {
+        case 0: {
+            MatT bright_core_mask = detectBrightCore(processed);
+            cv::bitwise_and(color_mask, bright_core_mask, detection_mask);
+            break;
+        }
+        case 1: {
+            MatT gradient_mask = detectGradient(processed);
+            cv::bitwise_and(color_mask, gradient_mask, detection_mask);
+            break;
+        }
+        case 2:
+        default: {
+            MatT bright_core_mask = detectBrightCore(processed);
+            MatT gradient_mask = detectGradient(processed);
+            MatT temp;
+            cv::bitwise_or(bright_core_mask, gradient_mask, temp);
+            cv::bitwise_and(color_mask, temp, detection_mask);
+            break;
+        }
+    }
+    
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(morph_kernel_size_, morph_kernel_size_));
+    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_CLOSE, kernel);
+    cv::morphologyEx(detection_mask, detection_mask, cv::MORPH_OPEN, kernel);
+    
+    // UMat 路径在此处下载回主机内存；findContours 不会修改输入掩码
+    detection_mask.copyTo(combined_mask_);
+    return combined_mask_;
+}
+
+// 位压缩路径：亮核闭运算、掩码组合以及最终的闭+开运算都在 1 bit/像素 的掩码上完成
+cv::Mat VisionDetector::buildDetectionMaskPacked(const cv::Mat& frame) {
+    cv::Mat scaled_frame;
+    if (detection_scale_ < 1.0f) {
+        cv::resize(frame, scaled_frame, cv::Size(), detection_scale_, detection_scale_, cv::INTER_AREA);
+    } else {
+        scaled_frame = frame;
+    }
+    
+    cv::Mat processed = preprocessFrame(scaled_frame);
+    cv::Mat color_mask = detectGreenColor(processed);
+    color_mask.copyTo(green_mask_);
+    
+    BitMask::pack(color_mask, packed_mask_);
+    
+    switch (detection_mode_) {
+        case 0: {
+            BitMask::pack(thresholdBrightness(processed), packed_bright_);
+            PackedMorphology::close3x3(packed_bright_, packed_tmp_);
+            packed_mask_.andWith(packed_bright_);
+            break;
+        }
+        case 1: {
+            BitMask::pack(detectGradient(processed), packed_gradient_);
+            packed_mask_.andWith(packed_gradient_);
+            break;
+        }
+        case 2:
+        default: {
+            BitMask::pack(thresholdBrightness(processed), packed_bright_);
+            PackedMorphology::close3x3(packed_bright_, packed_tmp_);
+            BitMask::pack(detectGradient(processed), packed_gradient_);
+            packed_bright_.orWith(packed_gradient_);
+            packed_mask_.andWith(packed_bright_);
+            break;
+        }
+    }
+    
+    PackedMorphology::closeOpen3x3(packed_mask_, packed_tmp_);
+    packed_mask_.unpack(combined_mask_);
+    return combined_mask_;
+}
+
+cv::Mat VisionDetector::computeDetectionMask(const cv::Mat& frame) {
+    detection_scale_ = computeDetectionScale(frame);
+    if (use_opencl_) {
+        return buildDetectionMask<cv::UMat>(frame);
+    }
+    // 位压缩形态学只实现了 3x3 结构元素
+    if (use_packed_morphology_ && morph_kernel_size_ == 3) {
+        return buildDetectionMaskPacked(frame);
+    }
+    return buildDetectionMask<cv::Mat>(frame);
+}
+
 // 计算圆形度
 double VisionDetector::calculateCircularity(const std::vector<cv::Point>& contour) {
     double area = cv::contourArea(contour);
@@ -390,6 +634,8 @@ double VisionDetector::calculateCircularity(const std::vector<cv::Point>& contou
 void VisionDetector::drawDetectionResult(cv::Mat& result, const std::vector<cv::Point>& contour,
                                         const cv::Point2f& center, float radius, 
                                         double circularity, double area, const cv::Point& centroid) {
+    if (!render_results_) return;
+    
     // 使用参数避免编译器警告
     (void)contour;
     (void)circularity;
@@ -5,6 +5,9 @@
 #include <vector>
 #include <string>
 #include "DetectionResult.h"  // 添加头文件
+#include "PackedMorphology.h"
+#include "DetectionPipeline.h"
+#include <memory>
 
 class VisionDetector {
 private:
@@ -46,6 +49,18 @@ private:
     bool show_debug_info_;
     // 缩放因子（用于在高分辨率下缩小输入以加速检测）
     float detection_scale_ = 1.0f;
+    // 是否使用 OpenCL(T-API) 路径处理掩码生成
+    bool use_opencl_ = false;
+    // 是否使用位压缩形态学（仅CPU路径、3x3结构元素）
+    bool use_packed_morphology_ = false;
+    BitMask packed_mask_;
+    BitMask packed_bright_;
+    BitMask packed_gradient_;
+    BitMask packed_tmp_;
+    // 是否绘制结果图并缓存当前帧（批处理时关闭以节省开销）
+    bool render_results_ = true;
+    // 从配置文件加载的检测流水线（为空时使用内置检测流程）
+    std::unique_ptr<DetectionPipeline> pipeline_;
     
 public:
     VisionDetector();
@@ -59,6 +74,36 @@ public:
     // 设置调试信息显示
     void setDebugInfo(bool show);
     
+    // 启用/关闭 OpenCL(T-API) 加速，设备不支持时回退到CPU路径；返回实际生效状态
+    bool setUseOpenCL(bool enable);
+    bool isUsingOpenCL() const;
+    static bool isOpenCLAvailable();
+    
+    // 启用/关闭位压缩形态学（1 bit/像素，结果与 cv::morphologyEx 一致）
+    void setPackedMorphology(bool enable);
+    bool isUsingPackedMorphology() const;
+    
+    // 按名称读写检测参数（供参数文件与参数搜索使用），未知名称返回 false
+    bool setParameter(const std::string& name, double value);
+    bool getParameter(const std::string& name, double& value) const;
+    static const std::vector<std::string>& parameterNames();
+    
+    // 复制另一实例的检测参数与 OpenCL/位压缩开关（双目右相机使用独立实例，运行中调参时逐帧跟随）
+    void copySettingsFrom(const VisionDetector& other);
+    
+    // 从 YAML 加载/保存检测参数（键名同 parameterNames）
+    bool loadParameters(const std::string& file_name);
+    bool saveParameters(const std::string& file_name) const;
+    
+    // 关闭后检测函数返回空结果图，且不缓存当前帧
+    void setRenderResults(bool render);
+    
+    // 加载可配置检测流水线（YAML），加载后 detectGreenCirclesWithResults 改用流水线
+    bool loadPipeline(const std::string& file_name);
+    void clearPipeline();
+    bool hasPipeline() const;
+    const DetectionPipeline* getPipeline() const;
+    
     // 检测绿色圆形并返回检测到的圆形中心
     cv::Mat detectGreenCircles(const cv::Mat& frame, std::vector<cv::Point2f>& detected_circles);
     
@@ -88,17 +133,37 @@ private:
     // 初始化参数
     void init_parameters();
     
+    // 计算缩放因子
+    float computeDetectionScale(const cv::Mat& frame) const;
+    
+    // 生成检测掩码：根据 use_opencl_ 选择 cv::Mat 或 cv::UMat 实例
+    cv::Mat computeDetectionMask(const cv::Mat& frame);
+    template <typename MatT>
+    cv::Mat buildDetectionMask(const cv::Mat& frame);
+    cv::Mat buildDetectionMaskPacked(const cv::Mat& frame);
+    
+    // 使用配置流水线检测并绘制结果
+    cv::Mat detectWithPipeline(const cv::Mat& frame, std::vector<DetectionResult>& results);
+    
     // 优化的预处理函数
-    cv::Mat preprocessFrame(const cv::Mat& frame);
+    template <typename MatT>
+    MatT preprocessFrame(const MatT& frame);
+    
+    // 亮度阈值（不含形态学）
+    template <typename MatT>
+    MatT thresholdBrightness(const MatT& frame);
     
     // 亮核检测：检测最亮的区域
-    cv::Mat detectBrightCore(const cv::Mat& frame);
+    template <typename MatT>
+    MatT detectBrightCore(const MatT& frame);
     
     // 优化的梯度检测
-    cv::Mat detectGradient(const cv::Mat& frame);
+    template <typename MatT>
+    MatT detectGradient(const MatT& frame);
     
     // 颜色分割：提取绿色区域
-    cv::Mat detectGreenColor(const cv::Mat& frame);
+    template <typename MatT>
+    MatT detectGreenColor(const MatT& frame);
     
     // 计算圆形度
     double calculateCircularity(const std::vector<cv::Point>& contour);
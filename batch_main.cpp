@@ -0,0 +1,260 @@
+// 离线批处理工具：对保存的图像目录或视频运行检测，不依赖海康SDK
+#include "BatchDetector.h"
+#include "ParameterSweep.h"
+#include "LatencyCompensator.h"
+#include "StereoRanger.h"
+#include <fstream>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 简单的 "--key value" 参数表
+class ArgList {
+private:
+    std::vector<std::string> args_;
+
+public:
+    ArgList(int argc, char** argv, int first) {
+        for (int i = first; i < argc; ++i) args_.push_back(argv[i]);
+    }
+
+    bool has(const std::string& key) const {
+        for (const auto& a : args_) if (a == key) return true;
+        return false;
+    }
+
+    std::string get(const std::string& key, const std::string& fallback = "") const {
+        for (size_t i = 0; i + 1 < args_.size(); ++i) {
+            if (args_[i] == key) return args_[i + 1];
+        }
+        return fallback;
+    }
+
+    int getInt(const std::string& key, int fallback) const {
+        std::string v = get(key);
+        return v.empty() ? fallback : std::stoi(v);
+    }
+
+    double getDouble(const std::string& key, double fallback) const {
+        std::string v = get(key);
+        return v.empty() ? fallback : std::stod(v);
+    }
+
+    // 第一个不以 "--" 开头且不是参数值的位置参数
+    std::string positional(size_t index) const {
+        size_t found = 0;
+        for (size_t i = 0; i < args_.size(); ++i) {
+            if (args_[i].rfind("--", 0) == 0) { ++i; continue; }
+            if (found++ == index) return args_[i];
+        }
+        return "";
+    }
+};
+
+BatchOptions readBatchOptions(const ArgList& args) {
+    BatchOptions options;
+    options.input = args.positional(0);
+    options.workers = args.getInt("--workers", 1);
+    options.pipeline_path = args.get("--pipeline");
+    options.focal_length = static_cast<float>(args.getDouble("--focal", options.focal_length));
+    options.calibration_path = args.get("--calib");
+    options.frame_interval_ms = args.getDouble("--interval", options.frame_interval_ms);
+    return options;
+}
+
+int runDetect(const ArgList& args) {
+    BatchOptions options = readBatchOptions(args);
+    if (options.input.empty()) {
+        std::cerr << "需要指定图像目录或视频文件" << std::endl;
+        return 1;
+    }
+
+    BatchDetector batch(options);
+    if (!batch.run()) {
+        return 1;
+    }
+    batch.printSummary();
+
+    std::string csv = args.get("--csv");
+    std::string json = args.get("--json");
+    if (csv.empty() && json.empty()) csv = "detections.csv";
+    if (!csv.empty() && !BatchDetector::writeCsv(csv, batch.getRecords())) return 1;
+    if (!json.empty() && !BatchDetector::writeJson(json, batch.getRecords())) return 1;
+    return 0;
+}
+
+int runSweep(const ArgList& args) {
+    std::string labels = args.positional(0);
+    std::string space = args.positional(1);
+    if (labels.empty() || space.empty()) {
+        std::cerr << "需要指定标注文件和搜索空间文件" << std::endl;
+        return 1;
+    }
+
+    SweepOptions options;
+    options.workers = args.getInt("--workers", 1);
+    options.random_samples = args.getInt("--random", 0);
+    options.refine_rounds = args.getInt("--refine", 0);
+    options.seed = static_cast<unsigned int>(args.getInt("--seed", static_cast<int>(options.seed)));
+    options.match_tolerance_px = args.getDouble("--tolerance", options.match_tolerance_px);
+    options.base_params_path = args.get("--base");
+
+    ParameterSweep sweep(options);
+    if (!sweep.loadLabels(labels) || !sweep.loadSearchSpace(space) || !sweep.run()) {
+        return 1;
+    }
+    sweep.printBest();
+
+    if (!sweep.writeReport(args.get("--report", "sweep_report.csv"))) return 1;
+    if (!sweep.writeBestParameters(args.get("--out", "vision_params.yml"))) return 1;
+    return 0;
+}
+
+// 回放评估延迟补偿：输入为 detect 输出的 CSV，或直接给出图像目录/视频
+int runLatency(const ArgList& args) {
+    std::string input = args.positional(0);
+    if (input.empty()) {
+        std::cerr << "需要指定检测结果 CSV 或图像目录/视频" << std::endl;
+        return 1;
+    }
+
+    std::vector<BatchFrameRecord> records;
+    if (input.size() > 4 && input.compare(input.size() - 4, 4, ".csv") == 0) {
+        if (!BatchDetector::readCsv(input, records)) return 1;
+    } else {
+        BatchOptions options = readBatchOptions(args);
+        BatchDetector batch(options);
+        if (!batch.run()) return 1;
+        records = batch.getRecords();
+    }
+
+    std::vector<ReplayFrame> frames;
+    for (const auto& record : records) {
+        if (!record.loaded) continue;
+        frames.push_back({record.timestamp_ms, record.results});
+    }
+    std::cout << "回放帧数: " << frames.size() << std::endl;
+
+    // 评估的延迟列表，逗号分隔
+    std::vector<double> latencies;
+    std::stringstream ss(args.get("--latency", "10,20,40,60,80"));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) latencies.push_back(std::stod(item));
+    }
+    for (double latency : latencies) {
+        LatencyCompensator::printResidual(LatencyCompensator::evaluateReplay(frames, latency));
+    }
+    return 0;
+}
+
+// 真值距离 CSV：每行 "帧序号,距离(米)"，无法解析的行（表头、注释）跳过
+bool readTruthRanges(const std::string& file_name, std::map<int, float>& truth) {
+    std::ifstream in(file_name);
+    if (!in.is_open()) {
+        std::cerr << "无法打开真值文件: " << file_name << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string index, range;
+        if (!std::getline(ss, index, ',') || !std::getline(ss, range, ',')) continue;
+        try {
+            truth[std::stoi(index)] = std::stof(range);
+        } catch (const std::exception&) {
+            continue;
+        }
+    }
+    return true;
+}
+
+// 双目测距回放评估：左右图像目录（或视频）按帧序号配对，与左相机单目测距对比
+int runStereo(const ArgList& args) {
+    std::string left_input = args.positional(0);
+    std::string right_input = args.positional(1);
+    std::string stereo_path = args.get("--stereo", "stereo_params.yml");
+    if (left_input.empty() || right_input.empty()) {
+        std::cerr << "需要指定左右相机的图像目录或视频" << std::endl;
+        return 1;
+    }
+
+    StereoRanger ranger;
+    if (!ranger.loadCalibration(stereo_path)) return 1;
+    ranger.setMatchParameters(static_cast<float>(args.getDouble("--max-epipolar", 3.0)),
+                              static_cast<float>(args.getDouble("--max-size-ratio", 1.5)),
+                              static_cast<float>(args.getDouble("--disparity-noise", 0.3)));
+
+    // 单目距离使用左相机内参（默认取双目标定文件中的 K1/D1）
+    BatchOptions options = readBatchOptions(args);
+    if (options.calibration_path.empty()) options.calibration_path = stereo_path;
+    options.input = left_input;
+    BatchDetector left_batch(options);
+    if (!left_batch.run()) return 1;
+    options.input = right_input;
+    BatchDetector right_batch(options);
+    if (!right_batch.run()) return 1;
+
+    std::map<int, float> truth;
+    std::string truth_path = args.get("--truth");
+    if (!truth_path.empty() && !readTruthRanges(truth_path, truth)) return 1;
+
+    std::map<int, const BatchFrameRecord*> right_by_index;
+    for (const auto& record : right_batch.getRecords()) {
+        if (record.loaded) right_by_index[record.frame_index] = &record;
+    }
+    std::vector<StereoReplayFrame> frames;
+    for (const auto& record : left_batch.getRecords()) {
+        auto right = right_by_index.find(record.frame_index);
+        if (!record.loaded || right == right_by_index.end()) continue;
+        StereoReplayFrame frame;
+        frame.left = record.results;
+        frame.right = right->second->results;
+        auto t = truth.find(record.frame_index);
+        if (t != truth.end()) frame.truth_range = t->second;
+        frames.push_back(frame);
+    }
+
+    StereoRanger::printEvaluation(ranger.evaluateReplay(frames));
+    return 0;
+}
+
+void printUsage() {
+    std::cout << "用法: dart_batch <命令> [参数]" << std::endl;
+    std::cout << "  detect <图像目录|视频> [--workers N] [--csv 输出.csv] [--json 输出.json]" << std::endl;
+    std::cout << "         [--pipeline 流水线.yml] [--focal 焦距px] [--calib 标定.yml] [--interval 帧间隔ms]" << std::endl;
+    std::cout << "  sweep <标注.csv> <搜索空间.yml> [--workers N] [--random 采样数] [--refine 轮数]" << std::endl;
+    std::cout << "        [--seed N] [--tolerance 像素] [--base 初始参数.yml]" << std::endl;
+    std::cout << "        [--report 报告.csv] [--out 最优参数.yml]" << std::endl;
+    std::cout << "  latency <检测结果.csv|图像目录|视频> [--latency 10,20,40] [--interval 帧间隔ms]" << std::endl;
+    std::cout << "  stereo <左图像目录|视频> <右图像目录|视频> [--stereo 双目标定.yml] [--truth 真值.csv]" << std::endl;
+    std::cout << "         [--calib 左相机标定.yml] [--max-epipolar 像素] [--max-size-ratio 比值] [--workers N]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string command = argv[1];
+    ArgList args(argc, argv, 2);
+    try {
+        if (command == "detect") return runDetect(args);
+        if (command == "sweep") return runSweep(args);
+        if (command == "latency") return runLatency(args);
+        if (command == "stereo") return runStereo(args);
+    } catch (const std::exception& e) {
+        std::cerr << "错误发生: " << e.what() << std::endl;
+        return 1;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,1598 @@
+// 离线基准测试工具：不依赖海康SDK，可在工作站或开发板上直接运行
+#include "VisionDetector.h"
+#include "DetectionResult.h"
+#include "PackedMorphology.h"
+#include "Undistorter.h"
+#include "BallisticSolver.h"
+#include "FiringTable.h"
+#include "PidController.h"
+#include "MotorController.h"
+#include "AlignmentController.h"
+#include "PlantSimulator.h"
+#include "TargetTracker.h"
+#include "FrameParser.h"
+#include "FakeMcu.h"
+#include "SerialPort.h"
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// 耗时统计（毫秒）
+struct TimingStats {
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double min_ms = 0.0;
+};
+
+TimingStats summarize(std::vector<double> samples) {
+    TimingStats stats;
+    if (samples.empty()) return stats;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    stats.mean_ms = sum / samples.size();
+    stats.p50_ms = samples[samples.size() / 2];
+    stats.p95_ms = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    stats.min_ms = samples.front();
+    return stats;
+}
+
+// 重复执行 fn，丢弃前 warmup 次（OpenCL 首次调用包含内核编译）
+TimingStats timeIt(const std::function<void()>& fn, int iterations, int warmup = 2) {
+    for (int i = 0; i < warmup; ++i) fn();
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return summarize(samples);
+}
+
+void printStats(const std::string& name, const TimingStats& stats) {
+    std::cout << std::fixed << std::setprecision(3)
+              << std::left << std::setw(20) << name
+              << " 平均: " << stats.mean_ms << "ms"
+              << "  P50: " << stats.p50_ms << "ms"
+              << "  P95: " << stats.p95_ms << "ms"
+              << "  最小: " << stats.min_ms << "ms" << std::endl;
+}
+
+// 生成带若干绿色圆形灯的合成帧（2448x2048，与现场相机分辨率一致）
+cv::Mat makeSyntheticFrame(int width = 2448, int height = 2048) {
+    cv::Mat frame(height, width, CV_8UC3);
+    cv::randu(frame, cv::Scalar(0, 0, 0), cv::Scalar(40, 40, 40));
+    const cv::Point centers[] = {
+        cv::Point(width / 2, height / 2),
+        cv::Point(width / 4, height / 3),
+        cv::Point(width * 3 / 4, height * 2 / 3)
+    };
+    int radius = 18;
+    for (const auto& c : centers) {
+        cv::circle(frame, c, radius, cv::Scalar(60, 220, 60), -1, cv::LINE_AA);
+        cv::circle(frame, c, radius / 2, cv::Scalar(190, 255, 190), -1, cv::LINE_AA);
+        radius += 6;
+    }
+    return frame;
+}
+
+cv::Mat loadFrameOrSynthetic(int argc, char** argv, int index) {
+    if (argc > index) {
+        cv::Mat frame = cv::imread(argv[index]);
+        if (frame.empty()) {
+            std::cerr << "无法读取图像: " << argv[index] << "，改用合成帧" << std::endl;
+        } else {
+            return frame;
+        }
+    }
+    return makeSyntheticFrame();
+}
+
+int intArg(int argc, char** argv, int index, int fallback) {
+    return (argc > index) ? std::max(1, std::atoi(argv[index])) : fallback;
+}
+
+// CPU 与 T-API(UMat) 检测链对比，并校验两条路径掩码一致
+int benchTapi(int argc, char** argv) {
+    cv::Mat frame = loadFrameOrSynthetic(argc, argv, 2);
+    int iterations = intArg(argc, argv, 3, 50);
+    std::cout << "输入尺寸: " << frame.cols << "x" << frame.rows
+              << ", 迭代次数: " << iterations << std::endl;
+
+    VisionDetector cpu_detector;
+    cpu_detector.setUseOpenCL(false);
+    std::vector<DetectionResult> cpu_results;
+    TimingStats cpu_stats = timeIt([&]() {
+        cpu_detector.detectGreenCirclesWithResults(frame, cpu_results);
+    }, iterations);
+    printStats("CPU (cv::Mat)", cpu_stats);
+    cv::Mat cpu_mask = cpu_detector.getCombinedMask().clone();
+
+    VisionDetector ocl_detector;
+    if (!VisionDetector::isOpenCLAvailable()) {
+        std::cout << "未检测到 OpenCL 设备，T-API 路径将由 OpenCV 回退到CPU执行" << std::endl;
+    } else {
+        std::cout << "OpenCL 设备: " << cv::ocl::Device::getDefault().name() << std::endl;
+    }
+    ocl_detector.setUseOpenCL(true);
+    std::vector<DetectionResult> ocl_results;
+    TimingStats ocl_stats = timeIt([&]() {
+        ocl_detector.detectGreenCirclesWithResults(frame, ocl_results);
+    }, iterations);
+    printStats(ocl_detector.isUsingOpenCL() ? "T-API (cv::UMat)" : "T-API (回退CPU)", ocl_stats);
+    cv::Mat ocl_mask = ocl_detector.getCombinedMask();
+
+    if (ocl_stats.mean_ms > 0) {
+        std::cout << "加速比: " << cpu_stats.mean_ms / ocl_stats.mean_ms << "x" << std::endl;
+    }
+
+    // OpenCL 内核的舍入方式与CPU略有差异，阈值边缘允许少量像素不同
+    cv::Mat diff;
+    cv::bitwise_xor(cpu_mask, ocl_mask, diff);
+    int mismatch = cv::countNonZero(diff);
+    double mismatch_ratio = static_cast<double>(mismatch) / std::max<size_t>(1, cpu_mask.total());
+    std::cout << "掩码差异像素: " << mismatch << " (" << mismatch_ratio * 100.0 << "%)"
+              << ", 检测目标数 CPU=" << cpu_results.size()
+              << " T-API=" << ocl_results.size() << std::endl;
+
+    if (mismatch_ratio > 0.001 || cpu_results.size() != ocl_results.size()) {
+        std::cerr << "❌ CPU 与 T-API 路径结果不一致" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ 两条路径结果一致" << std::endl;
+    return 0;
+}
+
+// 位压缩融合形态学 与 cv::morphologyEx 的闭+开运算对比
+int benchMorph(int argc, char** argv) {
+    cv::Mat frame = loadFrameOrSynthetic(argc, argv, 2);
+    int iterations = intArg(argc, argv, 3, 200);
+
+    // 以检测器缩放后的颜色掩码为输入，并叠加椒盐噪声覆盖孤立点/小孔的情况
+    VisionDetector detector;
+    std::vector<DetectionResult> results;
+    detector.detectGreenCirclesWithResults(frame, results);
+    cv::Mat mask = detector.getGreenMask().clone();
+    cv::Mat noise(mask.size(), CV_8UC1);
+    cv::randu(noise, cv::Scalar(0), cv::Scalar(256));
+    mask.setTo(cv::Scalar(255), noise > 250);
+    std::cout << "掩码尺寸: " << mask.cols << "x" << mask.rows
+              << ", 迭代次数: " << iterations << std::endl;
+
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3));
+    cv::Mat cv_out;
+    TimingStats cv_stats = timeIt([&]() {
+        cv::morphologyEx(mask, cv_out, cv::MORPH_CLOSE, kernel);
+        cv::morphologyEx(cv_out, cv_out, cv::MORPH_OPEN, kernel);
+    }, iterations);
+    printStats("cv::morphologyEx", cv_stats);
+
+    BitMask packed, tmp;
+    cv::Mat packed_out;
+    TimingStats full_stats = timeIt([&]() {
+        BitMask::pack(mask, packed);
+        PackedMorphology::closeOpen3x3(packed, tmp);
+        packed.unpack(packed_out);
+    }, iterations);
+    printStats("位压缩(含压缩/解压)", full_stats);
+
+    BitMask::pack(mask, packed);
+    BitMask work;
+    TimingStats core_stats = timeIt([&]() {
+        work = packed;
+        PackedMorphology::closeOpen3x3(work, tmp);
+    }, iterations);
+    printStats("位压缩(仅形态学)", core_stats);
+
+    if (full_stats.mean_ms > 0) {
+        std::cout << "加速比(含压缩/解压): " << cv_stats.mean_ms / full_stats.mean_ms << "x" << std::endl;
+    }
+
+    cv::Mat diff;
+    cv::bitwise_xor(cv_out, packed_out, diff);
+    int mismatch = cv::countNonZero(diff);
+    if (mismatch != 0) {
+        std::cerr << "❌ 位压缩结果与 cv::morphologyEx 不一致，差异像素: " << mismatch << std::endl;
+        return 1;
+    }
+    std::cout << "✅ 位压缩结果与 cv::morphologyEx 完全一致" << std::endl;
+    return 0;
+}
+
+// 可配置流水线逐阶段计时，并与内置检测流程对比结果数量
+int benchPipeline(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "需要指定流水线配置文件" << std::endl;
+        return 1;
+    }
+    cv::Mat frame = loadFrameOrSynthetic(argc, argv, 3);
+    int iterations = intArg(argc, argv, 4, 50);
+
+    VisionDetector builtin_detector;
+    std::vector<DetectionResult> builtin_results;
+    TimingStats builtin_stats = timeIt([&]() {
+        builtin_detector.detectGreenCirclesWithResults(frame, builtin_results);
+    }, iterations);
+    printStats("内置检测流程", builtin_stats);
+
+    VisionDetector pipeline_detector;
+    if (!pipeline_detector.loadPipeline(argv[2])) {
+        return 1;
+    }
+    std::vector<DetectionResult> pipeline_results;
+    TimingStats pipeline_stats = timeIt([&]() {
+        pipeline_detector.detectGreenCirclesWithResults(frame, pipeline_results);
+    }, iterations, 0);
+    printStats("配置流水线", pipeline_stats);
+    pipeline_detector.getPipeline()->printTimings();
+
+    std::cout << "检测目标数: 内置=" << builtin_results.size()
+              << " 流水线=" << pipeline_results.size() << std::endl;
+    return 0;
+}
+
+// 缓存校正查找表 与 每次调用 cv::undistort / cv::undistortPoints 对比
+int benchUndistort(int argc, char** argv) {
+    cv::Mat frame = loadFrameOrSynthetic(argc, argv, 3);
+    int iterations = intArg(argc, argv, 4, 20);
+
+    // 没有标定文件时使用典型的桶形畸变参数
+    cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << 4968.4, 0, frame.cols / 2.0, 0, 4968.4, frame.rows / 2.0, 0, 0, 1);
+    cv::Mat dist_coeffs = (cv::Mat_<double>(5, 1) << -0.12, 0.08, 0.0005, -0.0004, 0.0);
+    if (argc > 2 && std::string(argv[2]) != "-") {
+        cv::FileStorage fs(argv[2], cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            std::cerr << "无法打开标定参数文件: " << argv[2] << std::endl;
+            return 1;
+        }
+        fs["cameraMatrix"] >> camera_matrix;
+        fs["distCoeffs"] >> dist_coeffs;
+    }
+
+    cv::Mat reference;
+    TimingStats undistort_stats = timeIt([&]() {
+        cv::undistort(frame, reference, camera_matrix, dist_coeffs);
+    }, iterations);
+    printStats("cv::undistort(每次重算表)", undistort_stats);
+
+    // 冷启动生成并写缓存，之后的实例直接 mmap
+    const std::string cache_file = "bench_undistort.bin";
+    std::remove(cache_file.c_str());
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Undistorter cold;
+    cold.init(camera_matrix, dist_coeffs, frame.size(), cache_file);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    Undistorter undistorter;
+    undistorter.init(camera_matrix, dist_coeffs, frame.size(), cache_file);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::cout << std::fixed << std::setprecision(3)
+              << "初始化: 生成+写缓存 " << std::chrono::duration<double, std::milli>(t1 - t0).count() << "ms, "
+              << "mmap 缓存 " << std::chrono::duration<double, std::milli>(t2 - t1).count() << "ms"
+              << (undistorter.isMapped() ? "" : " (未映射!)") << std::endl;
+
+    cv::Mat remapped;
+    TimingStats remap_stats = timeIt([&]() { undistorter.remap(frame, remapped); }, iterations);
+    printStats("缓存定点表 remap", remap_stats);
+
+    cv::Rect roi(frame.cols / 2 - 128, frame.rows / 2 - 128, 256, 256);
+    cv::Mat roi_out;
+    TimingStats roi_stats = timeIt([&]() { undistorter.remapRoi(frame, roi, roi_out); }, iterations * 10);
+    printStats("ROI 256x256 remap", roi_stats);
+
+    // 检测点：网格插值 与 逐点迭代求解
+    std::vector<cv::Point2f> pixels(10000);
+    cv::RNG rng(7);
+    for (auto& p : pixels) {
+        p = cv::Point2f(rng.uniform(0.0f, static_cast<float>(frame.cols - 1)),
+                        rng.uniform(0.0f, static_cast<float>(frame.rows - 1)));
+    }
+    std::vector<cv::Point2f> exact, gridded;
+    TimingStats exact_stats = timeIt([&]() { cv::undistortPoints(pixels, exact, camera_matrix, dist_coeffs); }, iterations);
+    printStats("cv::undistortPoints x10000", exact_stats);
+    TimingStats grid_stats = timeIt([&]() { undistorter.normalizePoints(pixels, gridded); }, iterations);
+    printStats("网格插值 x10000", grid_stats);
+
+    int failures = 0;
+    double max_point_error_px = 0.0;
+    double fx = camera_matrix.at<double>(0, 0);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        max_point_error_px = std::max(max_point_error_px, cv::norm(exact[i] - gridded[i]) * fx);
+    }
+    std::cout << "网格插值最大误差: " << max_point_error_px << "px" << std::endl;
+    if (max_point_error_px > 0.05) {
+        std::cerr << "❌ 网格插值误差超过 0.05px" << std::endl;
+        failures++;
+    }
+
+    cv::Mat diff;
+    cv::absdiff(reference, remapped, diff);
+    double mean_diff = cv::mean(diff)[0];
+    std::cout << "定点表与 cv::undistort 平均差异: " << mean_diff << " 灰度级" << std::endl;
+    if (mean_diff > 1.0) {
+        std::cerr << "❌ 定点表校正结果与 cv::undistort 差异过大" << std::endl;
+        failures++;
+    }
+    cv::absdiff(remapped(roi), roi_out, diff);
+    if (cv::countNonZero(diff.reshape(1)) != 0) {
+        std::cerr << "❌ ROI 校正结果与整幅校正不一致" << std::endl;
+        failures++;
+    }
+
+    std::remove(cache_file.c_str());
+    if (failures == 0) {
+        std::cout << "✅ 缓存校正结果一致" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 弹道查找表 与 逐次迭代求解 对比：耗时和仰角误差
+int benchBallistic(int argc, char** argv) {
+    BallisticSolver solver;
+    if (argc > 2 && std::string(argv[2]) != "-" && !solver.loadParams(argv[2])) {
+        return 1;
+    }
+    int iterations = intArg(argc, argv, 3, 20);
+    solver.buildTable();
+    solver.printTableSummary();
+
+    // 查找表覆盖范围内、高度偏离 ±1m 的随机目标
+    const BallisticParams& params = solver.getParams();
+    std::vector<cv::Point2f> targets(200);
+    cv::RNG rng(11);
+    for (auto& t : targets) {
+        t = cv::Point2f(rng.uniform(params.table_min_range, params.table_max_range),
+                        params.nominal_height + rng.uniform(-1.0f, 1.0f));
+    }
+
+    std::vector<FiringSolution> table_results(targets.size());
+    TimingStats table_stats = timeIt([&]() {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            table_results[i] = solver.solveRangeHeight(targets[i].x, targets[i].y);
+        }
+    }, iterations * 100);
+    printStats("查找表 x200", table_stats);
+
+    std::vector<float> exact_pitch(targets.size());
+    std::vector<char> exact_valid(targets.size());
+    TimingStats exact_stats = timeIt([&]() {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            float time;
+            exact_valid[i] = solver.solvePitch(targets[i].x, targets[i].y, exact_pitch[i], time);
+        }
+    }, iterations, 0);
+    printStats("迭代求解 x200", exact_stats);
+
+    int compared = 0, mismatched = 0;
+    double max_error_deg = 0.0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (table_results[i].valid != static_cast<bool>(exact_valid[i])) {
+            mismatched++;
+            continue;
+        }
+        if (!exact_valid[i]) continue;
+        compared++;
+        max_error_deg = std::max(max_error_deg, std::fabs(table_results[i].pitch - exact_pitch[i]) * 180.0 / CV_PI);
+    }
+    std::cout << "对比 " << compared << " 个可达目标, 查表仰角最大误差: " << max_error_deg << "°" << std::endl;
+
+    int failures = 0;
+    if (mismatched > 0) {
+        std::cerr << "❌ " << mismatched << " 个目标的可达性判断与迭代求解不一致" << std::endl;
+        failures++;
+    }
+    if (max_error_deg > 0.1) {
+        std::cerr << "❌ 查表仰角误差超过 0.1°" << std::endl;
+        failures++;
+    }
+    if (failures == 0) {
+        std::cout << "✅ 查找表结果与迭代求解一致" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 二维射表：单线程/多线程生成、mmap 加载耗时，以及与迭代求解的误差
+int benchFiringTable(int argc, char** argv) {
+    BallisticSolver solver;
+    if (argc > 2 && std::string(argv[2]) != "-" && !solver.loadParams(argv[2])) {
+        return 1;
+    }
+    int threads = intArg(argc, argv, 3, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+
+    const std::string cache_file = "bench_firing_table.bin";
+    std::remove(cache_file.c_str());
+    auto t0 = std::chrono::high_resolution_clock::now();
+    FiringTable single;
+    single.init(solver, "", 1);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    FiringTable parallel;
+    parallel.init(solver, cache_file, threads);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    FiringTable mapped;
+    mapped.init(solver, cache_file);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    std::cout << std::fixed << std::setprecision(3)
+              << "生成: 单线程 " << std::chrono::duration<double, std::milli>(t1 - t0).count() << "ms, "
+              << threads << " 线程+写缓存 " << std::chrono::duration<double, std::milli>(t2 - t1).count() << "ms, "
+              << "mmap 加载 " << std::chrono::duration<double, std::micro>(t3 - t2).count() << "us"
+              << (mapped.isMapped() ? "" : " (未映射!)") << std::endl;
+
+    // 射表范围内的随机目标：对比迭代求解
+    const BallisticParams& params = solver.getParams();
+    std::vector<cv::Point2f> targets(500);
+    cv::RNG rng(13);
+    for (auto& t : targets) {
+        t = cv::Point2f(rng.uniform(params.table_min_range, params.table_max_range),
+                        rng.uniform(params.table_min_height, params.table_max_height));
+    }
+    std::vector<float> pitch(targets.size()), time(targets.size());
+    std::vector<char> valid(targets.size());
+    TimingStats lookup_stats = timeIt([&]() {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            valid[i] = mapped.lookup(targets[i].x, targets[i].y, pitch[i], time[i]);
+        }
+    }, 1000);
+    printStats("射表查询 x500", lookup_stats);
+
+    int failures = 0, hits = 0;
+    double max_error_deg = 0.0, max_time_error = 0.0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (!valid[i]) continue;
+        hits++;
+        float exact_pitch, exact_time;
+        if (!solver.solvePitch(targets[i].x, targets[i].y, exact_pitch, exact_time)) {
+            failures++;
+            continue;
+        }
+        max_error_deg = std::max(max_error_deg, std::fabs(pitch[i] - exact_pitch) * 180.0 / CV_PI);
+        max_time_error = std::max(max_time_error, static_cast<double>(std::fabs(time[i] - exact_time)));
+    }
+    std::cout << "射表命中 " << hits << "/" << targets.size() << ", 仰角最大误差 " << max_error_deg
+              << "°, 飞行时间最大误差 " << max_time_error << "s" << std::endl;
+    if (failures > 0) {
+        std::cerr << "❌ " << failures << " 个射表表项对应的目标实际不可达" << std::endl;
+    }
+    if (max_error_deg > 0.1) {
+        std::cerr << "❌ 射表仰角误差超过 0.1°" << std::endl;
+        failures++;
+    }
+
+    std::remove(cache_file.c_str());
+    if (failures == 0) {
+        std::cout << "✅ 射表结果与迭代求解一致" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 阶跃/斜坡响应仿真：电机角速度一阶滞后 + 指令传输延迟，视觉按帧率采样并带延迟和噪声
+struct AxisSimConfig {
+    double plant_tau_s = 0.03;        // 电机速度响应时间常数
+    double command_delay_s = 0.02;    // 指令发出到电机开始响应
+    double vision_period_s = 1.0 / 60.0;
+    double vision_delay_s = 0.01;     // 曝光到检测结果可用
+    double noise_rad = 1e-4;          // 检测噪声（1σ）
+    double control_period_s = 0.005;  // 控制线程 200Hz
+    double duration_s = 2.0;
+};
+
+struct AxisSimResult {
+    double overshoot = 0.0;           // 相对阶跃幅值
+    double settle_s = -1.0;           // 误差进入并保持在 settle_band 内的时刻，-1 表示未稳定
+    double final_error = 0.0;         // 最后 0.2s 平均误差（弧度）
+    double rms_error = 0.0;           // 0.5s 之后的误差均方根
+    int command_changes = 0;          // 指令变化次数
+};
+
+// target(t) 为目标角度；controller(error, relative_rate, dt) 返回角速度指令
+AxisSimResult simulateAxis(const AxisSimConfig& config, const std::function<double(double)>& target,
+                           const std::function<double(double, double, double)>& controller,
+                           double step_size, double settle_band) {
+    const double dt = 1e-4;
+    double angle = 0.0, rate = 0.0, command = 0.0, last_command = 0.0;
+    double measured_error = 0.0, measured_rate = 0.0, last_sample_error = 0.0;
+    bool has_sample = false;
+    double next_vision = 0.0, next_control = 0.0;
+    std::deque<std::pair<double, double>> command_queue;       // (生效时刻, 指令)
+    std::deque<std::pair<double, double>> measurement_queue;   // (可用时刻, 误差)
+    cv::RNG rng(5);
+    AxisSimResult result;
+    double peak = 0.0, sum_sq = 0.0, final_sum = 0.0;
+    int rms_samples = 0, final_samples = 0;
+    double last_outside = 0.0;
+
+    for (double t = 0.0; t < config.duration_s; t += dt) {
+        if (t >= next_vision) {
+            double error = target(t) - angle + rng.gaussian(config.noise_rad);
+            measurement_queue.emplace_back(t + config.vision_delay_s, error);
+            next_vision += config.vision_period_s;
+        }
+        while (!measurement_queue.empty() && measurement_queue.front().first <= t) {
+            // 相邻两次观测差分近似跟踪器给出的相对速度
+            if (has_sample) {
+                measured_rate = (measurement_queue.front().second - last_sample_error) / config.vision_period_s;
+            }
+            has_sample = true;
+            last_sample_error = measurement_queue.front().second;
+            measured_error = last_sample_error;
+            measurement_queue.pop_front();
+        }
+        if (t >= next_control) {
+            double output = controller(measured_error, measured_rate, config.control_period_s);
+            if (output != last_command) result.command_changes++;
+            last_command = output;
+            command_queue.emplace_back(t + config.command_delay_s, output);
+            next_control += config.control_period_s;
+        }
+        while (!command_queue.empty() && command_queue.front().first <= t) {
+            command = command_queue.front().second;
+            command_queue.pop_front();
+        }
+        rate += (command - rate) * dt / config.plant_tau_s;
+        angle += rate * dt;
+
+        double error = target(t) - angle;
+        if (step_size != 0.0) peak = std::max(peak, -error / step_size);
+        if (std::fabs(error) > settle_band) last_outside = t;
+        if (t >= 0.5) {
+            sum_sq += error * error;
+            rms_samples++;
+        }
+        if (t >= config.duration_s - 0.2) {
+            final_sum += error;
+            final_samples++;
+        }
+    }
+    result.overshoot = peak;
+    result.settle_s = (last_outside < config.duration_s - 0.2) ? last_outside : -1.0;
+    result.rms_error = rms_samples > 0 ? std::sqrt(sum_sq / rms_samples) : 0.0;
+    result.final_error = final_samples > 0 ? final_sum / final_samples : 0.0;
+    return result;
+}
+
+// PID/前馈控制器与原 5 档分档在同一仿真对象上的阶跃和斜坡响应
+int benchPid(int argc, char** argv) {
+    PidGains gains;
+    if (argc > 2 && std::string(argv[2]) != "-") {
+        cv::FileStorage fs(argv[2], cv::FileStorage::READ);
+        if (!fs.isOpened() || !PidController::readGains(fs["pid"], gains)) {
+            std::cerr << "无法读取 PID 参数: " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    AxisSimConfig config;
+    const double step = 0.02;           // 20 mrad 阶跃
+    const double ramp_rate = 0.03;      // 30 mrad/s 匀速目标
+    const float band = MotorController::defaultAngularSpeedBands().thresholds[0];
+
+    auto pidController = [](const PidGains& g) {
+        auto pid = std::make_shared<PidController>();
+        pid->setGains(g);
+        return [pid](double error, double relative_rate, double dt) {
+            return static_cast<double>(pid->update(static_cast<float>(error), static_cast<float>(relative_rate),
+                                                   static_cast<float>(dt)));
+        };
+    };
+    // 原分档：死区内停止，档位 n 输出 n/5 满速
+    auto ladderController = [&gains](double error, double, double) {
+        const AngularSpeedBands bands = MotorController::defaultAngularSpeedBands();
+        int level = 5;
+        for (int i = 0; i < 5; ++i) {
+            if (std::fabs(error) < bands.thresholds[i]) {
+                level = i;
+                break;
+            }
+        }
+        return (error > 0 ? 1.0 : -1.0) * level / 5.0 * gains.max_rate;
+    };
+    PidGains no_ff = gains;
+    no_ff.kff = 0.0f;
+
+    // 阶跃为捕获过程：目标出现时已偏离 step（跟踪器对跳变会重新建轨，不会给出冲击速度）
+    auto stepTarget = [step](double) { return step; };
+    auto rampTarget = [ramp_rate](double t) { return ramp_rate * t; };
+
+    struct Row { const char* name; AxisSimResult step; AxisSimResult ramp; };
+    std::vector<Row> rows = {
+        {"PID+前馈", simulateAxis(config, stepTarget, pidController(gains), step, band),
+                     simulateAxis(config, rampTarget, pidController(gains), 0.0, band)},
+        {"PID(无前馈)", simulateAxis(config, stepTarget, pidController(no_ff), step, band),
+                        simulateAxis(config, rampTarget, pidController(no_ff), 0.0, band)},
+        {"5档分档", simulateAxis(config, stepTarget, ladderController, step, band),
+                    simulateAxis(config, rampTarget, ladderController, 0.0, band)},
+    };
+
+    std::cout << "PID: kp=" << gains.kp << " ki=" << gains.ki << " kd=" << gains.kd << " kff=" << gains.kff
+              << " 限幅 " << gains.max_rate * 1000.0f << "mrad/s, 加速度限制 " << gains.max_accel * 1000.0f
+              << "mrad/s^2" << std::endl;
+    std::cout << "仿真对象: 速度时间常数 " << config.plant_tau_s * 1000.0 << "ms, 指令延迟 "
+              << config.command_delay_s * 1000.0 << "ms, 视觉 " << 1.0 / config.vision_period_s << "fps 延迟 "
+              << config.vision_delay_s * 1000.0 << "ms, 稳定带 ±" << band * 1000.0f << "mrad" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& row : rows) {
+        std::cout << std::left << std::setw(16) << row.name
+                  << " 阶跃: 超调 " << row.step.overshoot * 100.0 << "%, 稳定时间 "
+                  << (row.step.settle_s >= 0 ? std::to_string(static_cast<int>(row.step.settle_s * 1000.0)) + "ms" : "未稳定")
+                  << ", 稳态误差 " << row.step.final_error * 1000.0 << "mrad, 指令变化 " << row.step.command_changes
+                  << " | 斜坡: RMS " << row.ramp.rms_error * 1000.0 << "mrad, 末段误差 "
+                  << row.ramp.final_error * 1000.0 << "mrad" << std::endl;
+    }
+
+    const AxisSimResult& pid_step = rows[0].step;
+    int failures = 0;
+    if (pid_step.settle_s < 0 || pid_step.settle_s > 0.7) {
+        std::cerr << "❌ PID 阶跃响应未在 700ms 内稳定" << std::endl;
+        failures++;
+    }
+    if (pid_step.overshoot > 0.25) {
+        std::cerr << "❌ PID 阶跃超调超过 25%" << std::endl;
+        failures++;
+    }
+    if (rows[0].ramp.rms_error >= rows[2].ramp.rms_error) {
+        std::cerr << "❌ PID 跟踪匀速目标的误差不小于分档控制" << std::endl;
+        failures++;
+    }
+    if (failures == 0) {
+        std::cout << "✅ PID 阶跃响应满足要求" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 闭环仿真结果：误差为相机实际朝向相对期望方向的误差
+struct ClosedLoopResult {
+    double settle_s = -1.0;       // 误差最后一次超出对准阈值的时刻，-1 表示结束时仍未稳定
+    double overshoot = 0.0;       // 相对阶跃幅值
+    double rms_error = 0.0;       // 1s 之后的误差均方根（弧度）
+    double first_aligned_s = -1.0;
+    double command_rate_hz = 0.0; // 下位机收到的指令帧频率
+    long rejected_bytes = 0;
+    long acks = 0;                // 协议 v2：下位机回复的 ACK
+    double wall_ms = 0.0;
+};
+
+// AlignmentController -> SerialPort 字节 -> PlantSimulator -> 合成目标像素位置 -> TargetTracker -> AlignmentController
+// 视觉 60fps（延迟 10ms），控制 200Hz，全部按仿真时钟推进。
+// protocol 为 2 时下位机回复 ACK 与遥测，在每个控制周期前交给控制器
+ClosedLoopResult runClosedLoop(const PlantConfig& plant_config, bool continuous,
+                               const std::function<double(double)>& target_angle, double step_size, double duration,
+                               int protocol = 1) {
+    auto wall_start = std::chrono::steady_clock::now();
+    double sim_time = 0.0;
+    PlantSimulator plant(plant_config);
+    AlignmentController controller;
+    double cx = (plant_config.image_size.width - 1) * 0.5;
+    double cy = (plant_config.image_size.height - 1) * 0.5;
+    cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << plant_config.focal_px, 0, cx,
+                                                        0, plant_config.focal_px, cy,
+                                                        0, 0, 1);
+    controller.setIntrinsics(camera_matrix, cv::Mat(), plant_config.image_size);
+    controller.setContinuousControl(continuous);
+    controller.setSerialProtocol(protocol);
+    controller.connectSimulated([&plant, &sim_time](const uint8_t* data, size_t size) { plant.feed(data, size, sim_time); },
+                                [&sim_time]() { return sim_time * 1000.0; });
+    controller.toggleAutoAlign();
+
+    const double offset = MotorController::defaultAngularSpeedBands().target_offset;
+    const double band = MotorController::defaultAngularSpeedBands().thresholds[0];
+    const double vision_period = 1.0 / 60.0, vision_delay = 0.01, control_period = 0.005;
+    TargetTracker tracker;
+    struct Capture { double ready; double time; cv::Point2f center; };
+    std::deque<Capture> captures;
+    double next_capture = 0.0, next_control = 0.0;
+    double peak = 0.0, last_outside = 0.0, sum_sq = 0.0;
+    int rms_samples = 0;
+    ClosedLoopResult result;
+
+    while (true) {
+        double t = std::min(next_capture, next_control);
+        bool deliver = !captures.empty() && captures.front().ready <= t;
+        if (deliver) t = captures.front().ready;
+        if (t > duration) break;
+        sim_time = t;
+        plant.advanceTo(t);
+
+        if (deliver) {
+            DetectionResult detection;
+            detection.circle = cv::Vec3f(captures.front().center.x, captures.front().center.y, 20.0f);
+            detection.pixel_diameter = 40.0f;
+            detection.confidence = 1.0;
+            tracker.update(std::vector<DetectionResult>(1, detection), captures.front().time * 1000.0);
+            captures.pop_front();
+        } else if (t == next_capture) {
+            captures.push_back({t + vision_delay, t, plant.observe(target_angle(t))});
+            next_capture += vision_period;
+        } else {
+            std::vector<uint8_t> reply = plant.takeOutput();
+            if (!reply.empty()) {
+                controller.receiveSimulated(reply.data(), reply.size());
+            }
+            if (tracker.hasTrack()) {
+                // 与控制线程相同：外推到指令生效时刻
+                cv::Point2f center = tracker.predictCenter(t * 1000.0 + plant_config.command_delay * 1000.0);
+                controller.setTargetVelocity(tracker.getVelocity());
+                controller.performAlignment(center, plant_config.image_size);
+            }
+            if (controller.isAligned() && result.first_aligned_s < 0) result.first_aligned_s = t;
+            double error = target_angle(t) - offset - plant.getCameraAngle();
+            if (step_size != 0.0) peak = std::max(peak, -error / step_size);
+            if (std::fabs(error) > band) last_outside = t;
+            if (t >= 1.0) {
+                sum_sq += error * error;
+                rms_samples++;
+            }
+            next_control += control_period;
+        }
+    }
+    result.settle_s = (last_outside < duration - 0.3) ? last_outside : -1.0;
+    result.overshoot = peak;
+    result.rms_error = rms_samples > 0 ? std::sqrt(sum_sq / rms_samples) : 0.0;
+    result.command_rate_hz = plant.getFrameCount() / duration;
+    result.rejected_bytes = plant.getRejectedBytes();
+    result.acks = plant.getAckCount();
+    result.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
+// 无硬件闭环测试：PID 连续控制与 5 档分档在一阶/二阶（含齿隙）仿真对象上的阶跃捕获与匀速跟踪
+int benchPlant(int argc, char** argv) {
+    double duration = (argc > 2) ? std::max(1.0, std::atof(argv[2])) : 3.0;
+    PlantConfig first_order;
+    PlantConfig second_order;
+    second_order.order = 2;
+    second_order.backlash = 0.001;
+    const double offset = MotorController::defaultAngularSpeedBands().target_offset;
+    auto step = [offset](double) { return offset + 0.02; };
+    auto ramp = [offset](double t) { return offset + 0.01 + 0.03 * t; };
+
+    struct Case { const char* name; PlantConfig plant; bool continuous; bool is_step; int protocol; ClosedLoopResult result; };
+    std::vector<Case> cases = {
+        {"PID 一阶 阶跃", first_order, true, true, 1, {}},
+        {"PID 一阶 匀速", first_order, true, false, 1, {}},
+        {"PID 二阶 阶跃", second_order, true, true, 1, {}},
+        {"PID 二阶 匀速", second_order, true, false, 1, {}},
+        {"PID 二阶 阶跃 v2", second_order, true, true, 2, {}},
+        {"PID 二阶 匀速 v2", second_order, true, false, 2, {}},
+        {"分档 一阶 阶跃", first_order, false, true, 1, {}},
+        {"分档 一阶 匀速", first_order, false, false, 1, {}},
+    };
+    for (auto& c : cases) {
+        c.result = c.is_step ? runClosedLoop(c.plant, c.continuous, step, 0.02, duration, c.protocol)
+                             : runClosedLoop(c.plant, c.continuous, ramp, 0.0, duration, c.protocol);
+    }
+
+    std::cout << "\n闭环仿真 " << duration << "s: 阶跃 20mrad / 匀速 30mrad/s，视觉 60fps，控制 200Hz" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    int failures = 0;
+    for (const auto& c : cases) {
+        const ClosedLoopResult& r = c.result;
+        std::cout << std::left << std::setw(18) << c.name
+                  << " 稳定 " << (r.settle_s >= 0 ? std::to_string(static_cast<int>(r.settle_s * 1000.0)) + "ms" : "未稳定")
+                  << ", 超调 " << r.overshoot * 100.0 << "%, RMS " << r.rms_error * 1000.0 << "mrad"
+                  << ", 首次对准 " << (r.first_aligned_s >= 0 ? std::to_string(static_cast<int>(r.first_aligned_s * 1000.0)) + "ms" : "无")
+                  << ", 指令 " << r.command_rate_hz << "帧/s, 仿真/实时 " << duration * 1000.0 / std::max(r.wall_ms, 1e-3)
+                  << "x" << std::endl;
+        if (r.rejected_bytes > 0) {
+            std::cerr << "❌ " << c.name << ": 下位机解析失败 " << r.rejected_bytes << " 字节" << std::endl;
+            failures++;
+        }
+        if (c.protocol == 2 && r.acks < static_cast<long>(r.command_rate_hz * duration)) {
+            std::cerr << "❌ " << c.name << ": " << r.acks << " 个 ACK 少于指令帧数" << std::endl;
+            failures++;
+        }
+        if (!c.continuous) continue;
+        if (c.is_step && (r.settle_s < 0 || r.settle_s > 1.0 || r.overshoot > 0.3)) {
+            std::cerr << "❌ " << c.name << ": 1s 内未稳定或超调超过 30%" << std::endl;
+            failures++;
+        }
+        if (!c.is_step && r.rms_error > 1e-3) {
+            std::cerr << "❌ " << c.name << ": 跟踪误差 RMS 超过 1mrad" << std::endl;
+            failures++;
+        }
+    }
+    if (failures == 0) {
+        std::cout << "✅ 闭环仿真满足要求" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// ============ 串口帧解析：性质测试与吞吐量 ============
+
+// 解析出的一帧，逐字段与发送端比较
+struct ParsedFrame {
+    int kind = 0;          // 1 档位 2 速度 3 停止 4 ACK 5 遥测 6 未知 7 看门狗
+    int seq = -1;
+    int64_t a = 0, b = 0, c = 0;
+    bool operator==(const ParsedFrame& other) const {
+        return kind == other.kind && seq == other.seq && a == other.a && b == other.b && c == other.c;
+    }
+};
+
+class RecordingHandler : public FrameParser::Handler {
+public:
+    std::vector<ParsedFrame> frames;
+    void onLevel(int seq, int8_t level) override { frames.push_back({1, seq, level, 0, 0}); }
+    void onSpeed(int seq, int16_t speed) override { frames.push_back({2, seq, speed, 0, 0}); }
+    void onStop(int seq) override { frames.push_back({3, seq, 0, 0, 0}); }
+    void onAck(uint8_t seq, uint8_t acked_seq, uint8_t status) override { frames.push_back({4, seq, acked_seq, status, 0}); }
+    void onTelemetry(uint8_t seq, const MotorTelemetry& t) override {
+        frames.push_back({5, seq, t.mcu_time_ms, std::llround(t.position * 1e6), std::llround(t.velocity * 1e6) * 256 + t.flags});
+    }
+    void onUnknown(uint8_t type, uint8_t seq, const uint8_t*, size_t size) override {
+        frames.push_back({6, seq, type, static_cast<int64_t>(size), 0});
+    }
+    void onWatchdog(uint8_t seq, uint16_t timeout_ms) override { frames.push_back({7, seq, timeout_ms, 0, 0}); }
+};
+
+// 随机生成一帧（v1 / v2 各类型），写入 out 并返回帧长，expected 为解析应得的结果
+size_t randomFrame(cv::RNG& rng, uint8_t* out, ParsedFrame& expected) {
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t seq = static_cast<uint8_t>(rng.uniform(0, 256));
+    int kind = rng.uniform(0, 9);
+    switch (kind) {
+        case 0: {   // v1 档位帧
+            int8_t level = static_cast<int8_t>(rng.uniform(-5, 6));
+            out[0] = FRAME_START; out[1] = FRAME_HEADER_V1_LEVEL; out[2] = static_cast<uint8_t>(level);
+            out[3] = FRAME_END_0; out[4] = FRAME_END_1;
+            expected = {1, -1, level, 0, 0};
+            return V1_LEVEL_FRAME_SIZE;
+        }
+        case 1: {   // v1 速度帧
+            int16_t speed = static_cast<int16_t>(rng.uniform(-SPEED_FRAME_FULL_SCALE, SPEED_FRAME_FULL_SCALE + 1));
+            out[0] = FRAME_START; out[1] = FRAME_HEADER_V1_SPEED; writeLe16(out + 2, static_cast<uint16_t>(speed));
+            out[4] = FRAME_END_0; out[5] = FRAME_END_1;
+            expected = {2, -1, speed, 0, 0};
+            return V1_SPEED_FRAME_SIZE;
+        }
+        case 2: {
+            int16_t speed = static_cast<int16_t>(rng.uniform(-32768, 32768));
+            writeLe16(payload, static_cast<uint16_t>(speed));
+            expected = {2, seq, speed, 0, 0};
+            return encodeFrame(MessageType::SPEED, seq, payload, 2, out);
+        }
+        case 3: {
+            int8_t level = static_cast<int8_t>(rng.uniform(-128, 128));
+            payload[0] = static_cast<uint8_t>(level);
+            expected = {1, seq, level, 0, 0};
+            return encodeFrame(MessageType::LEVEL, seq, payload, 1, out);
+        }
+        case 4:
+            expected = {3, seq, 0, 0, 0};
+            return encodeFrame(MessageType::STOP, seq, nullptr, 0, out);
+        case 5: {
+            payload[0] = static_cast<uint8_t>(rng.uniform(0, 256));
+            payload[1] = static_cast<uint8_t>(rng.uniform(0, 2));
+            expected = {4, seq, payload[0], payload[1], 0};
+            return encodeFrame(MessageType::ACK, seq, payload, 2, out);
+        }
+        case 6: {
+            MotorTelemetry t;
+            t.mcu_time_ms = static_cast<uint32_t>(rng.uniform(0, 1 << 30));
+            t.position = rng.uniform(-3000000, 3000000) * 1e-6;
+            t.velocity = rng.uniform(-500000, 500000) * 1e-6;
+            t.flags = static_cast<uint8_t>(rng.uniform(0, 8));
+            size_t size = encodeTelemetry(t, payload);
+            expected = {5, seq, t.mcu_time_ms, std::llround(t.position * 1e6), std::llround(t.velocity * 1e6) * 256 + t.flags};
+            return encodeFrame(MessageType::TELEMETRY, seq, payload, size, out);
+        }
+        case 7: {
+            uint16_t timeout_ms = static_cast<uint16_t>(rng.uniform(0, 65536));
+            writeLe16(payload, timeout_ms);
+            expected = {7, seq, timeout_ms, 0, 0};
+            return encodeFrame(MessageType::WATCHDOG, seq, payload, 2, out);
+        }
+        default: {  // 未来版本的扩展类型：校验通过，交给 onUnknown
+            uint8_t type = static_cast<uint8_t>(rng.uniform(0x20, 0x80));
+            size_t size = static_cast<size_t>(rng.uniform(0, static_cast<int>(FRAME_MAX_PAYLOAD) + 1));
+            for (size_t i = 0; i < size; ++i) payload[i] = static_cast<uint8_t>(rng.uniform(0, 256));
+            expected = {6, seq, type, static_cast<int64_t>(size), 0};
+            return encodeFrame(static_cast<MessageType>(type), seq, payload, size, out);
+        }
+    }
+}
+
+struct StreamCase {
+    std::vector<uint8_t> bytes;
+    std::vector<ParsedFrame> expected;
+    std::vector<bool> intact;   // 该帧的字节未被破坏
+};
+
+// count 帧随机帧；noise 为帧间插入随机字节的最大个数（一半以 0xAA 开头制造假帧头）；
+// corrupt_rate 为每个字节被改写、删除或重复的概率
+StreamCase makeStream(cv::RNG& rng, int count, int noise, double corrupt_rate) {
+    StreamCase stream;
+    uint8_t frame[FRAME_MAX_SIZE];
+    for (int i = 0; i < count; ++i) {
+        if (noise > 0) {
+            int gap = rng.uniform(0, noise + 1);
+            for (int k = 0; k < gap; ++k) {
+                stream.bytes.push_back(k == 0 && rng.uniform(0, 2) ? FRAME_START : static_cast<uint8_t>(rng.uniform(0, 256)));
+            }
+        }
+        ParsedFrame expected;
+        size_t size = randomFrame(rng, frame, expected);
+        bool intact = true;
+        for (size_t k = 0; k < size; ++k) {
+            if (corrupt_rate > 0 && rng.uniform(0.0, 1.0) < corrupt_rate) {
+                intact = false;
+                int op = rng.uniform(0, 3);
+                if (op == 0) stream.bytes.push_back(static_cast<uint8_t>(frame[k] ^ rng.uniform(1, 256)));
+                if (op == 2) { stream.bytes.push_back(frame[k]); stream.bytes.push_back(frame[k]); }
+                continue;   // op == 1：删除该字节
+            }
+            stream.bytes.push_back(frame[k]);
+        }
+        stream.expected.push_back(expected);
+        stream.intact.push_back(intact);
+    }
+    return stream;
+}
+
+struct MatchResult {
+    long recovered = 0;
+    long missed_intact = 0;   // 字节完好却没有解析出来的帧
+    long spurious = 0;        // 与发送序列对不上的帧（损坏的 v1 帧没有校验，或噪声碰巧组成合法帧）
+};
+
+// 解析结果应按顺序包含发送序列：贪心对齐，允许损坏造成的缺帧
+MatchResult matchFrames(const StreamCase& stream, const std::vector<ParsedFrame>& parsed) {
+    MatchResult result;
+    std::vector<bool> found(stream.expected.size(), false);
+    size_t cursor = 0;
+    for (const ParsedFrame& frame : parsed) {
+        size_t end = std::min(stream.expected.size(), cursor + 8);
+        size_t k = cursor;
+        while (k < end && !(stream.expected[k] == frame)) ++k;
+        if (k < end) {
+            found[k] = true;
+            cursor = k + 1;
+            result.recovered++;
+        } else {
+            result.spurious++;
+        }
+    }
+    for (size_t k = 0; k < found.size(); ++k) {
+        if (!found[k] && stream.intact[k]) result.missed_intact++;
+    }
+    return result;
+}
+
+// 按随机块长喂入（模拟 read() 每次返回的字节数不定）
+std::vector<ParsedFrame> parseInChunks(cv::RNG& rng, const std::vector<uint8_t>& bytes, int max_chunk,
+                                       FrameParserStats& stats, size_t& pending) {
+    RecordingHandler handler;
+    FrameParser parser(handler);
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        size_t chunk = std::min(bytes.size() - pos, static_cast<size_t>(rng.uniform(1, max_chunk + 1)));
+        parser.feed(bytes.data() + pos, chunk);
+        pos += chunk;
+    }
+    stats = parser.getStats();
+    pending = parser.getPendingBytes();
+    return handler.frames;
+}
+
+// 流式帧解析器：无损流逐帧一致、噪声与损坏下的重同步、字节守恒、分块无关性，以及 921600bps 线速的吞吐余量
+int benchParser(int argc, char** argv) {
+    int count = (argc > 2) ? std::max(1000, std::atoi(argv[2])) : 200000;
+    uint64_t seed = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 17;
+    cv::RNG rng(seed);
+    int failures = 0;
+    auto check = [&failures](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cerr << "❌ " << what << std::endl;
+            failures++;
+        }
+    };
+
+    std::cout << "帧解析性质测试: " << count << " 帧/场景, 随机种子 " << seed << std::endl;
+    struct Scenario { const char* name; int noise; double corrupt_rate; };
+    const Scenario scenarios[] = {
+        {"无损", 0, 0.0},
+        {"帧间噪声", 8, 0.0},
+        {"字节损坏 0.2%", 0, 0.002},
+        {"噪声+损坏 1%", 8, 0.01},
+    };
+    for (const Scenario& scenario : scenarios) {
+        StreamCase stream = makeStream(rng, count, scenario.noise, scenario.corrupt_rate);
+        FrameParserStats stats;
+        size_t pending = 0;
+        std::vector<ParsedFrame> parsed = parseInChunks(rng, stream.bytes, 64, stats, pending);
+        MatchResult match = matchFrames(stream, parsed);
+        long intact = static_cast<long>(std::count(stream.intact.begin(), stream.intact.end(), true));
+        std::cout << std::left << std::setw(16) << scenario.name << " 字节 " << stream.bytes.size()
+                  << ", 完好帧 " << intact << ", 解析 " << parsed.size() << " (对上 " << match.recovered
+                  << ", 多余 " << match.spurious << ", 漏掉完好帧 " << match.missed_intact << "), 校验错 "
+                  << stats.crc_errors << ", 格式错 " << stats.framing_errors << ", 丢弃 " << stats.dropped_bytes << " 字节"
+                  << std::endl;
+
+        // 字节守恒：每个输入字节要么属于合法帧，要么被丢弃，要么是末尾未完成的帧
+        check(stats.frame_bytes + stats.dropped_bytes + pending == stream.bytes.size(),
+              std::string(scenario.name) + ": 字节数不守恒");
+        if (scenario.noise == 0 && scenario.corrupt_rate == 0.0) {
+            check(parsed == stream.expected && stats.dropped_bytes == 0 && pending == 0,
+                  std::string(scenario.name) + ": 解析结果与发送序列不一致");
+        } else {
+            // 完好的帧只有在被一个碰巧合法的假帧吞掉时才会丢失，每个假帧最多覆盖 3 个最短帧
+            check(match.missed_intact <= 3 * match.spurious,
+                  std::string(scenario.name) + ": 重同步后仍丢失完好帧");
+        }
+
+        // 分块无关：逐字节喂入与整块喂入结果完全相同
+        FrameParserStats whole_stats;
+        size_t whole_pending = 0;
+        RecordingHandler whole;
+        FrameParser whole_parser(whole);
+        whole_parser.feed(stream.bytes.data(), stream.bytes.size());
+        whole_stats = whole_parser.getStats();
+        whole_pending = whole_parser.getPendingBytes();
+        check(whole.frames == parsed && whole_stats.dropped_bytes == stats.dropped_bytes && whole_pending == pending,
+              std::string(scenario.name) + ": 结果依赖分块方式");
+    }
+
+    // 纯随机字节：不崩溃、字节守恒，统计碰巧组成合法帧的比例
+    {
+        std::vector<uint8_t> garbage(static_cast<size_t>(count) * 16);
+        for (uint8_t& byte : garbage) byte = static_cast<uint8_t>(rng.uniform(0, 256));
+        FrameParserStats stats;
+        size_t pending = 0;
+        std::vector<ParsedFrame> parsed = parseInChunks(rng, garbage, 256, stats, pending);
+        std::cout << std::left << std::setw(16) << "随机字节" << " 字节 " << garbage.size() << ", 误识别 "
+                  << parsed.size() << " 帧 (v1 " << stats.legacy_frames << ", v2 " << stats.frames << ")" << std::endl;
+        check(stats.frame_bytes + stats.dropped_bytes + pending == garbage.size(), "随机字节: 字节数不守恒");
+    }
+
+    // 吞吐量：与 921600bps（8N1 每字节 10 位，92160 字节/秒）线速比较
+    {
+        StreamCase stream = makeStream(rng, count, 2, 0.0);
+        RecordingHandler handler;
+        handler.frames.reserve(stream.expected.size());
+        FrameParser parser(handler);
+        const double line_rate = 921600.0 / 10.0;
+        int repeats = 0;
+        double elapsed_s = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while (elapsed_s < 0.5 || repeats < 3) {
+            handler.frames.clear();
+            parser.feed(stream.bytes.data(), stream.bytes.size());
+            repeats++;
+            elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        double bytes_per_s = static_cast<double>(stream.bytes.size()) * repeats / elapsed_s;
+        double frames_per_s = static_cast<double>(stream.expected.size()) * repeats / elapsed_s;
+        std::cout << "吞吐量: " << bytes_per_s / 1e6 << " MB/s, " << frames_per_s / 1e6 << " M帧/s, "
+                  << 1e9 / bytes_per_s << " ns/字节, 为 921600bps 线速的 " << bytes_per_s / line_rate << " 倍" << std::endl;
+        check(bytes_per_s > 10.0 * line_rate, "解析吞吐量不足 921600bps 线速的 10 倍");
+    }
+
+    if (failures == 0) {
+        std::cout << "✅ 帧解析器满足全部性质" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// ============ 伪终端假下位机：端到端串口测试 ============
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+// 经伪终端驱动真实的 SerialPort/MotorController：各波特率下 v2 速度指令从提交到收到 ACK 的往返时间，
+// 以及 v1 固定帧全部送达。假下位机按波特率模拟线路传输时间
+int benchLoopback(int argc, char** argv) {
+    int count = (argc > 2) ? std::max(10, std::atoi(argv[2])) : 200;
+    // 2000000 为非标准波特率，经 termios2/BOTHER 设置
+    const int bauds[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 2000000};
+    // 速度指令帧 12 字节 + ACK 帧 12 字节
+    const double round_trip_bytes = (FRAME_OVERHEAD + 2) * 2.0;
+    int failures = 0;
+
+    std::cout << "伪终端往返测试: 每个波特率 " << count << " 条 v2 速度指令，逐条等待 ACK" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int baud : bauds) {
+        FakeMcu mcu;
+        if (!mcu.open()) return 1;
+        MotorController motor;
+        motor.setCommandLogging(false);
+        motor.setProtocolVersion(2);
+        if (!motor.connect(mcu.getSlavePath(), baud)) return 1;
+
+        std::vector<double> rtts;
+        int lost = 0;
+        for (int i = 0; i < count; ++i) {
+            unsigned long acked = motor.getSerialStats().acked;
+            auto start = std::chrono::steady_clock::now();
+            motor.sendSpeedCommand(((i % 21) - 10) * 0.05f);
+            double elapsed_ms = 0.0;
+            while (motor.getSerialStats().acked == acked && elapsed_ms < 500.0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+                elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            if (elapsed_ms >= 500.0) {
+                lost++;
+            } else {
+                rtts.push_back(elapsed_ms);
+            }
+        }
+        motor.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        SerialReceiveStats received = motor.getReceiveStats();
+        FakeMcuStats mcu_stats = mcu.getStats();
+        motor.disconnect();
+        mcu.close();
+
+        double wire_ms = round_trip_bytes * 10.0 * 1000.0 / baud;
+        std::cout << std::right << std::setw(7) << baud << "bps  往返 p50/p90/p99/最大 " << percentile(rtts, 0.5) << "/"
+                  << percentile(rtts, 0.9) << "/" << percentile(rtts, 0.99) << "/" << percentile(rtts, 1.0)
+                  << "ms (线路 " << wire_ms << "ms), 丢失 " << lost << ", 遥测 " << received.telemetry
+                  << " 帧, 下位机丢弃 " << mcu_stats.rejected_bytes << " 字节" << std::endl;
+        if (lost > 0 || mcu_stats.rejected_bytes > 0 || received.invalid_frames > 0) {
+            std::cerr << "❌ " << baud << "bps: 指令丢失或帧损坏" << std::endl;
+            failures++;
+        }
+        if (mcu_stats.line_baud != baud) {
+            std::cerr << "❌ " << baud << "bps: 下位机看到的波特率为 " << mcu_stats.line_baud << std::endl;
+            failures++;
+        }
+    }
+
+    // 协议 v1：无 ACK，按下位机收到的指令数核对
+    {
+        FakeMcu mcu;
+        if (!mcu.open()) return 1;
+        MotorController motor;
+        motor.setCommandLogging(false);
+        if (!motor.connect(mcu.getSlavePath(), 115200)) return 1;
+        for (int i = 0; i < count; ++i) {
+            motor.sendAngularError((i % 2 ? 1.0f : -1.0f) * 0.01f * (i % 7));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        SerialWriteStats written = motor.getSerialStats();
+        FakeMcuStats mcu_stats = mcu.getStats();
+        motor.disconnect();   // 断开前发送的停止帧也计入
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        long received = mcu.getStats().commands;
+        mcu.close();
+        std::cout << "v1 115200bps: 写出 " << written.written << " 帧 (合并 " << written.coalesced << "), 下位机收到 "
+                  << mcu_stats.commands << " 帧, 断开后 " << received << std::endl;
+        if (mcu_stats.commands != static_cast<long>(written.written) || mcu_stats.rejected_bytes > 0) {
+            std::cerr << "❌ v1: 写出与收到的帧数不一致" << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "✅ 伪终端端到端测试通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 模拟 USB 转串口拔出再插入：关闭假下位机的伪终端，主机检测到断开后在同一路径重建，
+// 检查自动重连的耗时、断开期间指令被丢弃、重连后第一条指令为停止且控制随后恢复
+int benchHotplug(int argc, char** argv) {
+    int cycles = intArg(argc, argv, 2, 5);
+    // 重试周期 100ms 加调度余量：伪终端目录不产生 inotify 事件，只能靠周期重试发现
+    const double reconnect_bound_ms = 250.0;
+    auto waitFor = [](const std::function<bool()>& done, double timeout_ms) {
+        auto start = std::chrono::steady_clock::now();
+        double elapsed_ms = 0.0;
+        while (!done() && elapsed_ms < timeout_ms) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        return done() ? elapsed_ms : -1.0;
+    };
+
+    std::unique_ptr<FakeMcu> mcu(new FakeMcu());
+    if (!mcu->open()) return 1;
+    const std::string port = mcu->getSlavePath();
+    MotorController motor;
+    motor.setCommandLogging(false);
+    motor.setProtocolVersion(2);
+    if (!motor.connect(port, 115200)) return 1;
+
+    int failures = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        motor.sendSpeedCommand(0.5f);
+        if (waitFor([&]() { return mcu->getStats().commanded_rate != 0.0; }, 200.0) < 0) {
+            std::cerr << "❌ 第 " << cycle + 1 << " 次: 下位机未执行速度指令" << std::endl;
+            return 1;
+        }
+
+        // 拔出：主机侧必须关闭设备，伪终端编号才会释放给重建的下位机
+        mcu->close();
+        double detect_ms = waitFor([&]() { return !motor.isConnected(); }, 1000.0);
+        unsigned long dropped = motor.getLinkStats().dropped_commands;
+        for (int i = 0; i < 10; ++i) {
+            motor.sendSpeedCommand(0.8f);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        dropped = motor.getLinkStats().dropped_commands - dropped;
+
+        // 插入
+        mcu.reset(new FakeMcu());
+        if (!mcu->open()) return 1;
+        if (mcu->getSlavePath() != port) {
+            std::cerr << "❌ 伪终端编号变化 (" << mcu->getSlavePath() << " != " << port << ")，无法模拟同一设备" << std::endl;
+            return 1;
+        }
+        double reconnect_ms = waitFor([&]() { return motor.isConnected(); }, 1000.0);
+        waitFor([&]() { return mcu->getStats().acks > 0; }, 100.0);
+        FakeMcuStats after = mcu->getStats();
+        SerialLinkStats link = motor.getLinkStats();
+
+        motor.sendSpeedCommand(0.3f);
+        bool resumed = waitFor([&]() { return mcu->getStats().commanded_rate > 0.0; }, 200.0) >= 0;
+
+        std::cout << "第 " << cycle + 1 << " 次: 检测断开 " << detect_ms << "ms, 设备出现到恢复 " << reconnect_ms
+                  << "ms, 中断 " << link.last_outage_ms << "ms, 断开期间丢弃 " << dropped << " 条, 重连后首批指令 "
+                  << after.commands << " 条 (转速 " << after.commanded_rate << "), 控制" << (resumed ? "已恢复" : "未恢复")
+                  << std::endl;
+        if (detect_ms < 0 || reconnect_ms < 0 || reconnect_ms > reconnect_bound_ms) {
+            std::cerr << "❌ 断开检测或重连超时" << std::endl;
+            failures++;
+        }
+        if (dropped != 10 || after.commands != 1 || after.commanded_rate != 0.0 || !resumed) {
+            std::cerr << "❌ 重连后第一条指令应为停止，断开期间的指令不应送达" << std::endl;
+            failures++;
+        }
+    }
+    SerialLinkStats link = motor.getLinkStats();
+    motor.disconnect();
+    mcu->close();
+    std::cout << "断开 " << link.disconnects << " 次, 重连 " << link.reconnects << " 次, 最大中断 "
+              << link.max_outage_ms << "ms" << std::endl;
+    if (link.disconnects != static_cast<unsigned long>(cycles) || link.reconnects != static_cast<unsigned long>(cycles)) {
+        failures++;
+    }
+    if (failures == 0) {
+        std::cout << "✅ 串口热插拔自动重连测试通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 指令调度：恒定指令下去重 + 保活与逐帧发送的串口流量对比；控制线程停止发送后下位机看门狗停止电机，
+// 新指令到达后恢复
+int benchKeepalive(int argc, char** argv) {
+    double duration = (argc > 2) ? std::max(0.5, std::atof(argv[2])) : 1.0;
+    const double rate_hz = 200.0;
+    const int ticks = static_cast<int>(duration * rate_hz);
+    CommandSchedule schedule;
+    int failures = 0;
+    std::cout << std::fixed << std::setprecision(1);
+
+    // 与 5 档分档相同的恒定误差：每个控制周期提交同一档位
+    for (bool deduplicate : {false, true}) {
+        FakeMcu mcu;
+        if (!mcu.open()) return 1;
+        MotorController motor;
+        motor.setCommandLogging(false);
+        motor.setProtocolVersion(2);
+        CommandSchedule current = schedule;
+        current.deduplicate = deduplicate;
+        motor.setCommandSchedule(current);
+        if (!motor.connect(mcu.getSlavePath(), 115200)) return 1;
+
+        const float error = motor.getAngularSpeedBands().target_offset + motor.getAngularSpeedBands().thresholds[2];
+        auto start = std::chrono::steady_clock::now();
+        auto period = std::chrono::microseconds(static_cast<long>(1e6 / rate_hz));
+        for (int i = 0; i < ticks; ++i) {
+            motor.sendAngularError(error);
+            std::this_thread::sleep_until(start + period * (i + 1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CommandStats commands = motor.getCommandStats();
+        FakeMcuStats moving = mcu.getStats();
+        std::cout << (deduplicate ? "去重 + 保活 " : "逐帧发送   ") << ": 提交 " << commands.requested << ", 发送 "
+                  << commands.sent << " (保活 " << commands.keepalives << "), 下位机收到 " << moving.commands
+                  << " 条指令 / " << moving.bytes_in << " 字节, 看门狗触发 " << moving.watchdog_trips << std::endl;
+        if (moving.watchdog_trips > 0 || moving.commanded_rate == 0.0) {
+            std::cerr << "❌ 指令不变期间下位机看门狗不应触发" << std::endl;
+            failures++;
+        }
+        if (deduplicate) {
+            long expected = 1 + static_cast<long>(duration * 1000.0 / schedule.keepalive_ms);
+            if (std::labs(static_cast<long>(commands.sent) - expected) > 2) {
+                std::cerr << "❌ 保活发送 " << commands.sent << " 条，预期约 " << expected << " 条" << std::endl;
+                failures++;
+            }
+
+            // 控制线程卡住：不再提交任何指令，下位机应在看门狗超时后停止电机
+            auto silent = std::chrono::steady_clock::now();
+            double stopped_ms = -1.0;
+            while (stopped_ms < 0.0) {
+                double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - silent).count();
+                if (mcu.getStats().commanded_rate == 0.0) {
+                    stopped_ms = elapsed_ms;
+                } else if (elapsed_ms > 3.0 * schedule.mcu_watchdog_ms) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            MotorTelemetry telemetry;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            bool flagged = motor.getTelemetry(telemetry) && (telemetry.flags & TELEMETRY_WATCHDOG);
+            // 新指令恢复运动并清除标志
+            motor.sendAngularError(-error);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            bool resumed = mcu.getStats().commanded_rate < 0.0;
+            bool cleared = motor.getTelemetry(telemetry) && !(telemetry.flags & TELEMETRY_WATCHDOG);
+            std::cout << "停止提交指令后 " << stopped_ms << "ms 下位机看门狗停止电机 (超时 " << schedule.mcu_watchdog_ms
+                      << "ms, 从最后一次发送算起), 遥测标志" << (flagged ? "已置位" : "未置位") << ", 新指令后"
+                      << (resumed && cleared ? "恢复运动" : "未恢复") << std::endl;
+            if (stopped_ms < 0.0 || stopped_ms > schedule.mcu_watchdog_ms + 50.0 || !flagged || !resumed || !cleared) {
+                std::cerr << "❌ 下位机看门狗未按预期停止 / 恢复" << std::endl;
+                failures++;
+            }
+        }
+        motor.disconnect();
+        mcu.close();
+    }
+    if (failures == 0) {
+        std::cout << "✅ 指令去重、保活与下位机看门狗测试通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// 在伪终端上运行假下位机，供主程序连接：DART_SERIAL_PORT=<从机端> DART_SERIAL_PROTOCOL=2
+int runFakeMcu(int argc, char** argv) {
+    double duration = (argc > 2) ? std::atof(argv[2]) : 0.0;
+    FakeMcu mcu;
+    if (!mcu.open()) return 1;
+    std::cout << "假下位机已启动: " << mcu.getSlavePath() << std::endl;
+    std::cout << "主程序连接: DART_SERIAL_PORT=" << mcu.getSlavePath() << " DART_SERIAL_PROTOCOL=2" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    while (duration <= 0.0 ||
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < duration) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        FakeMcuStats stats = mcu.getStats();
+        std::cout << "波特率 " << stats.line_baud << ", 收 " << stats.bytes_in << " 字节 / 发 " << stats.bytes_out
+                  << " 字节, 指令 " << stats.commands << ", ACK " << stats.acks << ", 丢弃 " << stats.rejected_bytes
+                  << ", 跳过遥测 " << stats.telemetry_skipped
+                  << ", 转台 " << mcu.getCameraAngle() * 1000.0 << "mrad" << std::endl;
+    }
+    return 0;
+}
+
+// ============ 串口低延迟配置：写出到环回读回的延迟 ============
+
+// 伪终端回显：主机端收到的字节原样写回，模拟 TX-RX 短接（没有线路时间）
+class PtyEcho {
+public:
+    ~PtyEcho() { close(); }
+
+    bool open() {
+        master_fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        char name[128];
+        if (master_fd_ < 0 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0 ||
+            ptsname_r(master_fd_, name, sizeof(name)) != 0) {
+            std::cerr << "无法创建伪终端: " << strerror(errno) << std::endl;
+            return false;
+        }
+        slave_path_ = name;
+        running_ = true;
+        thread_ = std::thread([this]() {
+            uint8_t buffer[256];
+            while (running_) {
+                struct pollfd pfd;
+                pfd.fd = master_fd_;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                if (poll(&pfd, 1, 20) <= 0) continue;
+                ssize_t n = read(master_fd_, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    // 从机端尚未打开或已关闭时读到 EIO
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                for (ssize_t offset = 0; offset < n;) {
+                    ssize_t written = write(master_fd_, buffer + offset, n - offset);
+                    if (written > 0) offset += written;
+                    else if (errno != EAGAIN && errno != EINTR) break;
+                }
+            }
+        });
+        return true;
+    }
+
+    void close() {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (master_fd_ >= 0) ::close(master_fd_);
+        master_fd_ = -1;
+    }
+
+    const std::string& getSlavePath() const { return slave_path_; }
+
+private:
+    int master_fd_ = -1;
+    std::string slave_path_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+// 写出一帧后等待同样的字节从环回读回，返回毫秒；超时或内容不符返回 -1
+double measureLoopback(int fd, const uint8_t* frame, size_t size, int timeout_ms) {
+    uint8_t received[FRAME_MAX_SIZE];
+    size_t got = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < size;) {
+        ssize_t n = write(fd, frame + offset, size - offset);
+        if (n > 0) offset += static_cast<size_t>(n);
+        else if (errno != EAGAIN && errno != EINTR) return -1.0;
+    }
+    while (got < size) {
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed_ms > timeout_ms) return -1.0;
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, std::max(1, timeout_ms - static_cast<int>(elapsed_ms))) <= 0) continue;
+        ssize_t n = read(fd, received + got, size - got);
+        if (n > 0) got += static_cast<size_t>(n);
+    }
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return std::memcmp(received, frame, size) == 0 ? elapsed_ms : -1.0;
+}
+
+// 默认配置与低延迟配置（ASYNC_LOW_LATENCY + 1ms latency_timer）下，一帧 v2 速度指令从 write() 到经
+// TX-RX 短接读回的延迟分位数。设备为 "-" 时使用伪终端回显，只能验证流程，不反映 USB 转串口的攒包延迟
+int benchLatency(int argc, char** argv) {
+    std::string device = (argc > 2) ? argv[2] : "-";
+    int baud = (argc > 3) ? std::atoi(argv[3]) : 115200;
+    int count = (argc > 4) ? std::max(10, std::atoi(argv[4])) : 500;
+    const int timeout_ms = 200;
+
+    PtyEcho echo;
+    if (device == "-") {
+        if (!echo.open()) return 1;
+        device = echo.getSlavePath();
+        std::cout << "使用伪终端回显 " << device << "（无线路时间与 USB 攒包，仅验证流程）" << std::endl;
+    } else {
+        std::cout << "设备 " << device << " 需要短接 TX 与 RX" << std::endl;
+    }
+
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t payload[2];
+    cv::RNG rng(3);
+    const size_t frame_size = FRAME_OVERHEAD + sizeof(payload);
+    const double wire_ms = frame_size * 10.0 * 1000.0 / baud;
+    int failures = 0;
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (bool low_latency : {false, true}) {
+        SerialLatencyProfile profile;
+        profile.low_latency = low_latency;
+        int fd = open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0) {
+            std::cerr << "无法打开串口设备 " << device << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+        SerialTuningReport report;
+        std::string error;
+        if (!SerialPort::configureTty(fd, device, baud, profile, report, error)) {
+            std::cerr << error << std::endl;
+            close(fd);
+            return 1;
+        }
+        if (!low_latency) {
+            // 关闭上次运行可能留下的低延迟标志，作为对照组
+            std::string ignored;
+            setAsyncLowLatency(fd, false, ignored);
+        }
+
+        std::vector<double> latencies;
+        int lost = 0;
+        for (int i = 0; i < count; ++i) {
+            writeLe16(payload, static_cast<uint16_t>(rng.uniform(-SPEED_FRAME_FULL_SCALE, SPEED_FRAME_FULL_SCALE)));
+            encodeFrame(MessageType::SPEED, static_cast<uint8_t>(i), payload, sizeof(payload), frame);
+            double latency_ms = measureLoopback(fd, frame, frame_size, timeout_ms);
+            if (latency_ms < 0) {
+                lost++;
+                tcflush(fd, TCIOFLUSH);
+            } else {
+                latencies.push_back(latency_ms);
+            }
+            // 随机间隔，避免与 USB 轮询周期锁相
+            std::this_thread::sleep_for(std::chrono::microseconds(rng.uniform(0, 2000)));
+        }
+        close(fd);
+
+        std::cout << (low_latency ? "低延迟" : "默认  ") << "  " << report.actual_baud << "bps"
+                  << (report.custom_baud ? " (termios2)" : "") << "  p50/p90/p99/最大 " << percentile(latencies, 0.5)
+                  << "/" << percentile(latencies, 0.9) << "/" << percentile(latencies, 0.99) << "/"
+                  << percentile(latencies, 1.0) << "ms (线路 " << wire_ms << "ms), 丢失 " << lost << std::endl;
+        if (low_latency) {
+            std::cout << "        ASYNC_LOW_LATENCY " << (report.async_low_latency ? "开" : "不支持")
+                      << ", latency_timer " << (report.latency_timer_ms >= 0 ? std::to_string(report.latency_timer_ms) + "ms" : "无")
+                      << std::endl;
+            if (!report.warnings.empty()) {
+                std::cout << "        " << report.warnings << std::endl;
+            }
+        }
+        if (lost > 0) {
+            std::cerr << "❌ " << (low_latency ? "低延迟" : "默认") << "配置: " << lost << " 帧未读回" << std::endl;
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+void printUsage() {
+    std::cout << "用法: dart_bench <模式> [参数]" << std::endl;
+    std::cout << "  tapi [图像路径] [迭代次数]   CPU 与 OpenCL(T-API) 检测链对比" << std::endl;
+    std::cout << "  morph [图像路径] [迭代次数]  位压缩融合形态学 与 cv::morphologyEx 对比" << std::endl;
+    std::cout << "  pipeline <配置.yml> [图像路径] [迭代次数]  可配置流水线逐阶段计时" << std::endl;
+    std::cout << "  undistort [标定.yml|-] [图像路径] [迭代次数]  缓存校正查找表 与 cv::undistort 对比" << std::endl;
+    std::cout << "  ballistic [弹道参数.yaml|-] [迭代次数]  弹道查找表 与 迭代求解 对比" << std::endl;
+    std::cout << "  firingtable [弹道参数.yaml|-] [线程数]  二维射表生成、mmap 加载与精度" << std::endl;
+    std::cout << "  pid [对准配置.yml|-]  PID/前馈 与 5 档分档在仿真对象上的阶跃、斜坡响应" << std::endl;
+    std::cout << "  plant [仿真时长s]  AlignmentController 经串口字节驱动转台仿真的闭环测试" << std::endl;
+    std::cout << "  parser [帧数] [随机种子]  串口帧解析器的噪声/损坏性质测试与吞吐量" << std::endl;
+    std::cout << "  loopback [次数]  伪终端假下位机：各波特率指令往返时间（SerialPort/MotorController 端到端）" << std::endl;
+    std::cout << "  latency [设备|-] [波特率] [次数]  默认与低延迟串口配置下写出到 TX-RX 环回读回的延迟分位数" << std::endl;
+    std::cout << "  hotplug [次数]  伪终端模拟串口拔出/插入：自动重连耗时与重连后先停止" << std::endl;
+    std::cout << "  keepalive [时长s]  指令去重 + 保活的串口流量，以及停止提交指令后下位机看门狗停止电机" << std::endl;
+    std::cout << "  fakemcu [运行时长s]  在伪终端上运行假下位机，供主程序连接" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    try {
+        if (mode == "tapi") return benchTapi(argc, argv);
+        if (mode == "morph") return benchMorph(argc, argv);
+        if (mode == "pipeline") return benchPipeline(argc, argv);
+        if (mode == "undistort") return benchUndistort(argc, argv);
+        if (mode == "ballistic") return benchBallistic(argc, argv);
+        if (mode == "firingtable") return benchFiringTable(argc, argv);
+        if (mode == "pid") return benchPid(argc, argv);
+        if (mode == "plant") return benchPlant(argc, argv);
+        if (mode == "parser") return benchParser(argc, argv);
+        if (mode == "loopback") return benchLoopback(argc, argv);
+        if (mode == "latency") return benchLatency(argc, argv);
+        if (mode == "hotplug") return benchHotplug(argc, argv);
+        if (mode == "keepalive") return benchKeepalive(argc, argv);
+        if (mode == "fakemcu") return runFakeMcu(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "错误发生: " << e.what() << std::endl;
+        return 1;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -5,11 +5,19 @@
 #include <opencv2/highgui.hpp>
 #include <iostream>
 #include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
 // 🔧 新增：包含 CameraCalibrator 头文件
 #include "CameraCalibrator.h"
 #include "DetectionResult.h"
 #include "DistanceEstimator.h"
+#include "TargetTracker.h"
+#include "LatencyCompensator.h"
+#include "Undistorter.h"
+#include "BallisticSolver.h"
+#include "StereoRanger.h"
+#include <memory>
 
 using namespace sensor::camera;
 
@@ -85,11 +93,69 @@ int main() {
         // 创建海康摄像头实例
         HikCam camera(camInfo);
         
+        // 双目测距：DART_STEREO_CALIB 指定双目标定文件（K1 D1 K2 D2 R T）时打开第二台相机
+        StereoRanger stereo_ranger;
+        std::unique_ptr<HikCam> right_camera;
+        if (const char* env_stereo = std::getenv("DART_STEREO_CALIB")) {
+            if (stereo_ranger.loadCalibration(env_stereo)) {
+                CAM_INFO right_info = camInfo;
+                right_info.setCamID(1);
+                right_camera.reset(new HikCam(right_info));
+            }
+        }
+        
         // 创建各个模块实例
         VisionDetector vision_detector;
         AlignmentController alignment_controller;
         UserInterface ui;
         
+        // 设置环境变量 DART_USE_OPENCL=1 启用 OpenCL(T-API) 加速
+        if (const char* env_ocl = std::getenv("DART_USE_OPENCL")) {
+            vision_detector.setUseOpenCL(std::string(env_ocl) != "0");
+        }
+        // 设置环境变量 DART_PACKED_MORPH=1 启用位压缩形态学
+        if (const char* env_packed = std::getenv("DART_PACKED_MORPH")) {
+            vision_detector.setPackedMorphology(std::string(env_packed) != "0");
+        }
+        // 设置环境变量 DART_PIPELINE=<yml> 使用可配置检测流水线
+        if (const char* env_pipeline = std::getenv("DART_PIPELINE")) {
+            vision_detector.loadPipeline(env_pipeline);
+        }
+        // 加载参数搜索得到的检测阈值（DART_VISION_PARAMS 可指定其他文件）
+        {
+            const char* env_params = std::getenv("DART_VISION_PARAMS");
+            std::string params_file = env_params ? env_params : "vision_params.yml";
+            if (std::ifstream(params_file).good()) {
+                vision_detector.loadParameters(params_file);
+            }
+        }
+        // 右相机使用独立的检测器：保存帧 / 掩码显示仍对应左相机
+        VisionDetector right_detector;
+        if (right_camera) {
+            right_detector.setRenderResults(false);
+            if (const char* env_pipeline = std::getenv("DART_PIPELINE")) {
+                right_detector.loadPipeline(env_pipeline);
+            }
+        }
+        
+        // 目标跟踪器：平滑检测抖动，短暂丢检时按速度外推（DART_TRACKER=0 关闭）
+        TargetTracker target_tracker;
+        bool use_tracker = true;
+        if (const char* env_tracker = std::getenv("DART_TRACKER")) {
+            use_tracker = std::string(env_tracker) != "0";
+        }
+        bool stop_sent = false;
+        
+        // 延迟补偿：把瞄准点外推到指令预计生效的时刻（DART_LATENCY_CONFIG 指定配置文件）
+        LatencyCompensator latency_compensator;
+        {
+            const char* env_latency = std::getenv("DART_LATENCY_CONFIG");
+            std::string latency_file = env_latency ? env_latency : "config/latency.yml";
+            if (std::ifstream(latency_file).good()) {
+                latency_compensator.loadConfig(latency_file);
+            }
+        }
+        
         // 创建距离估算器
         DistanceEstimator distance_estimator;
         
@@ -99,18 +165,52 @@ int main() {
         // 焦距可以通过相机标定获得，或者先使用估计值
         float estimated_focal_length = 4968.4f;  // 这个值需要根据您的相机进行标定
         
-        // 如果存在标定文件，可以从文件加载
-        cv::FileStorage fs("camera_params.yml", cv::FileStorage::READ);
-        if (fs.isOpened()) {
-            cv::Mat camera_matrix;
-            fs["camera_matrix"] >> camera_matrix;
-            if (!camera_matrix.empty()) {
-                estimated_focal_length = (camera_matrix.at<double>(0, 0) + camera_matrix.at<double>(1, 1)) / 2.0f;
+        distance_estimator.setCameraParameters(estimated_focal_length, REAL_TARGET_DIAMETER);
+        
+        // 如果存在标定文件，使用完整内参（主点 + 畸变）计算距离、三维位置和方位角
+        if (CameraCalibrator::fileExists("camera_params.yml") &&
+            distance_estimator.loadCalibration("camera_params.yml")) {
+            estimated_focal_length = distance_estimator.getFocalLength();
+        }
+        // 对准控制：有标定时在角度空间计算误差和速度分档（DART_ALIGN_MODE=pixel 退回像素分档）
+        if (CameraCalibrator::fileExists("camera_params.yml")) {
+            alignment_controller.loadCalibration("camera_params.yml");
+        }
+        {
+            const char* env_align_config = std::getenv("DART_ALIGNMENT_CONFIG");
+            std::string align_file = env_align_config ? env_align_config : "config/alignment.yml";
+            if (std::ifstream(align_file).good()) {
+                alignment_controller.loadAngleConfig(align_file);
+            }
+            const char* env_hit_model = std::getenv("DART_HIT_MODEL");
+            std::string hit_model_file = env_hit_model ? env_hit_model : "config/hit_model.yml";
+            if (std::ifstream(hit_model_file).good()) {
+                alignment_controller.loadHitModel(hit_model_file);
+            }
+            if (const char* env_align_mode = std::getenv("DART_ALIGN_MODE")) {
+                alignment_controller.setAngleMode(std::string(env_align_mode) != "pixel");
             }
-            fs.release();
+            // alignment.yml 中的 roi_offset / binning 同样用于单目 / 双目测距和去畸变查找表
+            distance_estimator.setSensorMode(alignment_controller.getSensorMode());
+            stereo_ranger.setSensorMode(alignment_controller.getSensorMode());
         }
+        // 检测点去畸变查找表：首帧确定分辨率后生成，缓存到磁盘供下次启动 mmap
+        Undistorter undistorter;
+        const char* env_undistort_cache = std::getenv("DART_UNDISTORT_CACHE");
+        const std::string undistort_cache = env_undistort_cache ? env_undistort_cache : "camera_params.undistort.bin";
         
-        distance_estimator.setCameraParameters(estimated_focal_length, REAL_TARGET_DIAMETER);
+        // 弹道解算：启动时映射 距离 x 高度 射表缓存，参数变化时多线程重新生成
+        // （DART_BALLISTIC_PARAMS 指定参数文件，DART_FIRING_TABLE_CACHE 指定缓存文件）
+        BallisticSolver ballistic_solver;
+        {
+            const char* env_ballistic = std::getenv("DART_BALLISTIC_PARAMS");
+            std::string ballistic_file = env_ballistic ? env_ballistic : "config/ballistic_params.yaml";
+            if (std::ifstream(ballistic_file).good()) {
+                ballistic_solver.loadParams(ballistic_file);
+            }
+            const char* env_firing_table = std::getenv("DART_FIRING_TABLE_CACHE");
+            ballistic_solver.loadFiringTable(env_firing_table ? env_firing_table : "camera_params.firing_table.bin");
+        }
         
         std::cout << "距离估算器已初始化：" << std::endl;
         std::cout << "- 真实直径: " << REAL_TARGET_DIAMETER * 1000 << "mm" << std::endl;
@@ -119,8 +219,60 @@ int main() {
         // 初始化UI窗口
         ui.initWindows();
         
-        // 连接电机控制器
-        alignment_controller.connectMotorController();
+        // 串口协议：默认 v1 兼容旧固件；DART_SERIAL_PROTOCOL=2 启用 ACK 与转台遥测
+        if (const char* env_protocol = std::getenv("DART_SERIAL_PROTOCOL")) {
+            alignment_controller.setSerialProtocol(std::atoi(env_protocol));
+        }
+        
+        // 串口波特率：DART_SERIAL_BAUD（如 1000000、2000000，非标准值经 termios2 设置）
+        if (const char* env_baud = std::getenv("DART_SERIAL_BAUD")) {
+            alignment_controller.setSerialBaudRate(std::atoi(env_baud));
+        }
+        // DART_SERIAL_LOW_LATENCY=1 启用 ASYNC_LOW_LATENCY 与 1ms USB latency_timer；值大于 1 时同时作为收发线程的 SCHED_FIFO 优先级
+        if (const char* env_low_latency = std::getenv("DART_SERIAL_LOW_LATENCY")) {
+            int value = std::atoi(env_low_latency);
+            if (value > 0) {
+                SerialLatencyProfile profile;
+                profile.low_latency = true;
+                profile.rt_priority = value > 1 ? value : 0;
+                alignment_controller.setSerialLatencyProfile(profile);
+            }
+        }
+        
+        // 指令调度：指令不变时只按保活周期重发（DART_KEEPALIVE_MS，默认 100，0 只在变化时发送），
+        // 协议 v2 下位机看门狗 DART_MCU_WATCHDOG_MS（默认 300，0 关闭）；DART_SERIAL_TRACE=1 打印写出的帧
+        const char* env_keepalive = std::getenv("DART_KEEPALIVE_MS");
+        const char* env_watchdog = std::getenv("DART_MCU_WATCHDOG_MS");
+        if (env_keepalive || env_watchdog) {
+            CommandSchedule schedule;
+            if (env_keepalive) schedule.keepalive_ms = std::atof(env_keepalive);
+            if (env_watchdog) schedule.mcu_watchdog_ms = std::atoi(env_watchdog);
+            alignment_controller.setCommandSchedule(schedule);
+        }
+        if (const char* env_trace = std::getenv("DART_SERIAL_TRACE")) {
+            alignment_controller.setSerialFrameLogging(std::atoi(env_trace) != 0);
+        }
+        
+        // 串口拔出或 USB 复位后默认在后台自动重连，DART_SERIAL_RECONNECT=0 关闭
+        if (const char* env_reconnect = std::getenv("DART_SERIAL_RECONNECT")) {
+            alignment_controller.setSerialAutoReconnect(std::atoi(env_reconnect) != 0);
+        }
+        
+        // 连接电机控制器：DART_SERIAL_PORT 指定设备（例如 dart_bench fakemcu 给出的伪终端），否则依次探测常见设备
+        if (const char* env_port = std::getenv("DART_SERIAL_PORT")) {
+            alignment_controller.setSerialPort(env_port);
+        } else {
+            alignment_controller.connectMotorController();
+        }
+        
+        // 固定频率控制线程（默认 200Hz），DART_CONTROL_RATE=0 时退回每帧对准一次
+        double control_rate_hz = 200.0;
+        if (const char* env_rate = std::getenv("DART_CONTROL_RATE")) {
+            control_rate_hz = std::atof(env_rate);
+        }
+        if (control_rate_hz > 0) {
+            alignment_controller.startControlThread(control_rate_hz);
+        }
 
         // 不要调用不存在的方法
         // alignment_controller.loadDistanceSettingFromEnvironment();
@@ -150,8 +302,21 @@ int main() {
         while (true) {
             // 捕获图像
             cv::Mat frame = camera.Grab();
+            // 两台相机未硬件同步：右图紧接左图采集，减小目标运动带来的视差误差
+            cv::Mat right_frame = right_camera ? right_camera->Grab() : cv::Mat();
+            // 帧时间戳取曝光中点
+            double frame_time_ms = latency_compensator.captureTime(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
             
             if (!frame.empty()) {
+                stereo_ranger.setFrameSize(frame.size());
+                if (distance_estimator.setFrameSize(frame.size())) {
+                    if (undistorter.init(distance_estimator.getCameraMatrix(), distance_estimator.getDistCoeffs(),
+                                         frame.size(), undistort_cache)) {
+                        distance_estimator.setUndistorter(&undistorter);
+                    }
+                }
+                
                 auto start_time = std::chrono::high_resolution_clock::now();
                 
                 // 使用新的检测方法获取完整结果
@@ -162,6 +327,17 @@ int main() {
                 if (!detection_results.empty()) {
                     distance_estimator.estimateDistances(detection_results);
                     
+                    // 双目模式：右相机检测结果与左图做极线匹配，三角化距离覆盖单目结果
+                    if (right_camera) {
+                        std::vector<DetectionResult> right_results;
+                        if (!right_frame.empty()) {
+                            right_detector.copySettingsFrom(vision_detector);
+                            right_detector.detectGreenCirclesWithResults(right_frame, right_results);
+                        }
+                        int matched = stereo_ranger.estimate(detection_results, right_results);
+                        std::cout << "双目匹配: " << matched << "/" << detection_results.size() << std::endl;
+                    }
+                    
                     // 打印调试信息
                     for (size_t i = 0; i < detection_results.size(); ++i) {
                         const auto& res = detection_results[i];
@@ -171,27 +347,131 @@ int main() {
                         std::cout << "目标 #" << i << ": "
                                   << "像素直径: " << res.pixel_diameter << "px, "
                                   << "圆度: " << res.confidence << ", "
-                                  << "距离: " << distance_str
-                                  << std::endl;
+                                  << "距离: " << distance_str;
+                        if (res.has_position) {
+                            std::cout << ", 方位: " << res.yaw * 180.0 / CV_PI << "°"
+                                      << ", 俯仰: " << res.pitch * 180.0 / CV_PI << "°";
+                        }
+                        std::cout << std::endl;
                     }
                 }
 
                 auto end_time = std::chrono::high_resolution_clock::now();
                 auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
                 double processing_time_ms = duration.count() / 1000.0;
+                latency_compensator.recordProcessing(processing_time_ms);
 
                 // 自动对准已启用时：
                 // - 若检测到圆形则执行对准
                 // - 若未检测到圆形则立即停止电机（实现选项 C）
-                if (alignment_controller.isAutoAlignEnabled()) {
-                    if (!detection_results.empty()) {
-                        // 使用最佳检测结果进行对准
-                        auto& best_result = detection_results[0];
-                        cv::Point2f center(best_result.circle[0], best_result.circle[1]);
-                        alignment_controller.performAlignment(center, frame.cols);
-                    } else {
-                        // 目标丢失：立即停止电机，防止继续维持最后速度
+                // 本帧的命中概率输入：关联到检测且距离、射击诸元有效时才给出
+                HitInputs hit_inputs;
+                bool has_hit_inputs = false;
+                if (use_tracker) {
+                    target_tracker.update(detection_results, frame_time_ms);
+                    // 按轨迹做距离时域融合，替换关联检测的单帧距离
+                    int associated = target_tracker.getAssociatedIndex();
+                    if (associated >= 0) {
+                        DetectionResult& tracked = detection_results[associated];
+                        // 双目三角化的距离带单帧方差，按其方差融合；单目按像素噪声
+                        RangeEstimate range = (distance_estimator.hasIntrinsics() || tracked.distance_variance > 0)
+                            ? distance_estimator.updateTrackRange(target_tracker.getTrackId(), tracked.distance,
+                                                                  frame_time_ms, tracked.distance_variance)
+                            : distance_estimator.updateTrack(target_tracker.getTrackId(), tracked.pixel_diameter, frame_time_ms);
+                        if (tracked.has_position && tracked.distance > 0 && range.range > 0) {
+                            // 三维位置沿视线方向按融合距离缩放
+                            tracked.position *= range.range / tracked.distance;
+                        }
+                        tracked.distance = range.range;
+                        tracked.distance_variance = range.variance;
+                        tracked.has_distance = range.valid;
+                        if (range.valid) {
+                            std::cout << "融合距离 (轨迹 " << range.track_id << "): " << range.range
+                                      << "m ± " << std::sqrt(range.variance) << "m" << std::endl;
+                        }
+                        if (tracked.has_position && range.valid) {
+                            FiringSolution firing = ballistic_solver.solve(tracked.position);
+                            if (firing.valid) {
+                                std::cout << "射击诸元: 仰角 " << firing.pitch * 180.0 / CV_PI << "°, 方位 "
+                                          << firing.yaw * 180.0 / CV_PI << "°, 飞行时间 "
+                                          << firing.flight_time << "s" << std::endl;
+                                hit_inputs.range = range.range;
+                                hit_inputs.range_variance = range.variance;
+                                hit_inputs.target_velocity_px = target_tracker.getVelocity();
+                                hit_inputs.flight_time = firing.flight_time;
+                                hit_inputs.impact_slope = ballistic_solver.impactSlope(firing);
+                                has_hit_inputs = true;
+                            } else {
+                                std::cout << "射击诸元: 目标超出射程 (" << firing.horizontal_range << "m)" << std::endl;
+                            }
+                        }
+                    }
+                }
+                bool has_target = use_tracker ? target_tracker.hasTrack() : !detection_results.empty();
+                if (alignment_controller.isControlThreadRunning()) {
+                    // 控制线程以固定频率外推并下发指令，这里只投递最新的目标估计
+                    double publish_time_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+                    TargetSnapshot snapshot;
+                    snapshot.valid = has_target;
+                    snapshot.frame_size = frame.size();
+                    if (has_target) {
+                        if (use_tracker) {
+                            snapshot.center = target_tracker.getCenter();
+                            snapshot.velocity = target_tracker.getVelocity();
+                            snapshot.state_time_ms = target_tracker.getLastUpdateTime();
+                            snapshot.last_detection_ms = target_tracker.getLastDetectionTime();
+                        } else {
+                            auto& best_result = detection_results[0];
+                            snapshot.center = cv::Point2f(best_result.circle[0], best_result.circle[1]);
+                            snapshot.state_time_ms = frame_time_ms;
+                            snapshot.last_detection_ms = frame_time_ms;
+                        }
+                        snapshot.stale_after_ms = snapshot.last_detection_ms + target_tracker.getMaxCoastTime();
+                        snapshot.horizon_end_ms = snapshot.stale_after_ms;
+                        if (latency_compensator.isEnabled()) {
+                            snapshot.actuation_delay_ms = latency_compensator.actuationTime(publish_time_ms) - publish_time_ms;
+                            snapshot.horizon_end_ms = std::min(snapshot.horizon_end_ms,
+                                snapshot.last_detection_ms + latency_compensator.getConfig().max_horizon_ms);
+                        }
+                        latency_compensator.recordFrame(frame_time_ms, publish_time_ms);
+                        if (use_tracker && has_hit_inputs) {
+                            hit_inputs.target_cov_px = target_tracker.predictCovariance(
+                                latency_compensator.actuationTime(publish_time_ms) + hit_inputs.flight_time * 1000.0);
+                            snapshot.hit_inputs = hit_inputs;
+                            snapshot.has_hit_inputs = true;
+                        }
+                    }
+                    alignment_controller.publishTarget(snapshot);
+                    latency_compensator.recordSerialWrite(alignment_controller.getLastCommandLatencyMs());
+                } else if (alignment_controller.isAutoAlignEnabled()) {
+                    if (has_target) {
+                        cv::Point2f center;
+                        if (use_tracker) {
+                            // 使用跟踪器外推到指令预计生效时刻的预测中心
+                            double command_time_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now().time_since_epoch()).count();
+                            center = latency_compensator.predictAimPoint(target_tracker, command_time_ms);
+                            latency_compensator.recordFrame(frame_time_ms, command_time_ms);
+                            if (has_hit_inputs) {
+                                // 目标位置不确定度外推到飞镖到达时刻：指令生效 + 飞行时间
+                                hit_inputs.target_cov_px = target_tracker.predictCovariance(
+                                    latency_compensator.actuationTime(command_time_ms) + hit_inputs.flight_time * 1000.0);
+                                alignment_controller.setHitContext(hit_inputs);
+                            }
+                        } else {
+                            // 使用最佳检测结果进行对准
+                            auto& best_result = detection_results[0];
+                            center = cv::Point2f(best_result.circle[0], best_result.circle[1]);
+                        }
+                        alignment_controller.setTargetVelocity(use_tracker ? target_tracker.getVelocity() : cv::Point2f());
+                        alignment_controller.performAlignment(center, frame.size());
+                        latency_compensator.recordSerialWrite(alignment_controller.getLastCommandLatencyMs());
+                        stop_sent = false;
+                    } else if (!stop_sent) {
+                        // 目标丢失（跟踪器外推超时）：停止电机，只发送一次
                         alignment_controller.stop();
+                        stop_sent = true;
                         std::cout << "警告: 目标丢失，已发送停止命令到电机。" << std::endl;
                     }
                 }
@@ -228,6 +508,11 @@ int main() {
         std::cout << "总帧数: " << frame_count << std::endl;
         std::cout << "总时间: " << total_duration << "ms" << std::endl;
         std::cout << "平均FPS: " << avg_fps << std::endl;
+        latency_compensator.printStats();
+        alignment_controller.stopControlThread();
+        if (vision_detector.hasPipeline()) {
+            vision_detector.getPipeline()->printTimings();
+        }
         
         // 关闭窗口
         ui.closeWindows();